@@ -136,7 +136,7 @@ class CArray : public CQuickSort < DATA_T > {
 		// ----------------------------------------
 
 		void Init (void) { 
-			m_info.buffer = reinterpret_cast<DATA_T *> (nullptr); 
+			m_info.buffer = nullptr; 
 			m_info.length = 0;
 			m_info.pos = 0;
 			m_info.mode = 0;
@@ -338,8 +338,7 @@ class CArray : public CQuickSort < DATA_T > {
 			m_info.pos = source.m_info.pos;
 			m_info.mode = source.m_info.mode;
 			m_info.wrap = source.m_info.wrap;
-			source.m_info.buffer = nullptr;
-			source.Destroy ();
+			source.Init ();	// leave the source empty: copying it must not read through its former length
 			return *this;
 		}
 
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+//-----------------------------------------------------------------------------
+// open addressing hash map (linear probing) for integral keys
+
+template < class KEY_T, class DATA_T >
+class CHashMap {
+	protected:
+		class CEntry {
+			public:
+				KEY_T	key;
+				DATA_T	data;
+				bool	used;
+
+				CEntry () : used (false) {}
+			};
+
+		CEntry*	m_entries;
+		size_t	m_mask;
+		size_t	m_length;
+
+		static inline size_t Hash (KEY_T key) {
+			uint64_t h = uint64_t (key);
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdULL;
+			h ^= h >> 33;
+			return size_t (h);
+			}
+
+		inline size_t Slot (KEY_T key) {
+			size_t i = Hash (key) & m_mask;
+			while (m_entries [i].used && (m_entries [i].key != key))
+				i = (i + 1) & m_mask;
+			return i;
+			}
+
+		void Rehash (size_t capacity) {
+			CEntry* entries = m_entries;
+			size_t oldCapacity = m_entries ? m_mask + 1 : 0;
+			m_entries = new CEntry [capacity];
+			m_mask = capacity - 1;
+			m_length = 0;
+			for (size_t i = 0; i < oldCapacity; i++)
+				if (entries [i].used)
+					Insert (entries [i].key, entries [i].data);
+			delete[] entries;
+			}
+
+	public:
+		CHashMap (size_t capacity = 64) : m_entries (nullptr), m_mask (0), m_length (0) { Create (capacity); }
+
+		~CHashMap () { Destroy (); }
+
+		CHashMap (CHashMap const&) = delete;
+
+		CHashMap& operator= (CHashMap const&) = delete;
+
+		// capacity is rounded up to the next power of two
+		void Create (size_t capacity) {
+			Destroy ();
+			size_t c = 8;
+			while (c < capacity)
+				c <<= 1;
+			Rehash (c);
+			}
+
+		void Destroy (void) {
+			if (m_entries) {
+				delete[] m_entries;
+				m_entries = nullptr;
+				}
+			m_mask = 0;
+			m_length = 0;
+			}
+
+		void Clear (void) {
+			for (size_t i = 0; i <= m_mask; i++)
+				m_entries [i].used = false;
+			m_length = 0;
+			}
+
+		inline size_t Length (void) { return m_length; }
+
+		// insert or replace
+		void Insert (KEY_T key, DATA_T data) {
+			if ((m_length + 1) * 4 > (m_mask + 1) * 3)	// keep the load factor below 0.75
+				Rehash ((m_mask + 1) * 2);
+			size_t i = Slot (key);
+			if (!m_entries [i].used) {
+				m_entries [i].used = true;
+				m_entries [i].key = key;
+				m_length++;
+				}
+			m_entries [i].data = data;
+			}
+
+		inline DATA_T* Find (KEY_T key) {
+			size_t i = Slot (key);
+			return m_entries [i].used ? &m_entries [i].data : nullptr;
+			}
+
+		bool Remove (KEY_T key) {
+			size_t i = Slot (key);
+			if (!m_entries [i].used)
+				return false;
+			// shift following entries of the probe sequence back so that lookups don't need tombstones
+			for (size_t j = (i + 1) & m_mask; m_entries [j].used; j = (j + 1) & m_mask) {
+				size_t k = Hash (m_entries [j].key) & m_mask;
+				if (((j - k) & m_mask) >= ((j - i) & m_mask)) {
+					m_entries [i] = m_entries [j];
+					i = j;
+					}
+				}
+			m_entries [i].used = false;
+			m_length--;
+			return true;
+			}
+	};
+
+//-----------------------------------------------------------------------------
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+// bounded lock free ring buffer for exactly one producer and one consumer thread.
+// All slots are allocated up front and reused; the consumer processes elements in place
+// (Peek/Release). Elements pushed into a full buffer are dropped and counted.
+
+template < class DATA_T >
+class CRingBuffer {
+	protected:
+		DATA_T*	m_slots;
+		size_t	m_mask;
+		alignas (64) std::atomic<size_t>	m_head;		// next slot to be written (producer)
+		alignas (64) std::atomic<size_t>	m_tail;		// next slot to be read (consumer)
+		alignas (64) std::atomic<size_t>	m_overflows;	// number of elements dropped because the buffer was full
+		std::atomic<size_t>	m_highWater;	// max. number of elements ever queued
+
+	public:
+		CRingBuffer () : m_slots (nullptr), m_mask (0), m_head (0), m_tail (0), m_overflows (0), m_highWater (0) {}
+
+		CRingBuffer (size_t length) : CRingBuffer () { Create (length); }
+
+		~CRingBuffer () { Destroy (); }
+
+		CRingBuffer (CRingBuffer const&) = delete;
+
+		CRingBuffer& operator= (CRingBuffer const&) = delete;
+
+		// length is rounded up to the next power of two. Not thread safe.
+		bool Create (size_t length) {
+			Destroy ();
+			size_t capacity = 1;
+			while (capacity < length)
+				capacity <<= 1;
+			m_slots = new DATA_T [capacity];
+			m_mask = capacity - 1;
+			return true;
+			}
+
+		void Destroy (void) {
+			if (m_slots) {
+				delete[] m_slots;
+				m_slots = nullptr;
+				}
+			m_mask = 0;
+			m_head = m_tail = 0;
+			}
+
+		inline size_t Capacity (void) { return m_slots ? m_mask + 1 : 0; }
+
+		inline size_t Length (void) { return m_head.load (std::memory_order_acquire) - m_tail.load (std::memory_order_acquire); }
+
+		inline bool Empty (void) { return Length () == 0; }
+
+		inline size_t Overflows (void) { return m_overflows.load (std::memory_order_relaxed); }
+
+		inline size_t HighWater (void) { return m_highWater.load (std::memory_order_relaxed); }
+
+		// producer side ----------------------------------------
+
+		// return the next free slot or nullptr if the buffer is full.
+		// The element only becomes visible to the consumer with Commit ().
+		inline DATA_T* Reserve (void) {
+			size_t head = m_head.load (std::memory_order_relaxed);
+			if (!m_slots || (head - m_tail.load (std::memory_order_acquire) > m_mask))
+				return nullptr;
+			return m_slots + (head & m_mask);
+			}
+
+		inline void Commit (void) {
+			size_t head = m_head.load (std::memory_order_relaxed) + 1;
+			m_head.store (head, std::memory_order_release);
+			size_t length = head - m_tail.load (std::memory_order_relaxed);
+			if (length > m_highWater.load (std::memory_order_relaxed))
+				m_highWater.store (length, std::memory_order_relaxed);
+			}
+
+		inline bool Push (DATA_T&& elem) {
+			DATA_T* slot = Reserve ();
+			if (!slot) {
+				m_overflows.fetch_add (1, std::memory_order_relaxed);
+				return false;
+				}
+			*slot = std::move (elem);
+			Commit ();
+			return true;
+			}
+
+		inline bool Push (DATA_T const& elem) {
+			DATA_T* slot = Reserve ();
+			if (!slot) {
+				m_overflows.fetch_add (1, std::memory_order_relaxed);
+				return false;
+				}
+			*slot = elem;
+			Commit ();
+			return true;
+			}
+
+		// consumer side ----------------------------------------
+
+		// return the oldest element or nullptr if the buffer is empty. The slot stays owned by the consumer until Release ().
+		inline DATA_T* Peek (void) {
+			size_t tail = m_tail.load (std::memory_order_relaxed);
+			if (tail == m_head.load (std::memory_order_acquire))
+				return nullptr;
+			return m_slots + (tail & m_mask);
+			}
+
+		inline void Release (void) {
+			m_tail.store (m_tail.load (std::memory_order_relaxed) + 1, std::memory_order_release);
+			}
+
+		inline bool Pop (DATA_T& elem) {
+			DATA_T* slot = Peek ();
+			if (!slot)
+				return false;
+			elem = std::move (*slot);
+			Release ();
+			return true;
+			}
+	};
+
+//-----------------------------------------------------------------------------
@@ -45,6 +45,7 @@ class CString : public CArray < char > {
 		{
 			m_length = other.Length ();
 			Move (other);
+			other.m_length = 0;
 		}
 
 		//----------------------------------------
@@ -96,6 +97,7 @@ class CString : public CArray < char > {
 		CString& operator=(CString&& other) noexcept {
 			m_length = other.Length ();
 			Move (other);
+			other.m_length = 0;
 			return *this;
 		}
 
@@ -132,6 +134,21 @@ class CString : public CArray < char > {
 		}
 
 
+		//----------------------------------------
+
+		// copy l characters, reusing the buffer if it is large enough
+		CString& Assign (const char* s, size_t l) {
+			if (l + 1 > m_info.Length ()) {
+				Resize (l + 1, false);
+				if (l + 1 > m_info.Length ())
+					return *this;
+				}
+			memcpy (Buffer (), s, l);
+			Buffer () [l] = '\0';
+			m_length = l;
+			return *this;
+			}
+
 		//----------------------------------------
 
 		CString operator= (const size_t n) {
@@ -165,7 +182,7 @@ class CString : public CArray < char > {
 
 		explicit operator uint16_t() {
 			uint16_t i;
-			sscanf_s(Buffer(), "%hu", &i);
+			sscanf(Buffer(), "%hu", &i);
 			return i;
 		}
 
@@ -173,7 +190,7 @@ class CString : public CArray < char > {
 
 		explicit operator int() {
 			int i;
-			sscanf_s(Buffer(), "%d", &i);
+			sscanf(Buffer(), "%d", &i);
 			return i;
 		}
 
@@ -181,7 +198,7 @@ class CString : public CArray < char > {
 
 		explicit operator size_t() {
 			size_t i;
-			sscanf_s(Buffer(), "%lld", &i);
+			sscanf(Buffer(), "%zu", &i);
 			return i;
 		}
 
@@ -189,7 +206,7 @@ class CString : public CArray < char > {
 
 		explicit operator float() {
 			float i;
-			sscanf_s(Buffer(), "%f", &i);
+			sscanf(Buffer(), "%f", &i);
 			return i;
 		}
 
@@ -197,7 +214,7 @@ class CString : public CArray < char > {
 
 		explicit operator bool() {
 			int i;
-			sscanf_s(Buffer(), "%d", &i);
+			sscanf(Buffer(), "%d", &i);
 			return bool(i);
 		}
 
@@ -266,19 +283,27 @@ class CString : public CArray < char > {
 		//----------------------------------------
 
 		CString operator+ (const CString& other) {
-			size_t l = Length () + other.Length ();
-			CString s (Buffer (), int (l));
-			memcpy(s.Buffer() + Length(), other.Buffer(), other.Length() + 1);
-			return s;
+			return Concat (other.Buffer (), other.Length ());
 			}
 
 		//----------------------------------------
 
 		CString operator+ (const char* other) {
-			size_t ol = strlen(other);
-			size_t l = Length() + ol;
-			CString s(Buffer(), int(l));
-			memcpy(s.Buffer() + Length(), other, ol + 1);
+			return Concat (other, strlen (other));
+		}
+
+		//----------------------------------------
+
+		// only the characters of this string are copied from its buffer (it may be shorter than the result)
+		CString Concat (const char* other, size_t ol) {
+			CString s;
+			s.Create (Length () + ol + 1);
+			if (Length ())
+				memcpy (s.Buffer (), Buffer (), Length ());
+			if (ol)
+				memcpy (s.Buffer () + Length (), other, ol);
+			s.m_length = Length () + ol;
+			s.Buffer () [s.m_length] = '\0';
 			return s;
 		}
 
@@ -382,8 +407,10 @@ class CString : public CArray < char > {
 
 		//----------------------------------------
 
+		// CAvlTree needs -1, 0 or 1. Only MSVC's strcmp restricts itself to these values
 		static int Compare(const CString& s1, const CString& s2) {
-			return strcmp(s1.Buffer(), s2.Buffer());
+			int i = strcmp(s1.Buffer(), s2.Buffer());
+			return (i < 0) ? -1 : (i > 0) ? 1 : 0;
 		}
 
 		//----------------------------------------
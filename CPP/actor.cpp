@@ -1,9 +1,11 @@
 #include "actor.h"
-#include "gameData.h"
-#include "gameItems.h"
-#include "networkHandler.h"
-#include "effectHandler.h"
-#include "soundHandler.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#include "networkhandler.h"
+#ifndef HEADLESS
+#   include "effecthandler.h"
+#   include "soundhandler.h"
+#endif
 
 // =================================================================================================
 // Basic game object with physical properties. Can be mobile or stationary, but basically is everything 
@@ -12,6 +14,8 @@
 // Contains basic handling of collisions with other actors or the map
 
 CActor::CActor(CString type, int hitPoints, bool isViewer) {
+    m_id = 0;   // players have id zero, projectiles set theirs (see CProjectile)
+    m_updateSequence = 0;
     m_stationary = false;
     m_isViewer = isViewer;
     m_type = type;
@@ -60,16 +64,20 @@ void CActor::Destroy(void) {
 
 bool CActor::SetupTextures (CTexture * texture, CList<CString> textureNames) {
     m_texture = texture;
+#ifndef HEADLESS
     if (!textureNames.Empty())
         m_texture->CreateFromFile(textureNames);
+#endif
     return true;
     }
 
 
 void CActor::SetupMesh (CMesh * mesh, int quality, CTexture * texture, CList<CString>& textureNames) {
     m_mesh = mesh;
+#ifndef HEADLESS
     if (quality > 0) 
         m_mesh->Create(quality, texture, textureNames);
+#endif
     }
 
 
@@ -90,7 +98,17 @@ void CActor::SetPosition (CVector position) {
     }
 
 
+void CActor::Interpolate(uint32_t time) {
+    CVector position, angles;
+    if (m_states.Sample(time, position, angles)) {
+        SetPosition(position);
+        SetOrientation(angles);
+    }
+}
+
+
 void CActor::Render(bool autoCamera) {
+#ifndef HEADLESS
     if (m_isViewer)
         return;
     if (autoCamera)
@@ -111,6 +129,7 @@ void CActor::Render(bool autoCamera) {
     glPopMatrix();
     if (autoCamera)
         DisableCamera();
+#endif
 }
 
 
@@ -173,8 +192,10 @@ void CActor::SetHitPoints (int hitPoints, CActor* hitter) {
 // and transmits his current status to the other players with UPDATE messages
 void CActor::Die(void) {
     SetAnimation(1);
+#ifndef HEADLESS
     if (this == actorHandler->m_viewer) 
         effectHandler->StartFade(CVector(0, 0, 0), m_animationDuration, false);
+#endif
     m_deathTime = m_hitTime;   // start death animation
     m_lifeState = lsDisappear;
 }
@@ -215,8 +236,10 @@ void CActor::Resurrect(void) {
     if (m_needPosition)     // don't respawn without a valid spawn position
         return;
     m_respawnTime = gameData->m_gameTime + m_animationDuration;
+#ifndef HEADLESS
     if (this == actorHandler->m_viewer)
         effectHandler->StartFade(CVector(0, 0, 0), m_animationDuration, true);
+#endif
     m_lifeState = lsReappear;
 }
 
@@ -267,8 +290,9 @@ void CActor::ForceRespawn(void) {
 bool CActor::IsLocalActor(void) {
     if (networkHandler->m_localAddress == "127.0.0.1")
         return true;
+    // several instances (e.g. bots, see CBot) may share an address, so the port must match, too
     return (GetColorIndex() == actorHandler->m_viewer->GetColorIndex ()) ||
-           (GetAddress() == networkHandler->m_localAddress) ||
+           ((GetAddress() == networkHandler->m_localAddress) && (GetPort() == networkHandler->m_localPorts[0])) ||
            (GetAddress() == "127.0.0.1");
 }
 
@@ -296,6 +320,7 @@ void CActor::Heal(void) {
 
 void CActor::UpdateSound(void) {
     // global soundHandler
+#ifndef HEADLESS
     if (m_id != 0)
         return;
     if (IsAlive() || IsImmune()) {
@@ -308,6 +333,7 @@ void CActor::UpdateSound(void) {
             m_soundId = -1;
         }
     }
+#endif
 }
 
 
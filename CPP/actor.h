@@ -1,9 +1,15 @@
 #pragma once
 
-#include "texture.h"
-#include "cubemap.h"
-#include "mesh.h"
+#ifndef HEADLESS
+#   include "texture.h"
+#   include "cubemap.h"
+#   include "mesh.h"
+#else   // the dedicated server's actors have neither textures nor meshes
+class CTexture;
+class CMesh;
+#endif
 #include "camera.h"
+#include "interpolationbuffer.h"
 
 // =================================================================================================
 // Basic game object with physical properties. Can be mobile or stationary, but basically is everything 
@@ -31,6 +37,8 @@ class CActor {
         CTexture *          m_texture;
         CMesh *             m_mesh;
         CCamera             m_camera;
+        CInterpolationBuffer    m_states;   // states received for a remote actor
+        uint16_t            m_updateSequence;   // sequence number of the last update applied to a remote actor (0: none, see CNetworkHandler::HandleUpdate)
         CList<CTexture*>    m_textures;
         bool                m_stationary;
         bool                m_isViewer;
@@ -62,6 +70,9 @@ class CActor {
 
         CActor(CString type = CString(""), int hitPoints = 1, bool isViewer = false);
 
+        // players && projectiles are deleted through CActor pointers (see CActorHandler::Cleanup)
+        virtual ~CActor() {}
+
     // set a mesh (shape), texture, position and initial spatial orientation of the actor
         void Create(CString name, CMesh * mesh, int quality, CTexture* texture, CList<CString> textureNames, CVector position, CVector angles, float size, CCamera* parent = nullptr);
 
@@ -157,6 +168,10 @@ class CActor {
         inline void SetOrientation(CVector angles) {
                 m_camera.SetOrientation(angles);
             }
+
+
+        // move a remote actor to where it was at the given time, according to the states received for it
+        void Interpolate(uint32_t time);
         
 
         inline CString GetName(void) {
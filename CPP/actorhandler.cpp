@@ -1,12 +1,13 @@
 #pragma once
 
-#include "gameItems.h"
-#include "actorHandler.h"
+#include "gameitems.h"
+#include "actorhandler.h"
 
 // =================================================================================================
 
 CActorHandler::CActorHandler() {
     m_viewer = nullptr;
+#ifndef HEADLESS
     // two sphere meshes which will be used where ever a sphere is needed. Sphere texturing && sizing is dynamic to allow for reuse.
     m_playerSphere.Create(4);
     m_projectileSphere.Create(3);
@@ -14,8 +15,10 @@ CActorHandler::CActorHandler() {
     m_playerShadow.Create();
     m_playerHalo.Create(5, 0.2f, 0.02f);
     m_playerOutline.Create(&m_playerSphere);
-    m_maxPlayers = gameData->m_playerColors.Length();
+#endif
     m_actorId = 0;
+    m_actorIndex.Create(256);
+    m_endpointIndex.Create(64);
 }
 
 
@@ -24,8 +27,12 @@ void CActorHandler::Destroy(void) {
         a->Destroy ();
         delete a;
     }
+    m_actorIndex.Clear();
+    m_endpointIndex.Clear();
+#ifndef HEADLESS
     m_playerShadow.Destroy();
     m_playerHalo.Destroy();
+#endif
 }
 
 
@@ -37,13 +44,22 @@ CPlayer* CActorHandler::CreatePlayer(int colorIndex, CVector position, CVector o
     }
     else
         gameData->RemoveColorIndex(colorIndex);
+#ifndef HEADLESS
     CPlayer* player = new CPlayer("player", colorIndex, &m_playerShadow, &m_playerHalo, &m_playerOutline);
+#else
+    CPlayer* player = new CPlayer("player", colorIndex, nullptr, nullptr, nullptr);
+#endif
     uint16_t ports[2] = { inPort, outPort };
     player->SetAddress(address, ports);
+#ifndef HEADLESS
     player->Create(gameData->GetColor(colorIndex) + " player", &m_playerSphere, 0, gameData->m_textures, CList<CString>(), position, orientation, 1.0, &m_viewer->m_camera);
-    player->SetColorIndex(colorIndex);
     player->SetProjectileMesh (&m_projectileSphere);
+#else
+    player->Create(gameData->GetColor(colorIndex) + " player", nullptr, 0, gameData->m_textures, CList<CString>(), position, orientation, 1.0, &m_viewer->m_camera);
+#endif
+    player->SetColorIndex(colorIndex);
     m_actors.Append(player);
+    AddToIndex(player);
     return player;
 }
 
@@ -51,10 +67,13 @@ CPlayer* CActorHandler::CreatePlayer(int colorIndex, CVector position, CVector o
 CViewer* CActorHandler::CreateViewer(void) {
     CViewer* m_viewer = new CViewer ();
     m_viewer->SetColorIndex (gameData->GetColorIndex ());
+#ifndef HEADLESS
     m_viewer->SetupTextures(gameData->m_textures);
     m_viewer->SetMesh(&m_playerSphere);
     m_viewer->SetProjectileMesh(&m_projectileSphere);
+#endif
     m_actors.Append(m_viewer);
+    AddToIndex(m_viewer);
     return m_viewer;
 }
 
@@ -65,6 +84,7 @@ CProjectile* CActorHandler::CreateProjectile(CPlayer* parent, int id) {
     CProjectile * projectile = new CProjectile (id);
     projectile->Create(parent);
     m_actors.Append(projectile);
+    AddToIndex(projectile);
     return projectile;
 }
 
@@ -85,7 +105,9 @@ bool CActorHandler::DeletePlayer(int colorIndex) {
         fprintf (stderr, "Trying to delete local player\n");
         return false;
     }
+#ifndef HEADLESS
     soundHandler->StopActorSounds(player);
+#endif
     gameData->ReturnColorIndex(colorIndex);
     // delete all child objects (projectiles) of this player
     for (auto [i, a] : m_actors)
@@ -108,10 +130,88 @@ bool CActorHandler::DeleteActor(int id, int colorIndex) {
 
 
 CActor* CActorHandler::FindActor(int id, int colorIndex) {
+    CActor** actor = m_actorIndex.Find(ActorKey(id, colorIndex));
+    if (!actor)
+        return nullptr;
+    if (((*actor)->GetId() == id) && ((*actor)->GetColorIndex() == colorIndex))
+        return *actor;
+    // the actor's color has changed without the index having been updated
+    Reindex();
+    actor = m_actorIndex.Find(ActorKey(id, colorIndex));
+    return actor ? *actor : nullptr;
+}
+
+
+CPlayer* CActorHandler::FindPlayer(CString& address, uint16_t port) {
+    CPlayer** player = m_endpointIndex.Find(EndpointKey(address, port));
+    if (!player)
+        return nullptr;
+    // check for port too as there may be players in the same local network && behind the same router/firewall, sharing the same ip address && just using different ports
+    if (((*player)->GetPort(1) == port) && ((*player)->GetAddress() == address))
+        return *player;
+    Reindex();
+    player = m_endpointIndex.Find(EndpointKey(address, port));
+    return (player && ((*player)->GetPort(1) == port) && ((*player)->GetAddress() == address)) ? *player : nullptr;
+}
+
+
+// ip v4 addresses are packed into the key directly; anything else (host names) is hashed
+uint64_t CActorHandler::EndpointKey(CString& address, uint16_t port) {
+    uint32_t ip = 0;
+    int parts = 0;
+    const char* ps = address.Buffer() ? address.Buffer() : "";
+    for (;;) {
+        if (!isdigit(*ps))
+            break;
+        uint32_t part = 0;
+        for (; isdigit(*ps) && (part < 256); ps++)
+            part = part * 10 + (*ps - '0');
+        if (part > 255)
+            break;
+        ip = (ip << 8) | part;
+        if ((++parts == 4) || (*ps != '.'))
+            break;
+        ps++;
+    }
+    if ((parts == 4) && !*ps)
+        return (uint64_t(ip) << 16) | port;
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (ps = address.Buffer() ? address.Buffer() : ""; *ps; ps++)
+        h = (h ^ uint8_t(*ps)) * 16777619u;
+    return (uint64_t(1) << 48) | (uint64_t(h) << 16) | port;
+}
+
+
+void CActorHandler::AddToIndex(CActor* actor) {
+    m_actorIndex.Insert(ActorKey(actor->GetId(), actor->GetColorIndex()), actor);
+    if (actor->IsPlayer()) {
+        CString address = actor->GetAddress();
+        m_endpointIndex.Insert(EndpointKey(address, actor->GetPort(1)), (CPlayer*) actor);
+    }
+}
+
+
+// only remove the index entries if they still refer to the actor (a new actor may have taken over its key)
+void CActorHandler::RemoveFromIndex(CActor* actor) {
+    uint64_t key = ActorKey(actor->GetId(), actor->GetColorIndex());
+    CActor** a = m_actorIndex.Find(key);
+    if (a && (*a == actor))
+        m_actorIndex.Remove(key);
+    if (actor->IsPlayer()) {
+        CString address = actor->GetAddress();
+        key = EndpointKey(address, actor->GetPort(1));
+        CPlayer** p = m_endpointIndex.Find(key);
+        if (p && (*p == (CPlayer*) actor))
+            m_endpointIndex.Remove(key);
+    }
+}
+
+
+void CActorHandler::Reindex(void) {
+    m_actorIndex.Clear();
+    m_endpointIndex.Clear();
     for (auto [i, a] : m_actors)
-        if ((a->GetId() == id) && (a->GetColorIndex() == colorIndex))
-            return a;
-    return nullptr;
+        AddToIndex(a);
 }
 
 
@@ -137,6 +237,7 @@ void CActorHandler::Cleanup(void) {
             if (a->IsViewer())
                 fprintf (stderr, "Trying to delete local player\n");
             else {
+                RemoveFromIndex(a);
                 m_actors.Pop (int (i));
                 delete a;
             }
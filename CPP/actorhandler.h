@@ -1,26 +1,34 @@
 #pragma once
 
 #include <math.h>
-#include "icosphere.h"
+#ifndef HEADLESS
+#   include "icosphere.h"
+#endif
+#include "chashmap.h"
 #include "actor.h"
 #include "player.h"
 #include "projectile.h"
-#include "gameData.h"
-#include "soundHandler.h"
+#include "gamedata.h"
+#ifndef HEADLESS
+#   include "soundhandler.h"
+#endif
 
 // =================================================================================================
 
 class CActorHandler {
     public:
+#ifndef HEADLESS    // the dedicated server's actors have no shapes
         CRectangleIcoSphere     m_playerSphere;
         CRectangleIcoSphere     m_projectileSphere;
         CPlayerShadow           m_playerShadow;
         CPlayerHalo             m_playerHalo;
         CPlayerOutline          m_playerOutline;
+#endif
         CViewer *               m_viewer;
         CList<CActor*>          m_actors;
+        CHashMap<uint64_t, CActor*>     m_actorIndex;       // (color, id) -> actor
+        CHashMap<uint64_t, CPlayer*>    m_endpointIndex;    // (ip v4 address, out port) -> player
         CList<CVector>          m_colorPool;
-        size_t                  m_maxPlayers;
         int                     m_actorId;
 
 
@@ -53,16 +61,34 @@ class CActorHandler {
             return (CPlayer*)FindActor(0, colorIndex);
         }
 
+        // find the player sending from address:port (the player's out port)
+        CPlayer* FindPlayer(CString& address, uint16_t port);
+
         CActor* FindActor(int id, int colorIndex);
 
+        // rebuild the lookup indices. Required whenever an actor's color or a player's address or ports change
+        void Reindex(void);
+
         CProjectile* FindProjectile (int colorIndex);
             
         void CleanupActors(void);
 
         void Cleanup (void);
 
+    private:
+        static inline uint64_t ActorKey(int id, int colorIndex) {
+            return (uint64_t(uint32_t(colorIndex)) << 32) | uint32_t(id);
+        }
+
+        static uint64_t EndpointKey(CString& address, uint16_t port);
+
+        void AddToIndex(CActor* actor);
+
+        void RemoveFromIndex(CActor* actor);
+
+    public:
         inline size_t PlayerCount(void) {
-            return m_maxPlayers - gameData->m_availableColors.Length();
+            return size_t(gameData->m_maxPlayers) - gameData->m_availableColors.Length();
         }
 
 };
@@ -1,10 +1,11 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #include "textfileloader.h"
 
-#include "argHandler.h"
+#include "arghandler.h"
 #include "cavltree.h"
 
 // =================================================================================================
@@ -94,6 +95,16 @@ CString& CArgValue::GetVal (int i) {
 
 CString CArgument::Create(CString arg) {
     arg = arg.Split('#')[0];
+    // drop the blanks in front of a comment. Windows ignores trailing blanks in file names, other systems don't
+    int l = int (arg.Length ());
+    while ((l > 0) && isspace (uint8_t (*arg.Buffer (l - 1))))
+        l--;
+    if (l == 0)     // blank line
+        return m_key = CString ("");
+    if (l < int (arg.Length ())) {
+        arg.SetLength (l);
+        *arg.Buffer (l) = '\0';
+    }
     CList<CString> values = arg.Replace("= ", "=", 1).Replace(" =", "=", 1).Replace("\n", "", 1).Split('=');
     m_key = values[0].Lower();
     if (values.Length() > 1)
@@ -130,7 +141,28 @@ CArgHandler::CArgHandler(int argC, char** argV) {
 void CArgHandler::Add(CString arg) {
     CArgument a;
     CString key = a.Create(arg);
-    m_argList.Insert(key, a);
+    if (!key.Empty())
+        m_argList.Insert(key, a);
+}
+
+
+void CArgHandler::Set(CString arg) {
+    CArgument a;
+    CString key = a.Create(arg);
+    if (key.Empty())
+        return;
+    CArgument* value = m_argList.Find(key);
+    if (value)
+        *value = a;
+    else
+        m_argList.Insert(key, a);
+}
+
+
+void CArgHandler::Clear(const char* key) {
+    CArgument* a = GetArg(key);
+    if (a)
+        a->m_values = CArgValue(CString(""));
 }
 
 
@@ -71,6 +71,12 @@ class CArgHandler {
 
         void Add(CString arg);
 
+        // like Add, but replaces a value that has already been set
+        void Set(CString arg);
+
+        // make a value empty (e.g. to turn off a feature for a subsystem sharing the arguments)
+        void Clear(const char* key);
+
         int LoadArgs(const char* fileName = "smileybattle.ini");
 
         CArgument* GetArg(const char* key);
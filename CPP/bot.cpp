@@ -0,0 +1,239 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <stdlib.h>
+
+#include "SDL.h"
+#include "bot.h"
+#include "router.h"
+#include "arghandler.h"
+
+// =================================================================================================
+// Synthetic players for host load tests (see bot.h)
+
+#define MAX_HEADING_ERROR   45.0f   // [deg] bots only walk if they are facing their waypoint at most this much off
+#define MAX_AIM_ERROR       10.0f   // [deg] hunting bots only fire if they are aiming at their target at least this well
+#define STUCK_TIMEOUT       2000    // [ms] bots not getting closer to their waypoint for that long plan a new route
+#define HUNT_REPLAN_TIME    1000    // [ms] hunting bots follow their moving target by planning a new route that often
+
+CBot::CBot(int index, eMovementProfiles movement, float fireRate)
+    : m_index(index), m_movement(movement), m_fireRate(fireRate),
+      m_gameData(nullptr), m_actorHandler(nullptr), m_gameItems(nullptr), m_physicsHandler(nullptr), m_networkHandler(nullptr),
+      m_waypoint(0), m_targetColor(-1), m_waypointDistance(0.0f), m_startTime(0), m_joinTime(-1)
+{
+    // same speeds as players using the default controls (see CControlsHandler)
+    m_moveSpeed = argHandler->FloatVal("movespeed", 0, 1.0f) / 20.0f;
+    m_turnSpeed = argHandler->FloatVal("turnspeed", 0, 1.0f);
+}
+
+
+CBot::eMovementProfiles CBot::MovementProfile(CString name) {
+    if (name == "static")
+        return mpStatic;
+    if (name == "hunt")
+        return mpHunt;
+    return mpPatrol;
+}
+
+
+void CBot::Create(void) {
+    int port = argHandler->IntVal("botport", 0, 9200) + 2 * m_index;
+    argHandler->Set(CString("inport=") + CString(port));
+    argHandler->Set(CString("outport=") + CString(port + 1));
+    gameData = m_gameData = new CGameData();
+    actorHandler = m_actorHandler = new CActorHandler();
+    gameItems = m_gameItems = new CGameItems();
+    physicsHandler = m_physicsHandler = new CPhysicsHandler();
+    networkHandler = m_networkHandler = new CNetworkHandler();
+    gameItems->Create();
+    networkHandler->Create();
+    m_startTime = SDL_GetTicks();
+}
+
+
+void CBot::Destroy(void) {
+    if (!m_networkHandler)
+        return;
+    Select();
+    networkHandler->BroadcastLeave();
+    networkHandler->Destroy();
+    delete m_networkHandler;
+    delete m_physicsHandler;
+    delete m_gameItems;
+    delete m_actorHandler;
+    delete m_gameData;
+    m_networkHandler = nullptr;
+    m_physicsHandler = nullptr;
+    m_gameItems = nullptr;
+    m_actorHandler = nullptr;
+    m_gameData = nullptr;
+    networkHandler = nullptr;
+    physicsHandler = nullptr;
+    gameItems = nullptr;
+    actorHandler = nullptr;
+    gameData = nullptr;
+}
+
+
+void CBot::Select(void) {
+    gameData = m_gameData;
+    actorHandler = m_actorHandler;
+    gameItems = m_gameItems;
+    physicsHandler = m_physicsHandler;
+    networkHandler = m_networkHandler;
+}
+
+
+// the same frame as the dedicated server's (see CServer::Run), plus the bot's own controls
+void CBot::Update(void) {
+    Select();
+    gameData->m_gameTime = SDL_GetTicks();
+    if (!Joined() && (networkHandler->m_joinState == CNetworkHandler::jsConnected))
+        m_joinTime = int(SDL_GetTicks() - m_startTime);
+    if (m_moveTimer.HasPassed(physicsHandler->m_frameTime, true)) {
+        float dt = float(m_moveTimer.m_lapTime) / float(physicsHandler->m_frameTime);
+        if (dt > 4.0f)   // the first frame && frames after long stalls
+            dt = 4.0f;
+        Steer(dt);
+    }
+    physicsHandler->Update();
+    networkHandler->Update();
+    actorHandler->Cleanup();
+}
+
+
+// the viewer is updated even before having joined, as that runs its life states (spawning)
+void CBot::Steer(float dt) {
+    CViewer* viewer = gameItems->m_viewer;
+    CVector angles = CVector(0, 0, 0);
+    CVector offset = CVector(0, 0, 0);
+    if (Joined() && viewer->IsAlive() && viewer->HavePosition()) {
+        CPlayer* target = nullptr;
+        if (m_movement == mpStatic)
+            angles.Y() = m_turnSpeed / 4.0f;
+        else {
+            if (m_movement == mpHunt) {
+                target = FindTarget();
+                int targetColor = target ? target->GetColorIndex() : -1;
+                if ((targetColor != m_targetColor) || m_routeTimer.HasPassed(HUNT_REPLAN_TIME, false)) {
+                    m_targetColor = targetColor;
+                    m_route.Destroy();
+                }
+            }
+            if (m_waypoint >= int(m_route.Length())) {
+                m_route.Destroy();
+                if (!PlanRoute(target ? gameItems->m_map->SegmentIdAt(target->GetPosition()) : RandomSegment()))
+                    m_route.Destroy();
+            }
+            if (m_waypoint < int(m_route.Length())) {
+                CVector v = m_route[m_waypoint] - viewer->GetPosition();
+                v.Y() = 0.0f;
+                float distance = v.Len();
+                if (distance < gameItems->m_map->m_scale * 0.2f) {
+                    m_waypoint++;
+                    m_waypointDistance = 1e6f;
+                }
+                else {
+                    if (distance < m_waypointDistance - 0.1f) {
+                        m_waypointDistance = distance;
+                        m_progressTimer.Start();
+                    }
+                    else if (m_progressTimer.HasPassed(STUCK_TIMEOUT, false))
+                        m_waypoint = int(m_route.Length());
+                    float error = HeadingError(v);
+                    angles.Y() = (fabs(error) < m_turnSpeed * dt) ? error / dt : (error < 0.0f) ? -m_turnSpeed : m_turnSpeed;
+                    if (fabs(error) < MAX_HEADING_ERROR)
+                        offset.Z() = -m_moveSpeed;
+                }
+            }
+        }
+        // hunting bots turn towards visible targets to shoot at them, stopping in their tracks
+        bool mayFire = (m_movement != mpHunt);
+        if (!mayFire && target && IsVisible(target)) {
+            CVector v = target->GetPosition() - viewer->GetPosition();
+            v.Y() = 0.0f;
+            float error = HeadingError(v);
+            angles.Y() = (fabs(error) < m_turnSpeed * dt) ? error / dt : (error < 0.0f) ? -m_turnSpeed : m_turnSpeed;
+            offset.Z() = 0.0f;
+            mayFire = (fabs(error) < MAX_AIM_ERROR);
+        }
+        if (mayFire && (m_fireRate > 0.0f) && m_fireTimer.HasPassed(int(1000.0f / m_fireRate), false) && viewer->ReadyToFire()) {
+            m_fireTimer.Start();
+            viewer->Fire();
+        }
+    }
+    viewer->Update(dt, angles, offset);
+}
+
+
+CPlayer* CBot::FindTarget(void) {
+    CPlayer* target = nullptr;
+    float minDistance = 1e30f;
+    CVector& position = gameItems->m_viewer->GetPosition();
+    for (auto [i, a] : actorHandler->m_actors) {
+        if (!a->IsPlayer() || a->IsViewer() || !a->IsAlive() || !a->HavePosition())
+            continue;
+        float distance = gameItems->m_map->Distance(position, a->GetPosition());
+        if (minDistance > distance) {
+            minDistance = distance;
+            target = (CPlayer*) a;
+        }
+    }
+    return target;
+}
+
+
+bool CBot::IsVisible(CPlayer* player) {
+    return gameItems->m_map->Interest(gameItems->m_viewer->GetPosition(), player->GetPosition(), 0.0f) == 2;
+}
+
+
+// the route's waypoints are the path nodes the path edges between the route's segments start && end at. There is a
+// line of sight along each path edge, && from its end to the start of the next one, as they lie in the same segment
+bool CBot::PlanRoute(int destination) {
+    CMap* map = gameItems->m_map;
+    CSegmentMap& segments = map->m_segmentMap;
+    m_waypoint = 0;
+    m_waypointDistance = 1e6f;
+    m_progressTimer.Start();
+    m_routeTimer.Start();
+    if ((destination < 0) || (destination >= segments.m_size))
+        return false;
+    int start = map->SegmentIdAt(gameItems->m_viewer->GetPosition());
+    if (segments.m_pathEdgeTable.Length() && (start != destination)) {
+        if (router.m_maxNodes != segments.m_size)   // the router is released after the map's distance table has been built
+            router.Create(segments.m_size);
+        if (router.FindPath(start, destination, segments) < 0)
+            return false;
+        for (auto [i, node] : router.m_route) {
+            if (node.m_edgeId < 0)
+                continue;
+            CSegmentPathEdge& edge = segments.m_pathEdgeTable[node.m_edgeId];
+            m_route.Append(edge.m_startPos);
+            m_route.Append(edge.m_endPos);
+        }
+    }
+    m_route.Append(map->GetSegmentById(destination).m_center);
+    return true;
+}
+
+
+int CBot::RandomSegment(void) {
+    CMap* map = gameItems->m_map;
+    for (int i = 0; i < 100; i++) {
+        int id = rand() % map->Size();
+        if (map->GetSegmentById(id).m_connections)
+            return id;
+    }
+    return -1;
+}
+
+
+// the viewer moves along the direction the negative z axis is rotated to (see CControlsHandler::HandleControls)
+float CBot::HeadingError(CVector v) {
+    CVector forward = gameItems->m_viewer->m_camera.m_orientation.Unrotate(CVector(0, 0, -1));
+    forward.Y() = 0.0f;
+    CVector normal = forward.Cross(v);
+    return float(atan2(normal.Y(), forward.Dot(v)) * 180.0 / M_PI);
+}
+
+// =================================================================================================
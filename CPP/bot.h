@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "cstring.h"
+#include "clist.h"
+#include "vector.h"
+#include "timer.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#include "actorhandler.h"
+#include "physicshandler.h"
+#include "networkhandler.h"
+
+// =================================================================================================
+// Synthetic players for host load tests
+//
+// A bot is a complete headless game client: It has game data, actors, a map, physics && a network handler of its own
+// && joins the game host through the regular APPLY/ENTER flow. The game's modules reach each other through global
+// pointers (gameData, actorHandler, ...), so several bots can share a process by pointing these at their own
+// instances before doing anything (see Select). All bots must therefore be run by the same thread (their network
+// listeners may run threads of their own, see CListener).
+//
+// Once it has joined, a bot moves according to its movement profile && fires botFireRate shots per second (still
+// limited by the game's fire delay):
+//   static: stays where it has spawned, turning on the spot
+//   patrol: walks along the routes the router finds to randomly chosen map segments
+//   hunt:   walks towards the closest other player && only fires at players it has a line of sight to
+//
+// The bots of a process share the local address. They must not use the host's address (see
+// CNetworkHandler::IamMaster) || 127.0.0.1 (see CActor::IsLocalActor).
+
+class CBot {
+    public:
+        typedef enum {
+            mpStatic,
+            mpPatrol,
+            mpHunt
+        } eMovementProfiles;
+
+        int                 m_index;
+        eMovementProfiles   m_movement;
+        float               m_fireRate;     // [shots/s]
+        float               m_moveSpeed;    // per physics frame
+        float               m_turnSpeed;    // [deg] per physics frame
+        CGameData*          m_gameData;
+        CActorHandler*      m_actorHandler;
+        CGameItems*         m_gameItems;
+        CPhysicsHandler*    m_physicsHandler;
+        CNetworkHandler*    m_networkHandler;
+        CList<CVector>      m_route;        // waypoints
+        int                 m_waypoint;
+        int                 m_targetColor;  // hunt: color of the player walked towards (players may leave any time)
+        CTimer              m_moveTimer;
+        CTimer              m_fireTimer;
+        CTimer              m_routeTimer;   // hunt: time since the route has been planned
+        CTimer              m_progressTimer;
+        float               m_waypointDistance;
+        uint32_t            m_startTime;
+        int                 m_joinTime;     // [ms] from start to having joined (-1: not joined yet)
+
+        CBot(int index, eMovementProfiles movement, float fireRate);
+
+        ~CBot() {
+            Destroy();
+        }
+
+        // create the bot's modules && start joining the game host. The bot's ports are those of the first bot
+        // (botport) plus two per bot
+        void Create(void);
+
+        void Destroy(void);
+
+        // make the global module pointers point to this bot's modules
+        void Select(void);
+
+        // run a frame of the bot's game
+        void Update(void);
+
+        inline bool Joined(void) {
+            return m_joinTime >= 0;
+        }
+
+        static eMovementProfiles MovementProfile(CString name);
+
+    private:
+        void Steer(float dt);
+
+        CPlayer* FindTarget(void);
+
+        bool IsVisible(CPlayer* player);
+
+        // plan a route from the bot's position to the center of segment destination. Without path data (distance
+        // quality 0), the bot walks straight towards it
+        bool PlanRoute(int destination);
+
+        int RandomSegment(void);
+
+        // heading [deg] to turn to for facing v (positive: to the left)
+        float HeadingError(CVector v);
+};
+
+// =================================================================================================
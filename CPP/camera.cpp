@@ -1,5 +1,4 @@
 
-#include "glew.h"
 #include "camera.h"
 
 // =================================================================================================
@@ -21,6 +20,7 @@ CCamera& CCamera::operator=(const CCamera& other) {
 
 
 void CCamera::Enable (void) {
+#ifndef HEADLESS
     glMatrixMode (GL_MODELVIEW);
     glPushMatrix ();
     if (m_parent == nullptr) {
@@ -32,12 +32,15 @@ void CCamera::Enable (void) {
         Rotate (m_orientation);
     }
     Scale ();
+#endif
 }
 
 
 void CCamera::Disable (void) {
+#ifndef HEADLESS
     glMatrixMode (GL_MODELVIEW);
     glPopMatrix ();
+#endif
     }
 
 
@@ -3,7 +3,9 @@
 #define _USE_MATH_DEFINES // for C++
 //#include <cmath>
 //#include <math.h>
-#include "glew.h"
+#ifndef HEADLESS
+#   include "glew.h"
+#endif
 #include "cstring.h"
 #include "matrix.h"
 
@@ -40,6 +42,7 @@ class CCamera {
         CCamera& operator=(const CCamera& other);
 
 
+#ifndef HEADLESS    // the dedicated server doesn't render anything (see Enable, Disable)
         inline void Move (CVector v) {
             glTranslatef (v.X(), v.Y(), v.Z());
             }
@@ -53,6 +56,7 @@ class CCamera {
         inline void Scale (void) {
             glScalef (m_size, m_size, m_size);
             }
+#endif
 
 
         inline void Setup (CVector& position, CMatrix& orientation) {
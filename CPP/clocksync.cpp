@@ -0,0 +1,44 @@
+#include "clocksync.h"
+
+// =================================================================================================
+
+void CClockSync::Reset(void) {
+    m_sampleCount = 0;
+    m_nextSample = 0;
+    m_synchronized = false;
+    m_offset = 0;
+    m_rtt = -1;
+    m_peerTime = 0;
+    m_peerTimeReceived = 0;
+    m_sendTime = 0;
+}
+
+
+// The peer has received our record at peerTime - holdTime && sent its own at peerTime. Taking the transmission delays
+// both ways to be the same, its clock has read peerTime when ours read now - rtt / 2
+void CClockSync::Received(uint32_t peerTime, uint32_t echoTime, uint32_t holdTime, uint32_t now) {
+    if (m_peerTime && (int(peerTime - m_peerTime) <= 0))  // reordered || duplicated
+        return;
+    m_peerTime = peerTime;
+    m_peerTimeReceived = now;
+    if (!echoTime)
+        return;
+    int rtt = int(now - echoTime) - int(holdTime);
+    if (rtt < 0)
+        return;
+    CSample& sample = m_samples[m_nextSample];
+    sample.m_rtt = rtt;
+    sample.m_offset = int(peerTime - (now - uint32_t(rtt / 2)));
+    m_nextSample = (m_nextSample + 1) % CLOCK_SAMPLES;
+    if (m_sampleCount < CLOCK_SAMPLES)
+        m_sampleCount++;
+    CSample* best = m_samples;
+    for (int i = 1; i < m_sampleCount; i++)
+        if (m_samples[i].m_rtt < best->m_rtt)
+            best = m_samples + i;
+    m_offset = best->m_offset;
+    m_rtt = best->m_rtt;
+    m_synchronized = true;
+}
+
+// =================================================================================================
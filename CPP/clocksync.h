@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+
+#define CLOCK_SAMPLES       8       // round trips the clock offset is chosen from
+#define CLOCK_INTERVAL      200     // [ms] between two clock records sent to a peer
+
+// =================================================================================================
+// Per peer clock synchronization (NTP style)
+//
+// Every machine's clock (SDL_GetTicks) starts when the game does, so peers' time stamps can't be compared directly.
+// Binary peers exchange a CLOCK record every CLOCK_INTERVAL ms: It carries the sender's clock, the clock value of the
+// last record received from the receiver (echo) && how long the sender has held that record before answering. The
+// receiver gets the round trip time from the echo && the hold time, && the clock offset from the sender's clock,
+// assuming the transmission took half the round trip. Queues on the way make some round trips take longer, which
+// skews the offset, so the offset of the fastest of the last CLOCK_SAMPLES round trips is used.
+
+class CClockSync {
+    public:
+        class CSample {
+            public:
+                int     m_offset;
+                int     m_rtt;
+        };
+
+        CSample     m_samples[CLOCK_SAMPLES];
+        int         m_sampleCount;
+        int         m_nextSample;
+        bool        m_synchronized;     // at least one round trip has been measured
+        int         m_offset;           // [ms] peer's clock minus ours
+        int         m_rtt;              // [ms] round trip time of the sample the offset has been taken from
+        uint32_t    m_peerTime;         // peer's clock in the most recent clock record received (0: none)
+        uint32_t    m_peerTimeReceived; // [ms] when that record has arrived
+        uint32_t    m_sendTime;         // [ms] when we have sent our last clock record
+
+        CClockSync() {
+            Reset();
+        }
+
+        void Reset(void);
+
+        inline bool Due(uint32_t now) {
+            return (m_sendTime == 0) || (now - m_sendTime >= CLOCK_INTERVAL);
+        }
+
+        // time the peer's last clock record has been held until now (to be sent along with its echo)
+        inline uint32_t HoldTime(uint32_t now) {
+            return m_peerTime ? now - m_peerTimeReceived : 0;
+        }
+
+        // process a clock record received at now: peerTime is the peer's clock when sending it, echoTime our clock
+        // value it has last received from us (0: none yet), holdTime how long it has had that one
+        void Received(uint32_t peerTime, uint32_t echoTime, uint32_t holdTime, uint32_t now);
+
+        // our clock value converted to the peer's clock
+        inline uint32_t PeerTime(uint32_t localTime) {
+            return localTime + uint32_t(m_offset);
+        }
+
+        // [ms] one way transmission delay (0: unknown)
+        inline int Delay(void) {
+            return m_synchronized ? m_rtt / 2 : 0;
+        }
+};
+
+// =================================================================================================
@@ -2,6 +2,7 @@
 
 #include "collisionhandler.h"
 #include "gameitems.h"
+#include "networkhandler.h"
 
 // =================================================================================================
 
@@ -108,7 +109,7 @@ int CCollisionHandler::GetActorMapCollisions (CVector* positions, float radius,
 
 int CCollisionHandler::HandleProjectileMapCollision (CProjectile * projectile, CVector& vHit) {   // gameTime required to provide the same function interface as CActor->HandleMapCollision
     vHit = CVector (NAN, NAN, NAN);
-    if (!projectile->IsLocalActor ())
+    if (!projectile->m_isSimulated && !projectile->IsLocalActor ())    // simulated remote projectiles disappear in the wall locally, too
         return 0;
     if (GetProjectileMapCollision (projectile->m_camera.m_positions, projectile->Radius (), vHit))
         projectile->Delete ();
@@ -120,6 +121,8 @@ int CCollisionHandler::HandleProjectileMapCollision (CProjectile * projectile, C
 // That way, every client decides whether && when he gets hit, && communicates hits to the otherActor players
 // The result is a smooth gameplay experience for each local player regarding collisions with projectiles
 // && movement of his own projectiles
+// The shooter sees the local player where he has been some time ago, so a remote player's shot is tested against the
+// position the local player has had at that time (lag compensation, at most m_lagCompensation ms back)
 int CCollisionHandler::HandleProjectileActorCollision (CProjectile * projectile, CActor * actor, CVector& vHit) {
     vHit = CVector (NAN, NAN, NAN);
     if (actor == projectile->m_parent)  // don't shoot yourself (can happen right after the shot has been fired)
@@ -127,7 +130,11 @@ int CCollisionHandler::HandleProjectileActorCollision (CProjectile * projectile,
     if (!actor->IsLocalActor ())  // only register hits on the viewer (local player)
         return 0;
     CVector p = projectile->GetPosition ();
-    CVector v = actor->GetPosition () - p;
+    CVector position = actor->GetPosition ();
+    int viewLag = actor->IsPlayer () ? networkHandler->ViewLag (projectile->m_parent) : 0;
+    if (viewLag > 0)
+        ((CPlayer*) actor)->m_history.Sample (uint32_t (gameData->m_gameTime) - uint32_t (viewLag), position);
+    CVector v = position - p;
     float l = v.Len ();
     float r = projectile->Radius () + actor->Radius ();
     if (l >= r)
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+
+#include "congestioncontrol.h"
+
+// =================================================================================================
+
+static inline int SequenceDistance(uint16_t s1, uint16_t s2) {
+    return int16_t(s1 - s2);
+}
+
+
+void CCongestionControl::Reset(void) {
+    for (int i = 0; i < PACKET_HISTORY; i++)
+        m_sent[i].m_pending = false;
+    m_srtt = -1.0f;
+    m_minRtt = 0.0f;
+    m_loss = 0.0f;
+    m_acked = 0;
+    m_lost = 0;
+    m_adjustmentTime = 0;
+    m_rate = 0.0f;
+    m_bandwidth = 0.0f;
+    m_credit = 0.0f;
+    m_totalSent = 0;
+    m_totalLost = 0;
+    m_receivedSequence = 0;
+    m_receivedBits = 0;
+    m_receiveTime = 0;
+    m_receiveInterval = 0.0f;
+}
+
+
+void CCongestionControl::Lose(CSentPacket& packet) {
+    packet.m_pending = false;
+    m_lost++;
+    m_totalLost++;
+}
+
+
+void CCongestionControl::UpdateRtt(float rtt) {
+    if (m_srtt < 0.0f)
+        m_srtt = m_minRtt = rtt;
+    else {
+        m_srtt += (rtt - m_srtt) * 0.125f;
+        if (m_minRtt > rtt)
+            m_minRtt = rtt;
+    }
+}
+
+
+// a packet still pending in the slot about to be reused hasn't been reported within PACKET_HISTORY packets
+void CCongestionControl::Sent(uint16_t sequence, uint32_t now) {
+    CSentPacket& packet = m_sent[sequence % PACKET_HISTORY];
+    if (packet.m_pending)
+        Lose(packet);
+    packet.m_sequence = sequence;
+    packet.m_sentTime = now;
+    packet.m_pending = true;
+    m_totalSent++;
+}
+
+
+void CCongestionControl::Received(uint16_t sequence, uint32_t now) {
+    if (m_receivedSequence == 0) {
+        m_receivedSequence = sequence;
+        m_receivedBits = 0;
+    }
+    else {
+        int d = SequenceDistance(sequence, m_receivedSequence);
+        if (d > 0) {
+            m_receivedBits = ((d < RECEIVED_WINDOW) ? (m_receivedBits << d) : 0) | ((d <= RECEIVED_WINDOW) ? (1u << (d - 1)) : 0);
+            m_receivedSequence = sequence;
+        }
+        else if ((d < 0) && (d >= -RECEIVED_WINDOW))   // arrived out of order
+            m_receivedBits |= 1u << (-d - 1);
+    }
+    if (m_receiveTime)
+        m_receiveInterval += (float(now - m_receiveTime) - m_receiveInterval) * 0.125f;
+    m_receiveTime = now;
+}
+
+
+// only the most recent packet yields a round trip time sample: older ones may have been reported late because
+// the reports carrying them got lost
+void CCongestionControl::Acknowledged(uint16_t sequence, uint32_t bits, uint32_t now) {
+    if (sequence == 0)
+        return;
+    for (int i = 0; i < PACKET_HISTORY; i++) {
+        CSentPacket& packet = m_sent[i];
+        if (!packet.m_pending)
+            continue;
+        int d = SequenceDistance(sequence, packet.m_sequence);
+        if ((d < 0) || (int(now - packet.m_sentTime) < 0))     // sent after the report
+            continue;
+        if (d == 0) {
+            UpdateRtt(float(now - packet.m_sentTime));
+            packet.m_pending = false;
+            m_acked++;
+        }
+        else if (d > RECEIVED_WINDOW)
+            Lose(packet);
+        else if (bits & (1u << (d - 1))) {
+            packet.m_pending = false;
+            m_acked++;
+        }
+    }
+}
+
+
+void CCongestionControl::Adjust(uint32_t now, float minRate, float maxRate, float minBandwidth, float maxBandwidth) {
+    if (m_rate <= 0.0f) {  // start optimistic
+        m_rate = maxRate;
+        m_bandwidth = maxBandwidth;
+        m_adjustmentTime = now;
+        return;
+    }
+    if (int(now - m_adjustmentTime) < ADJUSTMENT_INTERVAL)
+        return;
+    m_adjustmentTime = now;
+    if (m_acked + m_lost > 0)
+        m_loss += (float(m_lost) / float(m_acked + m_lost) - m_loss) * 0.25f;
+    m_acked = m_lost = 0;
+    if (IsCongested()) {
+        m_rate *= 0.75f;
+        m_bandwidth *= 0.75f;
+    }
+    else {
+        m_rate += 2.0f;
+        m_bandwidth += 1000.0f;
+    }
+    m_rate = (m_rate < minRate) ? minRate : (m_rate > maxRate) ? maxRate : m_rate;
+    m_bandwidth = (m_bandwidth < minBandwidth) ? minBandwidth : (m_bandwidth > maxBandwidth) ? maxBandwidth : m_bandwidth;
+}
+
+
+// spread the snapshots evenly across the network frames
+bool CCongestionControl::SnapshotDue(int fps) {
+    float rate = Rate(fps);
+    if (rate == float(fps))
+        return true;
+    m_credit += rate / float(fps);
+    if (m_credit < 1.0f)
+        return false;
+    m_credit -= 1.0f;
+    return true;
+}
+
+// =================================================================================================
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+
+#define PACKET_HISTORY          64      // number of packets sent to a peer remembered for loss && round trip time measurement
+#define RECEIVED_WINDOW         32      // number of packets preceding the most recent one a receiver reports (width of the bit field)
+#define ADJUSTMENT_INTERVAL     500     // [ms] between two send rate adjustments
+#define MIN_SNAPSHOT_BUDGET     64      // [bytes] always leave room for a few actors
+
+// =================================================================================================
+// Per peer congestion control
+//
+// Every binary packet tells the peer which of the packets it has sent us have arrived: the most recent sequence number
+// received plus a bit field of the RECEIVED_WINDOW packets preceding it (see networkpacket.h). Packets that have left
+// this window without having been reported are lost. The time between sending a packet && it being reported yields
+// the round trip time.
+// Every ADJUSTMENT_INTERVAL ms, the send rate (snapshots per second) && bandwidth (bytes per second) granted to the peer
+// are adjusted (AIMD): They are cut by a quarter if the loss rate exceeds 5% || the round trip time rises well above
+// the smallest one measured (queues building up somewhere on the way), && are raised by a small step otherwise.
+// The snapshot budget is the part of the bandwidth available to a single snapshot. Text peers aren't controlled.
+
+class CCongestionControl {
+    public:
+        class CSentPacket {
+            public:
+                uint16_t    m_sequence;
+                uint32_t    m_sentTime;
+                bool        m_pending;      // neither acknowledged nor lost yet
+
+                CSentPacket() : m_sequence(0), m_sentTime(0), m_pending(false) {}
+        };
+
+        // sending
+        CSentPacket     m_sent[PACKET_HISTORY];
+        float           m_srtt;             // smoothed round trip time [ms] (< 0: not measured yet)
+        float           m_minRtt;
+        float           m_loss;             // smoothed fraction of packets lost
+        int             m_acked;            // packets acknowledged && lost since the last adjustment
+        int             m_lost;
+        uint32_t        m_adjustmentTime;
+        float           m_rate;             // snapshots per second granted to the peer (0: not started yet)
+        float           m_bandwidth;        // [bytes/s]
+        float           m_credit;           // snapshots due
+        uint32_t        m_totalSent;        // statistics
+        uint32_t        m_totalLost;
+        // receiving
+        uint16_t        m_receivedSequence; // most recent packet received from the peer (0: none yet)
+        uint32_t        m_receivedBits;     // bit n: packet m_receivedSequence - n - 1 has been received
+        uint32_t        m_receiveTime;
+        float           m_receiveInterval;  // smoothed time [ms] between two packets from the peer
+
+        CCongestionControl() {
+            Reset();
+        }
+
+        void Reset(void);
+
+        // remember when a packet has been sent
+        void Sent(uint16_t sequence, uint32_t now);
+
+        // record the arrival of a packet from the peer
+        void Received(uint16_t sequence, uint32_t now);
+
+        // process the peer's report of the packets it has received from us
+        void Acknowledged(uint16_t sequence, uint32_t bits, uint32_t now);
+
+        // adapt send rate && bandwidth to the losses && round trip times measured since the last adjustment
+        void Adjust(uint32_t now, float minRate, float maxRate, float minBandwidth, float maxBandwidth);
+
+        // called once per network frame (fps: network frames per second). Returns true if the peer is due a snapshot
+        bool SnapshotDue(int fps);
+
+        // snapshots per second actually sent at fps network frames per second
+        inline float Rate(int fps) {
+            return ((m_rate > 0.0f) && (m_rate < float(fps))) ? m_rate : float(fps);
+        }
+
+        // number of bytes a single snapshot may take
+        inline int Budget(void) {
+            int budget = (m_rate > 0.0f) ? int(m_bandwidth / m_rate) : 0x7FFFFFFF;
+            return (budget < MIN_SNAPSHOT_BUDGET) ? MIN_SNAPSHOT_BUDGET : budget;
+        }
+
+        inline bool IsCongested(void) {
+            return (m_loss > 0.05f) || ((m_srtt >= 0.0f) && (m_srtt - m_minRtt > 50.0f + m_receiveInterval) && (m_srtt > 2.0f * m_minRtt));
+        }
+
+    private:
+        void Lose(CSentPacket& packet);
+
+        void UpdateRtt(float rtt);
+};
+
+// =================================================================================================
@@ -1,7 +1,7 @@
 #pragma once
 
-#include "controlsHandler.h"
-#include "argHandler.h"
+#include "controlshandler.h"
+#include "arghandler.h"
 
 // =================================================================================================
 // handle the various input devices && set viewer rotation && movement direction && speed 
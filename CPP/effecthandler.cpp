@@ -1,5 +1,5 @@
 
-#include "effectHandler.h"
+#include "effecthandler.h"
 
 // =================================================================================================
 
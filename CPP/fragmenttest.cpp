@@ -0,0 +1,76 @@
+#include <stdio.h>
+
+#include "networkfragments.h"
+#include "networkmessage.h"
+
+// =================================================================================================
+// Reassembles && parses a SYNCSHOTS message of a busy match (see CNetworkHandler::ProjectilesMessage). It has far
+// more values than a datagram can hold && has to be sent in several fragments. Before that, the assembler is fed
+// fragments announcing more data than their message length allows, which it has to reject without buffering them.
+
+#define SHOT_COUNT  2000
+
+static uint8_t fragmentData[FRAGMENT_SIZE];
+
+static bool Reject(CFragmentAssembler& assembler, const char* test, int fragment, int fragmentCount, size_t messageLength, size_t length) {
+    CString data;
+    if ((assembler.Add(fragment, fragmentCount, 0, messageLength, fragmentData, length, data) == -1) && (assembler.m_data.Length() == 0))
+        return true;
+    fprintf(stderr, "%s: fragment %d of %d (%zd of %zd bytes) accepted\n", test, fragment, fragmentCount, length, messageLength);
+    return false;
+}
+
+
+int main(int argc, char* argv[]) {
+    CFragmentAssembler assembler;
+    CString data;
+    bool ok = Reject(assembler, "fragment count", 0, MAX_FRAGMENTS, 2000, FRAGMENT_SIZE);
+    ok &= (assembler.Add(0, 2, 0, 2000, fragmentData, FRAGMENT_SIZE, data) == 0);
+    ok &= Reject(assembler, "fragment count changed", 1, MAX_FRAGMENTS, 2000, FRAGMENT_SIZE);
+    ok &= (assembler.Add(0, 2, 0, 2000, fragmentData, FRAGMENT_SIZE, data) == 0);
+    ok &= Reject(assembler, "message length exceeded", 1, 2, 2000, FRAGMENT_SIZE);
+    ok &= (assembler.Add(0, 3, 0, 3000, fragmentData, FRAGMENT_SIZE, data) == 0);
+    ok &= Reject(assembler, "short fragment", 1, 3, 3000, 10);
+    if (!ok)
+        return 1;
+
+    CString payload("9#");     // miSyncShots
+    for (int i = 0; i < SHOT_COUNT; i++) {
+        if (i > 0)
+            payload += ";";
+        payload += CString(i + 1);
+        payload += ";";
+        payload += CString(i % 16);
+    }
+    CFragmentedMessage fragmented(payload);
+    if (fragmented.m_fragmentCount < 2) {
+        fprintf(stderr, "the message hasn't been fragmented (%zd bytes)\n", payload.Length());
+        return 1;
+    }
+    CMessage message;
+    for (int i = 0; i < fragmented.m_fragmentCount; i++) {
+        int result = assembler.Add(i, fragmented.m_fragmentCount, fragmented.m_flags, fragmented.m_messageLength, fragmented.Fragment(i), fragmented.FragmentLength(i), message.m_payload);
+        if (result != ((i < fragmented.m_fragmentCount - 1) ? 0 : 1)) {
+            fprintf(stderr, "fragment %d of %d: unexpected result %d\n", i, fragmented.m_fragmentCount, result);
+            return 1;
+        }
+    }
+    if (!(message.m_payload == payload)) {
+        fprintf(stderr, "the reassembled message differs from the original one\n");
+        return 1;
+    }
+    if (!message.IsValid(2 * SHOT_COUNT)) {
+        fprintf(stderr, "the reassembled message can't be parsed\n");
+        return 1;
+    }
+    for (int i = 0; i < SHOT_COUNT; i++) {
+        if ((message.Int(2 * i) != i + 1) || (message.Int(2 * i + 1) != i % 16)) {
+            fprintf(stderr, "shot %d: wrong values %d;%d\n", i, message.Int(2 * i), message.Int(2 * i + 1));
+            return 1;
+        }
+    }
+    printf("%d shots: %zd bytes in %d fragments (%zd bytes) parsed\n", SHOT_COUNT, payload.Length(), fragmented.m_fragmentCount, fragmented.m_data.Length());
+    return 0;
+}
+
+// =================================================================================================
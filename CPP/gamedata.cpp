@@ -1,16 +1,18 @@
 #include <stdlib.h>
 
-#include "gameData.h"
-#include "textureHandler.h"
-#include "argHandler.h"
+#include "gamedata.h"
+#ifndef HEADLESS
+#   include "texturehandler.h"
+#endif
+#include "arghandler.h"
 
 // =================================================================================================
 
 CGameData::CGameData() {
-    m_resourceFolder = "resources\\";
-    m_textureFolder = m_resourceFolder + "textures\\";
-    m_soundFolder = m_resourceFolder + "sounds\\";
-    m_mapFolder = "maps\\";
+    m_resourceFolder = "resources/";     // Windows accepts forward slashes, too
+    m_textureFolder = m_resourceFolder + "textures/";
+    m_soundFolder = m_resourceFolder + "sounds/";
+    m_mapFolder = "maps/";
 
     m_colorValues.SetComparator(CString::Compare);
     m_colorIndices.SetComparator(CString::Compare);
@@ -41,10 +43,10 @@ CGameData::CGameData() {
         std::pair<CString, CVector>{ CString("darkgray")  , CVector(112, 112, 112) / 255.0f }
     }; // "dead-black", "dead-white"]
 
-    for (auto [i, s] : m_playerColors) {
-        m_availableColors.Append(int (i));
+    for (auto [i, s] : m_playerColors)
         m_colorIndices.Insert(*m_playerColors[i], int (i));
-    }
+    m_maxPlayers = 0;
+    SetMaxPlayers(argHandler->IntVal("maxplayers", 0, int (m_playerColors.Length())));
     m_playerMoods = { CString("-sad"),  CString("-neutral"),  CString("-happy") };
     CreatePlayerTextures();
 
@@ -62,6 +64,7 @@ CGameData::CGameData() {
     m_pointsForKill = argHandler->IntVal("pointsforkill", 0, 1);
 
     m_gameTime = SDL_GetTicks();
+    m_matchTime = uint32_t(m_gameTime);
     m_frameCap = argHandler->IntVal ("framecap", 0, 240); // fps
     m_minFrameTime = m_frameCap ? 1000 / m_frameCap : 0;
     m_isNetGame = false;
@@ -71,6 +74,7 @@ CGameData::CGameData() {
 
 
 void CGameData::CreatePlayerTextures(void) {
+#ifndef HEADLESS
     for (auto [i, color] : m_playerColors) {
         for (auto [j, mood] : m_playerMoods) {
             CString skinName = m_textureFolder + "smiley-" + *color + ".png";
@@ -90,6 +94,7 @@ void CGameData::CreatePlayerTextures(void) {
             m_textures.Insert(color + mood, texture);
         }
     }
+#endif
 }
 
 
@@ -124,6 +129,19 @@ int CGameData::ReplaceColorIndex(int oldIndex, int newIndex) {
     return newIndex;
 }
 
+
+void CGameData::SetMaxPlayers(int maxPlayers) {
+    if (maxPlayers < 2)
+        maxPlayers = 2;
+    else if (maxPlayers > MAX_PLAYERS)
+        maxPlayers = MAX_PLAYERS;
+    for (int i = m_maxPlayers; i < maxPlayers; i++)
+        m_availableColors.Append(i);
+    for (int i = maxPlayers; i < m_maxPlayers; i++)
+        m_availableColors.Remove(i);
+    m_maxPlayers = maxPlayers;
+}
+
 CGameData* gameData = nullptr;
 
 // =================================================================================================
@@ -7,7 +7,9 @@
 #include "cavltree.h"
 
 #include "vector.h"
-#include "cubemap.h"
+#ifndef HEADLESS
+#   include "cubemap.h"
+#endif
 #include "player.h"
 
 // =================================================================================================
@@ -20,6 +22,7 @@ class CGameData {
         CString         m_mapFolder;
         CList<CString>  m_playerColors;
         CList<int>      m_availableColors;
+        int             m_maxPlayers;   // color indices 0 .. m_maxPlayers - 1 are handed out (the game host's setting counts, see CNetworkHandler::SyncParams)
         CList<CString>  m_playerMoods;
 
         CAvlTree<CString, int>       m_colorIndices;
@@ -38,6 +41,7 @@ class CGameData {
         bool            m_wiggleViewer;
         int             m_pointsForKill;
         int             m_gameTime;
+        uint32_t        m_matchTime;    // [ms] the same on all machines of a match (see CNetworkHandler::MatchTime)
         int             m_frameCap;
         int             m_minFrameTime;
         bool            m_isNetGame;
@@ -49,8 +53,9 @@ class CGameData {
 
         void CreatePlayerTextures(void);
 
+        // there are more color indices than colors when the game has room for more players than colors
         inline CString GetColor(int colorIndex) {
-            return (colorIndex >= 0) ? *m_playerColors[colorIndex] : CString("");
+            return (colorIndex >= 0) ? *m_playerColors[colorIndex % int(m_playerColors.Length())] : CString("");
         }
 
         inline CVector GetColorValue(CString color) {
@@ -65,11 +70,11 @@ class CGameData {
 
         inline void RemoveColorIndex(int colorIndex) {
             if (colorIndex >= 0)
-                m_availableColors.Pop(colorIndex);
+                m_availableColors.Remove(colorIndex);
         }
 
         inline void ReturnColorIndex(int colorIndex) {
-            if (colorIndex >= 0) 
+            if ((colorIndex >= 0) && (colorIndex < m_maxPlayers))
                 m_availableColors.Append(colorIndex);
         }
 
@@ -79,6 +84,9 @@ class CGameData {
 
         int ReplaceColorIndex(int oldIndex, int newIndex);
 
+        // hand out color indices 0 .. maxPlayers - 1 (2 .. MAX_PLAYERS). Color indices in use stay in use
+        void SetMaxPlayers(int maxPlayers);
+
 };
 
 extern CGameData* gameData;
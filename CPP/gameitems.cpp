@@ -1,8 +1,10 @@
-#include "gameItems.h"
+#include "gameitems.h"
 #include "maploader.h"
-#include "actorHandler.h"
-#include "argHandler.h"
-#include "renderer.h"
+#include "actorhandler.h"
+#include "arghandler.h"
+#ifndef HEADLESS
+#   include "renderer.h"
+#endif
 
 // =================================================================================================
 
@@ -14,17 +16,19 @@ void CGameItems::Create (void) {
     m_viewer->SetupCamera ("viewer", 1.0, CVector (NAN, NAN, NAN), CVector (0, 0, 0));
     m_viewer->ForceRespawn ();
     actorHandler->SetViewer (m_viewer);
+#ifndef HEADLESS
     renderer->SetViewer (m_viewer);
 
     // player reticle
     m_reticle = CReticle ();
     m_reticle.Create ();
+#endif
 
     // create some player spheres for testing. These have no function besides being there, being targets, and respawning
     int dummies = argHandler->IntVal ("dummies", 0, 0);
     if (dummies > 0) {
-        auto min = [] (auto a, auto b) { (a < b) ? a : b; };
-        for (int i = min (dummies, int (actorHandler->m_maxPlayers) - 1); i; i--) {
+        auto min = [] (auto a, auto b) { return (a < b) ? a : b; };
+        for (int i = min (dummies, gameData->m_maxPlayers - 1); i; i--) {
             CPlayer* dummy = actorHandler->CreatePlayer ();
             dummy->SetType ("dummy");
         }
@@ -41,7 +45,7 @@ bool CGameItems::CreateMap (void) {
         fprintf (stderr, "Couldn't load map '%s'\n", mapName.Buffer ());
         exit (1);
     }
-    return false;
+    return true;
 }
 
 
@@ -57,7 +61,7 @@ bool CGameItems::CreateMap (CList<CString> stringMap, bool isPrepared) {
         fprintf (stderr, "Couldn't load map\n");
         exit (1);
     }
-    return false;
+    return true;
 }
 
 
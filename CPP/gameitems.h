@@ -3,11 +3,13 @@
 #include "cstring.h"
 #include "clist.h"
 #include "vector.h"
-#include "reticle.h"
+#ifndef HEADLESS
+#   include "reticle.h"
+#endif
 #include "map.h"
 #include "actor.h"
 #include "player.h"
-#include "actorHandler.h"
+#include "actorhandler.h"
 
 // =================================================================================================
 
@@ -15,7 +17,9 @@ class CGameItems {
 public:
     CMap*       m_map;
     CViewer*    m_viewer;
+#ifndef HEADLESS
     CReticle    m_reticle;
+#endif
 
     CGameItems () : m_map (nullptr), m_viewer (nullptr) {}
 
@@ -27,7 +31,9 @@ public:
 
     inline void Destroy (void) {
         m_map->Destroy ();
+#ifndef HEADLESS
         m_reticle.Destroy ();
+#endif
     }
 
     inline void Cleanup (void) {
@@ -0,0 +1,108 @@
+#include "interpolationbuffer.h"
+
+// =================================================================================================
+
+// angles are in the range of [-180, 180]. Take the shorter way around
+static inline float LerpAngle(float a0, float a1, float t) {
+    float d = a1 - a0;
+    if (d > 180.0f)
+        d -= 360.0f;
+    else if (d < -180.0f)
+        d += 360.0f;
+    float a = a0 + d * t;
+    return (a > 180.0f) ? a - 360.0f : (a < -180.0f) ? a + 360.0f : a;
+}
+
+
+static inline CVector LerpAngles(CVector& a0, CVector& a1, float t) {
+    return CVector(LerpAngle(a0.X(), a1.X(), t), LerpAngle(a0.Y(), a1.Y(), t), LerpAngle(a0.Z(), a1.Z(), t));
+}
+
+
+void CInterpolationBuffer::Add(uint32_t time, uint32_t sendTime, CVector& position, CVector& angles) {
+    if (m_count) {
+        CState& newest = State(0);
+        if (int(time - newest.m_time) < 0)   // the clock offset has been corrected (see CClockSync): don't corrupt the buffer
+            return;
+        if ((newest.m_position - position).Len() > MAX_INTERPOLATION_DISTANCE)
+            Reset();
+        else if (time == newest.m_time) {   // several states received at once: the last one wins
+            newest.m_sendTime = sendTime;
+            newest.m_position = position;
+            newest.m_angles = angles;
+            return;
+        }
+    }
+    m_newest = (m_newest + 1) % INTERPOLATION_BUFFER_SIZE;
+    CState& state = m_states[m_newest];
+    state.m_time = time;
+    state.m_sendTime = sendTime;
+    state.m_position = position;
+    state.m_angles = angles;
+    if (m_count < INTERPOLATION_BUFFER_SIZE)
+        m_count++;
+}
+
+
+bool CInterpolationBuffer::Sample(uint32_t time, CVector& position, CVector& angles) {
+    if (!m_count)
+        return false;
+    CState& newest = State(0);
+    int dt = int(time - newest.m_time);
+    if (dt >= 0) {
+        angles = newest.m_angles;
+        position = newest.m_position;
+        if ((m_count > 1) && dt) {  // extrapolate, assuming the actor keeps its velocity
+            CState& previous = State(1);
+            int span = int(newest.m_time - previous.m_time);
+            if (dt > MAX_EXTRAPOLATION)
+                dt = MAX_EXTRAPOLATION;
+            position += (newest.m_position - previous.m_position) * (float(dt) / float(span));
+        }
+        return true;
+    }
+    for (int i = 1; i < m_count; i++) {
+        CState& s0 = State(i);
+        if (int(time - s0.m_time) >= 0) {
+            CState& s1 = State(i - 1);
+            float t = float(time - s0.m_time) / float(s1.m_time - s0.m_time);
+            position = s0.m_position + (s1.m_position - s0.m_position) * t;
+            angles = LerpAngles(s0.m_angles, s1.m_angles, t);
+            return true;
+        }
+    }
+    CState& oldest = State(m_count - 1);   // the display delay is longer than the buffer reaches back
+    position = oldest.m_position;
+    angles = oldest.m_angles;
+    return true;
+}
+
+
+// the same cases as in Sample: extrapolation advances the owner's clock along with ours
+bool CInterpolationBuffer::SendTime(uint32_t time, uint32_t& sendTime) {
+    if (!m_count)
+        return false;
+    CState& newest = State(0);
+    int dt = int(time - newest.m_time);
+    if (dt >= 0) {
+        if (m_count == 1)
+            dt = 0;
+        else if (dt > MAX_EXTRAPOLATION)
+            dt = MAX_EXTRAPOLATION;
+        sendTime = newest.m_sendTime + uint32_t(dt);
+        return newest.m_sendTime != 0;
+    }
+    for (int i = 1; i < m_count; i++) {
+        CState& s0 = State(i);
+        if (int(time - s0.m_time) >= 0) {
+            CState& s1 = State(i - 1);
+            float t = float(time - s0.m_time) / float(s1.m_time - s0.m_time);
+            sendTime = s0.m_sendTime + uint32_t(float(int(s1.m_sendTime - s0.m_sendTime)) * t);
+            return (s0.m_sendTime != 0) && (s1.m_sendTime != 0);
+        }
+    }
+    sendTime = State(m_count - 1).m_sendTime;
+    return sendTime != 0;
+}
+
+// =================================================================================================
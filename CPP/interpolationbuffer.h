@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "vector.h"
+
+#define INTERPOLATION_BUFFER_SIZE   16      // received states kept per actor (well over a second at 30 network fps)
+#define MAX_EXTRAPOLATION           250     // [ms] max. time an actor keeps moving on its own when no new states arrive
+#define MAX_INTERPOLATION_DISTANCE  5.0f    // positions farther apart are considered a teleport (e.g. respawn) && not blended
+
+// =================================================================================================
+// Jitter buffer of the timestamped states received for a remote actor
+//
+// Instead of jumping to every state as it arrives, remote actors are displayed at a fixed delay in the past
+// (see CNetworkHandler::m_interpolationDelay), interpolating between the two states received around that time.
+// This hides uneven packet arrival && lost packets. If the newest state is older than the display time, the
+// actor's movement is extrapolated for at most MAX_EXTRAPOLATION ms.
+
+class CInterpolationBuffer {
+    public:
+        class CState {
+            public:
+                uint32_t    m_time;     // [ms] time of arrival (see CNetworkHandler::ApplyUpdate)
+                uint32_t    m_sendTime; // [ms] match time the owner has sent the state at (0: unknown)
+                CVector     m_position;
+                CVector     m_angles;
+        };
+
+        CState      m_states[INTERPOLATION_BUFFER_SIZE];
+        int         m_count;
+        int         m_newest;
+
+        CInterpolationBuffer() : m_count(0), m_newest(-1) {}
+
+        inline void Reset(void) {
+            m_count = 0;
+            m_newest = -1;
+        }
+
+        inline bool Empty(void) {
+            return m_count == 0;
+        }
+
+        void Add(uint32_t time, uint32_t sendTime, CVector& position, CVector& angles);
+
+        // compute position && angles at the given time. Returns false if the buffer is empty
+        bool Sample(uint32_t time, CVector& position, CVector& angles);
+
+        // time on the owner's clock of the state displayed at the given time, i.e. the time the owner has had the
+        // position Sample yields. Returns false if unknown
+        bool SendTime(uint32_t time, uint32_t& sendTime);
+
+        // most recently received state. Returns false if the buffer is empty
+        inline bool Newest(CVector& position, CVector& angles) {
+            if (!m_count)
+                return false;
+            position = m_states[m_newest].m_position;
+            angles = m_states[m_newest].m_angles;
+            return true;
+        }
+
+    private:
+        // i-th newest state (0: newest)
+        inline CState& State(int i) {
+            return m_states[(m_newest - i + INTERPOLATION_BUFFER_SIZE) % INTERPOLATION_BUFFER_SIZE];
+        }
+};
+
+// =================================================================================================
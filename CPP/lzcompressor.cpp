@@ -0,0 +1,126 @@
+#include <string.h>
+
+#include "lzcompressor.h"
+
+// =================================================================================================
+
+static inline uint32_t Read32(const uint8_t* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+
+static inline uint32_t Hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);    // Knuth's multiplicative hash
+}
+
+
+uint8_t* CLZCompressor::WriteLength(uint8_t* output, size_t length) {
+    for (; length >= 255; length -= 255)
+        *output++ = 255;
+    *output++ = uint8_t(length);
+    return output;
+}
+
+
+void CLZCompressor::Compress(const uint8_t* data, size_t length, CString& compressed) {
+    int32_t positions[1 << LZ_HASH_BITS];
+    for (int i = 0; i < (1 << LZ_HASH_BITS); i++)
+        positions[i] = -1;
+    compressed.Reserve(length + length / 255 + 16);    // incompressible data: one token plus literal count extensions
+    uint8_t* output = (uint8_t*) compressed.Buffer();
+    uint8_t* start = output;
+    size_t anchor = 0;      // first byte not encoded yet
+    size_t i = 0;
+    for (;;) {
+        size_t matchLength = 0;
+        size_t offset = 0;
+        while (i + LZ_MIN_MATCH <= length) {
+            uint32_t sequence = Read32(data + i);
+            uint32_t h = Hash(sequence);
+            int32_t candidate = positions[h];
+            positions[h] = int32_t(i);
+            if ((candidate >= 0) && (i - size_t(candidate) <= LZ_MAX_OFFSET) && (Read32(data + candidate) == sequence)) {
+                offset = i - size_t(candidate);
+                for (matchLength = LZ_MIN_MATCH; (i + matchLength < length) && (data[candidate + matchLength] == data[i + matchLength]); matchLength++)
+                    ;
+                break;
+            }
+            i++;
+        }
+        if (!matchLength)
+            i = length;
+        size_t literals = i - anchor;
+        size_t extraLength = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+        *output++ = uint8_t(((literals < 15) ? literals : 15) << 4) | uint8_t((extraLength < 15) ? extraLength : 15);
+        if (literals >= 15)
+            output = WriteLength(output, literals - 15);
+        memcpy(output, data + anchor, literals);
+        output += literals;
+        if (!matchLength)
+            break;
+        *output++ = uint8_t(offset);
+        *output++ = uint8_t(offset >> 8);
+        if (extraLength >= 15)
+            output = WriteLength(output, extraLength - 15);
+        i += matchLength;
+        anchor = i;
+    }
+    size_t compressedLength = size_t(output - start);
+    compressed.Buffer()[compressedLength] = '\0';
+    compressed.SetLength(compressedLength);
+}
+
+
+bool CLZCompressor::ReadLength(const uint8_t* data, size_t length, size_t& offset, size_t& value) {
+    uint8_t b;
+    do {
+        if (offset >= length)
+            return false;
+        b = data[offset++];
+        value += b;
+    } while (b == 255);
+    return true;
+}
+
+
+// all lengths && offsets are checked, as the data comes from the network
+bool CLZCompressor::Decompress(const uint8_t* data, size_t length, size_t originalLength, CString& decompressed) {
+    decompressed.Reserve(originalLength + 1);
+    uint8_t* output = (uint8_t*) decompressed.Buffer();
+    size_t written = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t token = data[i++];
+        size_t literals = token >> 4;
+        if ((literals == 15) && !ReadLength(data, length, i, literals))
+            return false;
+        if ((literals > length - i) || (literals > originalLength - written))
+            return false;
+        memcpy(output + written, data + i, literals);
+        i += literals;
+        written += literals;
+        if (i == length)    // the last token
+            break;
+        if (length - i < 2)
+            return false;
+        size_t offset = size_t(data[i]) | (size_t(data[i + 1]) << 8);
+        i += 2;
+        size_t matchLength = token & 15;
+        if ((matchLength == 15) && !ReadLength(data, length, i, matchLength))
+            return false;
+        matchLength += LZ_MIN_MATCH;
+        if ((offset == 0) || (offset > written) || (matchLength > originalLength - written))
+            return false;
+        for (const uint8_t* match = output + written - offset; matchLength; matchLength--)   // byte by byte, since runs overlap
+            output[written++] = *match++;
+    }
+    if (written != originalLength)
+        return false;
+    output[written] = '\0';
+    decompressed.SetLength(written);
+    return true;
+}
+
+// =================================================================================================
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "cstring.h"
+
+#define LZ_MIN_MATCH        4       // shortest match worth encoding
+#define LZ_MAX_OFFSET       0xFFFF  // matches are searched this many bytes back at most
+#define LZ_HASH_BITS        12
+
+// =================================================================================================
+// Lightweight LZ77 compression of messages (LZ4 style block format)
+//
+// The compressed data is a sequence of tokens:
+//   <token (byte)>[<literal count extension>]<literals>[<match offset (uint16)>[<match length extension>]]
+// The token's high nibble is the number of literals following it, its low nibble the match length minus
+// LZ_MIN_MATCH. A nibble value of 15 is continued by extension bytes that are added to it, up to && including the
+// first byte that isn't 255. The match is copied from offset bytes back in the decompressed data && may overlap
+// the data it produces (runs). The last token only has literals.
+// Matches are found through a hash table of the positions of the most recent 4 byte sequences: That doesn't find the
+// best matches, but it is fast && needs neither an external library, nor more memory than the table.
+
+class CLZCompressor {
+    public:
+        // compress length bytes of data. The compressed data may be longer than the data (incompressible data)
+        static void Compress(const uint8_t* data, size_t length, CString& compressed);
+
+        // decompress data that decompresses to exactly originalLength bytes. Returns false if the data is malformed
+        static bool Decompress(const uint8_t* data, size_t length, size_t originalLength, CString& decompressed);
+
+    private:
+        static uint8_t* WriteLength(uint8_t* output, size_t length);
+
+        static bool ReadLength(const uint8_t* data, size_t length, size_t& offset, size_t& value);
+};
+
+// =================================================================================================
@@ -1,7 +1,11 @@
+#include <algorithm>
+
 #include "map.h"
-#include "gameData.h"
-#include "actorHandler.h"
-#include "argHandler.h"
+#include "gamedata.h"
+#include "actorhandler.h"
+#include "arghandler.h"
+
+#define MAX_SPAWN_ATTEMPTS  1000    // random segments tried before the least crowded one is taken
 
 // =================================================================================================
 
@@ -11,6 +15,8 @@ CMap::CMap (CList<CString> textureNames, CVector color, int distanceQuality)
 }
 
 
+#ifndef HEADLESS
+
 // create a floor or ceiling quad using the specified texture
 CQuad* CMap::CreateQuad(float y, CTexture* texture, CVector color, CQuad* q) {
     *q = CQuad ({ CVector(m_vMin.X(), y, m_vMin.Z()), CVector(m_vMin.X(), y, m_vMax.Z()), CVector(m_vMax.X(), y, m_vMax.Z()), CVector(m_vMax.X(), y, m_vMin.Z()) }, texture, color);
@@ -18,10 +24,14 @@ CQuad* CMap::CreateQuad(float y, CTexture* texture, CVector color, CQuad* q) {
     return q;
 }
 
+#endif
+
 
 void CMap::Translate (CVector t) {
+#ifndef HEADLESS
     for (auto [i, v] : m_mesh.m_vertices.m_appData)
         v += t;
+#endif
     for (auto [i, w] : m_walls)
         w.Translate (t);
 }
@@ -32,21 +42,29 @@ void CMap::Build(void) {
     m_vMin.Z() = -m_vMin.Z();
     m_vMax.Z() = -m_vMax.Z();
     Translate(CVector(0, 0, m_vMax.Z()));        // translate the map into the view space
+    m_segmentMap.Build(m_stringMap, m_walls, m_scale);  // create the segment structure
+#ifndef HEADLESS
     CreateQuad (m_vMin.Y (), GetTexture (1), CVector (1, 1, 1), &m_floor);
     CreateQuad (m_vMax.Y (), GetTexture (2), CVector (1, 1, 1), &m_ceiling);
-    m_segmentMap.Build(m_stringMap, m_walls, m_scale);  // create the segment structure
     CreateVAO();
+#endif
 }
 
 
 void CMap::Destroy(void) {
+#ifndef HEADLESS
     m_floor.Destroy ();
     m_ceiling.Destroy ();
     CMapData::Destroy();
     m_mesh.Destroy();
+#else
+    CMapData::Destroy();
+#endif
 }
 
 
+#ifndef HEADLESS
+
 void CMap::Render(void) {
     glDisable(GL_CULL_FACE);
 #if 1
@@ -71,12 +89,14 @@ void CMap::Render(void) {
     glEnable(GL_CULL_FACE);
 }
 
+#endif
+
 
 auto CMap::SegmentAt(CVector position) {
     struct retVals {
         int x, y;
     };
-    auto Clamp = [](auto val, auto minVal, auto maxVal) { return max (min (minVal, maxVal), min (val, max (minVal, maxVal))); };
+    auto Clamp = [](auto val, auto minVal, auto maxVal) { return std::max (std::min (minVal, maxVal), std::min (val, std::max (minVal, maxVal))); };
     return retVals{
         Clamp (int(position.X()) / int(m_scale), 0, Width() - 1), 
         Clamp (m_segmentMap.m_height + int(position.Z() / m_scale) - 1, 0, Height() - 1) 
@@ -84,6 +104,12 @@ auto CMap::SegmentAt(CVector position) {
 }
 
 
+int CMap::SegmentIdAt(CVector position) {
+    auto [x, y] = SegmentAt(position);
+    return SegPosToId(x, y);
+}
+
+
 // gather all walls #include "the segment a potentially colliding object sits in plus all walls
 // #include "the diagonally adjacent segments (this will yield all relevant walls without duplicates)
 size_t CMap::GetNearbyWalls(CVector position, CList<CWall*>& walls) {
@@ -135,21 +161,38 @@ float CMap::FindSpawnAngle(CMapSegment& s) {
 
 
 // find a random spawn position by looking for a segment that is not inaccessible and has no actors inside it
+// a random free segment. If there are more players than free segments (e.g. many players on a small map), the least
+// crowded segment is shared instead of searching forever
 void CMap::FindSpawnPosition(CActor* actor) {
     // actor.needSpawnPosition = false
     // return
-    for (;;) {
-        auto [x, y] = RandomSegment();
-        CMapSegment& s = m_segmentMap.m_segments[y][x];
+    int x = -1, y = -1;
+    for (int i = 0; (i < MAX_SPAWN_ATTEMPTS) && (x < 0); i++) {
+        auto [rx, ry] = RandomSegment();
+        CMapSegment& s = m_segmentMap.m_segments[ry][rx];
         if (s.m_connections && !s.m_actorCount) {
-            m_segmentMap.CountActorAt(x, y);
-            actor->SetPosition(s.m_center);
-            actor->m_camera.BumpPosition();
-            actor->m_camera.SetOrientation (CVector (0, FindSpawnAngle (s), 0));
-            actor->m_needPosition = false;
-            return;
+            x = rx;
+            y = ry;
         }
     }
+    if (x < 0) {
+        for (int sy = 0; sy < m_segmentMap.m_height; sy++)
+            for (int sx = 0; sx < m_segmentMap.m_width; sx++) {
+                CMapSegment& s = m_segmentMap.m_segments[sy][sx];
+                if (s.m_connections && ((x < 0) || (s.m_actorCount < m_segmentMap.m_segments[y][x].m_actorCount))) {
+                    x = sx;
+                    y = sy;
+                }
+            }
+        if (x < 0)  // nowhere to walk
+            return;
+    }
+    CMapSegment& s = m_segmentMap.m_segments[y][x];
+    m_segmentMap.CountActorAt(x, y);
+    actor->SetPosition(s.m_center);
+    actor->m_camera.BumpPosition();
+    actor->m_camera.SetOrientation (CVector (0, FindSpawnAngle (s), 0));
+    actor->m_needPosition = false;
 }
 
 
@@ -179,9 +222,22 @@ float CMap::Distance(CVector v0, CVector v1) {
 }
 
 
+int CMap::Interest(CVector v0, CVector v1, float audibleDistance) {
+    if (!m_segmentMap.HaveVisibilityTable() || !v0.IsValid() || !v1.IsValid())
+        return 2;
+    auto p0 = SegmentAt(v0);
+    auto p1 = SegmentAt(v1);
+    if (m_segmentMap.IsVisible(SegPosToId(p0.x, p0.y), SegPosToId(p1.x, p1.y)))
+        return 2;
+    return (Distance(v0, v1) <= audibleDistance) ? 1 : 0;
+}
+
+
 // add a vertex to the vertex list && update map boundaries
 void CMap::AddVertex (CVector v) {
+#ifndef HEADLESS
     m_mesh.m_vertices.Append (v);
+#endif
     m_vMin.Minimize (v);
     m_vMax.Maximize (v);
     m_vertexCount++;
@@ -6,10 +6,12 @@
 #include "vector.h"
 #include "plane.h"
 #include "texcoord.h"
-#include "vertexdatabuffers.h"
-#include "quad.h"
-#include "vao.h"
-#include "mesh.h"
+#ifndef HEADLESS
+#   include "vertexdatabuffers.h"
+#   include "quad.h"
+#   include "vao.h"
+#   include "mesh.h"
+#endif
 #include "actor.h"
 #include "mapdata.h"
 #include "mapsegments.h"
@@ -34,12 +36,13 @@ class CMap : public CMapData {
 
         void Destroy(void);
 
-        CQuad* CreateQuad(float y, CTexture* texture, CVector color, CQuad * q);
-
         void Translate (CVector t);
 
         void Build(void);
 
+#ifndef HEADLESS    // the dedicated server only needs the walls && segments
+        CQuad* CreateQuad(float y, CTexture* texture, CVector color, CQuad * q);
+
         inline void CreateVAO(void) {
             m_mesh.CreateVAO();
         }
@@ -81,9 +84,13 @@ class CMap : public CMapData {
 
 
         void Render(void);
+#endif
 
         auto SegmentAt (CVector position);
 
+        // id of the segment position lies in
+        int SegmentIdAt(CVector position);
+
 
         CVector SegmentCenter(int x, int y) {
             return m_segmentMap.SegmentCenter(x, y, m_scale);
@@ -116,7 +123,7 @@ class CMap : public CMapData {
 
         // compute a segment's 2D coordinate in the segment map #include "its linearized coordinate
         inline int SegPosToId(int x, int y) {
-            return y * m_segmentMap.m_height + x;
+            return y * m_segmentMap.m_width + x;
         }
 
 
@@ -156,6 +163,10 @@ class CMap : public CMapData {
         // in the path between the actors to the distance #include "the segment distance table
         float Distance(CVector v0, CVector v1);
 
+        // how much an actor at v1 matters to a player at v0: 2 if there is a los between their segments, 1 if the 
+        // actor is within the audible path distance, 0 if neither. Without los data, everything is visible.
+        int Interest(CVector v0, CVector v1, float audibleDistance);
+
         // add a vertex to the vertex list && update map boundaries
         void AddVertex (CVector v);
 
@@ -1,6 +1,8 @@
 #include "mapdata.h"
-#include "textureHandler.h"
-#include "argHandler.h"
+#ifndef HEADLESS
+#   include "texturehandler.h"
+#endif
+#include "arghandler.h"
 
 // =================================================================================================
 
@@ -19,7 +21,9 @@ void CMapData::Init(void) {
     m_vMin = CVector (1e6, 1e6, 1e6);
     m_vMax = CVector (-1e6, -1e6, -1e6);
     m_vertexCount = 0;
+#ifndef HEADLESS
     m_mesh.Init (GL_QUADS, m_textures[0], CList<CString>());
+#endif
     m_segmentMap = CSegmentMap(m_scale, m_distanceQuality);
 }
 
@@ -27,13 +31,17 @@ void CMapData::Init(void) {
 // create all textures required for map rendering (walls, floor, ceiling)
 void CMapData::SetupTextures(CList<CString>textureNames) {
     m_textures.Destroy();
+#ifndef HEADLESS
     m_textures = textureHandler->CreateTextures(textureNames);
+#endif
 }
 
 
 void CMapData::Destroy(void) {
     m_walls.Destroy();
+#ifndef HEADLESS
     m_mesh.Destroy();
+#endif
     m_stringMap.Destroy();
     m_segmentMap.Destroy();
 }
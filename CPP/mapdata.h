@@ -4,8 +4,12 @@
 #include "carray.h"
 #include "clist.h"
 #include "vector.h"
-#include "quad.h"
-#include "mesh.h"
+#ifndef HEADLESS
+#   include "quad.h"
+#   include "mesh.h"
+#else
+class CTexture;
+#endif
 #include "mapsegments.h"
 
 // =================================================================================================
@@ -13,9 +17,11 @@
 class CMapData {
     public:
         CList<CWall>            m_walls;
+#ifndef HEADLESS
         CQuad                   m_floor;
         CQuad                   m_ceiling;
         CMesh                   m_mesh;
+#endif
         CVector                 m_color;
         CVector                 m_vMin;             // map boundaries
         CVector                 m_vMax;
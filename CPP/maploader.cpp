@@ -46,7 +46,9 @@ bool CMapLoader::CreateFromMemory (CList<CString>& stringMap, bool isPrepared) {
 
 // add a vertex to the vertex list && update map boundaries
 void CMapLoader::AddVertex (CVector v) {
+#ifndef HEADLESS
     m_map->m_mesh.m_vertices.Append (v);
+#endif
     m_map->m_vMin.Minimize (v);
     m_map->m_vMax.Maximize (v);
     m_map->m_vertexCount++;
@@ -54,7 +56,9 @@ void CMapLoader::AddVertex (CVector v) {
 
 
 void CMapLoader::AddTexCoords (void) {
+#ifndef HEADLESS
     m_map->m_mesh.m_texCoords.m_appData += m_quadTexCoords;
+#endif
 }
 
 
@@ -81,7 +85,7 @@ void CMapLoader::ParseError (CString& rowString, int row, int col, const char* e
             rowString [i] = '.';
     fprintf (stderr, "%s\n", rowString.Buffer ());
     char fmt [20];
-    sprintf_s (fmt, sizeof (fmt), "%%%dc\n", col);
+    snprintf (fmt, sizeof (fmt), "%%%dc\n", col);
     fprintf (stderr, fmt, '^');
     fprintf (stderr, "invalid map data in line %d (expected %s, found '%c')\n", row + 1, expected, found);
 }
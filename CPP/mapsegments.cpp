@@ -64,6 +64,7 @@ void CSegmentMap::Destroy(void) {
     m_pathEdgeList.Destroy();
     m_pathEdgeTable.Destroy();
     m_distanceTable.Destroy ();
+    m_visibilityTable.Destroy();
     m_segments.Destroy();
     m_height = 
     m_width = 
@@ -122,11 +123,17 @@ void CSegmentMap::Build(CList<CString>& stringMap, CList<CWall>& walls, float sc
     }
     CreatePathNodes(scale);
     if (m_distanceQuality == 1) {
-        m_distanceScale = 1000;
+        // a route visits each segment at most once, so this keeps the cost of even the longest route within 16 bits
+        m_distanceScale = int (float (router.MaxCost ()) / (float (m_size) * scale * 2.0f));
+        if (m_distanceScale > 1000)
+            m_distanceScale = 1000;
+        else if (m_distanceScale < 1)
+            m_distanceScale = 1;
         // if path edge lengths are too great for the router, CreatePathEdges will adjust the distance scale 
         // and then needs to be run again. This should only happen once.
         while (!CreatePathEdges (walls))
             ResetPathData ();
+        CreateVisibilityTable();
         CreateDistanceTable();
     }
 }
@@ -299,6 +306,17 @@ void CSegmentMap::CreateDistanceTable(void) {
 }
 
 
+// flatten the path edges into a table telling for each pair of segments whether there is a los between them,
+// so that los queries (see CMap::Interest) don't need to search the segments' path edge lists
+void CSegmentMap::CreateVisibilityTable(void) {
+    m_visibilityTable.Create(m_size * m_size);
+    m_visibilityTable.Clear();
+    for (int i = 0; i < m_size; i++)
+        for (auto [j, edgeId] : (*this)[i].m_pathEdgeIds)
+            m_visibilityTable[i * m_size + m_pathEdgeTable[edgeId].m_segmentId] = 1;
+}
+
+
 // reset the actor count in each segment that had previously been computed
 void CSegmentMap::ResetActorCounts(void) {
     for (auto row : m_segments)
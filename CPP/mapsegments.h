@@ -149,6 +149,7 @@ class CSegmentMap {
         CArray<CSegmentPathEdge>        m_pathEdgeTable;
         CArray<CArray<CMapSegment>>     m_segments;
         CArray<CArray<CRouteData>>      m_distanceTable;
+        CArray<uint8_t>                 m_visibilityTable;  // m_size x m_size, non zero where two segments have a los
         int                             m_height;
         int                             m_width;
         int                             m_size;
@@ -212,6 +213,8 @@ class CSegmentMap {
 
         void CreateDistanceTable(void);
 
+        void CreateVisibilityTable(void);
+
         void ResetPathData (void);
 
         void ResetActorCounts(void);
@@ -228,6 +231,15 @@ class CSegmentMap {
             return m_distanceTable[i][j];
         }
 
+        // the table only exists if path edges have been created (distance quality 1)
+        inline bool HaveVisibilityTable(void) {
+            return m_visibilityTable.Length() > 0;
+        }
+
+        inline bool IsVisible(int i, int j) {
+            return (i == j) || (m_visibilityTable[i * m_size + j] != 0);
+        }
+
 };
 
 // =================================================================================================
@@ -1,5 +1,5 @@
 #include "mesh.h"
-#include "textureHandler.h"
+#include "texturehandler.h"
 
 // =================================================================================================
 
@@ -0,0 +1,237 @@
+#include <string.h>
+
+#include "SDL.h"
+#include "networkcapture.h"
+
+// =================================================================================================
+
+static const char captureSignature[] = "SMICAP";
+
+static inline void PutUInt16(uint8_t* buffer, uint16_t value) {
+    buffer[0] = uint8_t(value);
+    buffer[1] = uint8_t(value >> 8);
+}
+
+
+static inline void PutUInt32(uint8_t* buffer, uint32_t value) {
+    PutUInt16(buffer, uint16_t(value));
+    PutUInt16(buffer + 2, uint16_t(value >> 16));
+}
+
+
+static inline uint16_t GetUInt16(const uint8_t* buffer) {
+    return uint16_t(buffer[0] | (buffer[1] << 8));
+}
+
+
+static inline uint32_t GetUInt32(const uint8_t* buffer) {
+    return uint32_t(GetUInt16(buffer)) | (uint32_t(GetUInt16(buffer + 2)) << 16);
+}
+
+// =================================================================================================
+
+CCaptureWriter::CCaptureWriter() : m_file(nullptr), m_startTime(0), m_recordCount(0) {
+    m_lock = SDL_CreateMutex();
+}
+
+
+CCaptureWriter::~CCaptureWriter() {
+    Close();
+    if (m_lock) {
+        SDL_DestroyMutex(m_lock);
+        m_lock = nullptr;
+    }
+}
+
+
+bool CCaptureWriter::Open(CString fileName) {
+    Close();
+    m_file = fopen(fileName.Buffer(), "wb");
+    if (!m_file) {
+        fprintf(stderr, "Cannot create capture file '%s'\n", fileName.Buffer());
+        return false;
+    }
+    fwrite(captureSignature, 1, 6, m_file);
+    fputc(CAPTURE_VERSION, m_file);
+    m_startTime = SDL_GetTicks();
+    m_recordCount = 0;
+    return true;
+}
+
+
+void CCaptureWriter::Close(void) {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+
+void CCaptureWriter::Write(uint8_t direction, const uint8_t* data, size_t length, CString& address, uint16_t port) {
+    if (!m_file)
+        return;
+    size_t addressLength = address.Length();
+    if (addressLength > 255)
+        addressLength = 255;
+    if (length > 65535)
+        length = 65535;
+    uint8_t header[8];
+    SDL_mutexP(m_lock);
+    PutUInt32(header, SDL_GetTicks() - m_startTime);
+    header[4] = direction;
+    PutUInt16(header + 5, port);
+    header[7] = uint8_t(addressLength);
+    fwrite(header, 1, 8, m_file);
+    fwrite(address.Buffer(), 1, addressLength, m_file);
+    PutUInt16(header, uint16_t(length));
+    fwrite(header, 1, 2, m_file);
+    fwrite(data, 1, length, m_file);
+    m_recordCount++;
+    SDL_mutexV(m_lock);
+}
+
+// =================================================================================================
+
+bool CCaptureReader::Open(CString fileName) {
+    Close();
+    m_file = fopen(fileName.Buffer(), "rb");
+    if (!m_file) {
+        fprintf(stderr, "Cannot open capture file '%s'\n", fileName.Buffer());
+        return false;
+    }
+    char header[7];
+    if ((fread(header, 1, 7, m_file) != 7) || memcmp(header, captureSignature, 6) || (header[6] != CAPTURE_VERSION)) {
+        fprintf(stderr, "'%s' is not a capture file of this version\n", fileName.Buffer());
+        Close();
+        return false;
+    }
+    return true;
+}
+
+
+void CCaptureReader::Close(void) {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+
+bool CCaptureReader::Read(CCaptureRecord& record) {
+    if (!m_file)
+        return false;
+    uint8_t header[8];
+    if (fread(header, 1, 8, m_file) != 8)
+        return false;
+    record.m_time = GetUInt32(header);
+    record.m_direction = header[4];
+    record.m_port = GetUInt16(header + 5);
+    char address[256];
+    size_t addressLength = header[7];
+    if (fread(address, 1, addressLength, m_file) != addressLength)
+        return false;
+    record.m_address.Assign(address, addressLength);
+    if (fread(header, 1, 2, m_file) != 2)
+        return false;
+    uint8_t data[65536];
+    size_t length = GetUInt16(header);
+    if (fread(data, 1, length, m_file) != length)
+        return false;
+    record.m_data.Assign((char*) data, length);
+    return true;
+}
+
+// =================================================================================================
+
+bool CCaptureTransport::Open(CString localAddress, uint16_t localPort) {
+    m_localAddress = localAddress;
+    m_localPort = localPort;
+    return m_isValid = m_transport->Open(localAddress, localPort);
+}
+
+
+void CCaptureTransport::Close(void) {
+    m_transport->Close();
+    m_isValid = false;
+}
+
+
+bool CCaptureTransport::Send(const uint8_t* data, size_t length, CString& address, uint16_t port) {
+    m_writer->Write(1, data, length, address, port);
+    return m_transport->Send(data, length, address, port);
+}
+
+
+bool CCaptureTransport::Receive(CString& data, CString& address, uint16_t& port) {
+    if (!m_transport->Receive(data, address, port))
+        return false;
+    m_writer->Write(0, (uint8_t*) data.Buffer(), data.Length(), address, port);
+    return true;
+}
+
+// =================================================================================================
+
+bool CReplayTransport::Open(CString localAddress, uint16_t localPort) {
+    m_localAddress = localAddress;
+    m_localPort = localPort;
+    if (!m_fileName.Empty() && !m_reader.Open(m_fileName))
+        return m_isValid = false;
+    m_startTime = SDL_GetTicks();
+    m_replayed = 0;
+    ReadAhead();
+    return m_isValid = true;
+}
+
+
+void CReplayTransport::Close(void) {
+    m_reader.Close();
+    m_havePending = false;
+    m_isValid = false;
+}
+
+
+void CReplayTransport::ReadAhead(void) {
+    do
+        m_havePending = m_reader.Read(m_record);
+    while (m_havePending && (m_record.m_direction != 0));
+}
+
+
+int CReplayTransport::TimeToNext(void) {
+    if (m_speed <= 0.0f)
+        return 0;
+    int due = int(float(m_record.m_time) / m_speed);
+    return due - int(SDL_GetTicks() - m_startTime);
+}
+
+
+bool CReplayTransport::Receive(CString& data, CString& address, uint16_t& port) {
+    if (!m_havePending || (TimeToNext() > 0))
+        return false;
+    data = m_record.m_data;
+    address = m_record.m_address;
+    port = m_record.m_port;
+    m_replayed++;
+    ReadAhead();
+    return true;
+}
+
+
+// the datagrams are only due at certain times, so waiting is done in short steps to notice Wakeup()
+bool CReplayTransport::Wait(int timeout) {
+    uint32_t start = SDL_GetTicks();
+    for (;;) {
+        if (m_havePending && (TimeToNext() <= 0))
+            return true;
+        if (m_wakeup.exchange(false))
+            return false;
+        int wait = (timeout < 0) ? 10 : timeout - int(SDL_GetTicks() - start);
+        if (wait <= 0)
+            return false;
+        if (m_havePending && (TimeToNext() < wait))
+            wait = TimeToNext();
+        SDL_Delay(uint32_t((wait < 10) ? wait : 10));
+    }
+}
+
+// =================================================================================================
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+
+#include "SDL_mutex.h"
+#include "cstring.h"
+#include "transport.h"
+
+#define CAPTURE_VERSION     1
+
+// =================================================================================================
+// Network capture && replay
+//
+// CCaptureTransport records every datagram the transport it wraps receives || sends, together with the time [ms since
+// the capture has been started], the peer's address && port, into a binary capture file. Both of CUDP's sockets
+// record into the same file (see CCaptureWriter), so the file holds a session's complete traffic in the order it
+// has been seen.
+//
+// CReplayTransport reads a capture file && hands out the datagrams received during the capture as if they had just
+// arrived, at the original speed || faster, without any sockets. Datagrams sent while replaying are dropped; those
+// sent during the capture are kept in the file so that the responses to a replayed session can be compared with the
+// original ones. The instance replaying a capture must use the network settings (local address, ports) of the one
+// that has recorded it, || the recorded peers won't recognize it.
+//
+// File format (all values little endian):
+//   header: "SMICAP", version (uint8)
+//   record: time (uint32), direction (uint8, 0: received, 1: sent), port (uint16), address length (uint8), address,
+//           data length (uint16), data
+
+// =================================================================================================
+
+class CCaptureRecord {
+    public:
+        uint32_t    m_time;
+        uint8_t     m_direction;    // 0: received, 1: sent
+        uint16_t    m_port;
+        CString     m_address;
+        CString     m_data;
+
+        CCaptureRecord() : m_time(0), m_direction(0), m_port(0) {}
+};
+
+// =================================================================================================
+
+class CCaptureWriter {
+    public:
+        FILE*       m_file;
+        SDL_mutex*  m_lock;         // datagrams are received by the listener thread && sent by the main thread
+        uint32_t    m_startTime;
+        uint32_t    m_recordCount;
+
+        CCaptureWriter();
+
+        ~CCaptureWriter();
+
+        bool Open(CString fileName);
+
+        void Close(void);
+
+        void Write(uint8_t direction, const uint8_t* data, size_t length, CString& address, uint16_t port);
+
+        inline bool IsOpen(void) {
+            return m_file != nullptr;
+        }
+};
+
+// =================================================================================================
+
+class CCaptureReader {
+    public:
+        FILE*       m_file;
+
+        CCaptureReader() : m_file(nullptr) {}
+
+        ~CCaptureReader() {
+            Close();
+        }
+
+        bool Open(CString fileName);
+
+        void Close(void);
+
+        // returns false at the end of the file || if the file is damaged
+        bool Read(CCaptureRecord& record);
+};
+
+// =================================================================================================
+// Record the datagrams another transport receives && sends
+
+class CCaptureTransport : public CTransport {
+    public:
+        CTransport*     m_transport;
+        CCaptureWriter* m_writer;
+
+        // takes ownership of transport, but not of writer
+        CCaptureTransport(CTransport* transport, CCaptureWriter* writer) : m_transport(transport), m_writer(writer) {}
+
+        ~CCaptureTransport() {
+            delete m_transport;
+        }
+
+        virtual bool Open(CString localAddress, uint16_t localPort);
+
+        virtual void Close(void);
+
+        using CTransport::Send;
+
+        virtual bool Send(const uint8_t* data, size_t length, CString& address, uint16_t port);
+
+        virtual void BeginBatch(void) {
+            m_transport->BeginBatch();
+        }
+
+        virtual bool SendBatch(void) {
+            return m_transport->SendBatch();
+        }
+
+        virtual bool Receive(CString& data, CString& address, uint16_t& port);
+
+        virtual bool Wait(int timeout) {
+            return m_transport->Wait(timeout);
+        }
+
+        virtual void Wakeup(void) {
+            m_transport->Wakeup();
+        }
+};
+
+// =================================================================================================
+// Hand out the datagrams received during a capture
+
+class CReplayTransport : public CTransport {
+    public:
+        CString             m_fileName;     // empty: nothing to replay (sending socket)
+        float               m_speed;        // 1: original speed, 0: as fast as possible
+        CCaptureReader      m_reader;
+        CCaptureRecord      m_record;       // next datagram to hand out
+        bool                m_havePending;
+        uint32_t            m_startTime;
+        uint32_t            m_replayed;     // datagrams handed out so far
+        std::atomic<bool>   m_wakeup;
+
+        CReplayTransport(CString fileName = CString(""), float speed = 1.0f)
+            : m_fileName(fileName), m_speed(speed), m_havePending(false), m_startTime(0), m_replayed(0), m_wakeup(false) {}
+
+        virtual bool Open(CString localAddress, uint16_t localPort);
+
+        virtual void Close(void);
+
+        using CTransport::Send;
+
+        virtual bool Send(const uint8_t* data, size_t length, CString& address, uint16_t port) {
+            return m_isValid;
+        }
+
+        virtual bool Receive(CString& data, CString& address, uint16_t& port);
+
+        virtual bool Wait(int timeout);
+
+        virtual void Wakeup(void) {
+            m_wakeup = true;
+        }
+
+        // all datagrams of the capture have been handed out
+        inline bool Finished(void) {
+            return !m_havePending;
+        }
+
+    private:
+        // read the next received datagram of the capture
+        void ReadAhead(void);
+
+        // [ms] until the pending datagram is due
+        int TimeToNext(void);
+};
+
+// =================================================================================================
@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "SDL.h"
+#include "networkchannel.h"
+
+// =================================================================================================
+
+static inline int SequenceDistance(uint16_t s1, uint16_t s2) {
+    return int16_t(s1 - s2);
+}
+
+
+void CReliableChannel::Reset(void) {
+    do
+        m_session = uint16_t(rand() ^ SDL_GetTicks());
+    while (m_session == 0);
+    m_nextSequence = 1;
+    m_oldestUnacked = 1;
+    for (int i = 0; i < RELIABLE_WINDOW; i++) {
+        m_sent[i].m_inUse = false;
+        m_received[i].m_isValid = false;
+    }
+    m_queue.Destroy();
+    m_srtt = -1.0f;
+    m_rttVar = 0.0f;
+    m_rto = INITIAL_RTO;
+    m_resends = 0;
+    m_peerSession = 0;
+    m_expected = 1;
+    m_ackPending = false;
+}
+
+
+bool CReliableChannel::Send(const uint8_t* data, size_t length) {
+    if (RecordSize(length) > MAX_PACKET_SIZE - PACKET_HEADER_SIZE)
+        return false;
+    m_queue.Append(CString((char*) data, int(length)));
+    FillWindow();
+    return true;
+}
+
+
+void CReliableChannel::FillWindow(void) {
+    while (!m_queue.Empty() && (uint16_t(m_nextSequence - m_oldestUnacked) < RELIABLE_WINDOW)) {
+        CSentMessage& message = m_sent[m_nextSequence % RELIABLE_WINDOW];
+        message.m_data = m_queue.Pop(0);
+        message.m_sequence = m_nextSequence++;
+        message.m_sentTime = 0;
+        message.m_sendCount = 0;
+        message.m_inUse = true;
+    }
+}
+
+
+CReliableChannel::CSentMessage* CReliableChannel::NextDue(uint32_t now) {
+    for (uint16_t s = m_oldestUnacked; s != m_nextSequence; s++) {
+        CSentMessage& message = m_sent[s % RELIABLE_WINDOW];
+        if (message.m_inUse && ((message.m_sendCount == 0) || (int(now - message.m_sentTime) >= RetransmitTimeout(message.m_sendCount))))
+            return &message;
+    }
+    return nullptr;
+}
+
+
+void CReliableChannel::Acknowledge(uint16_t session, uint16_t ack, uint32_t ackBits, uint32_t now) {
+    if (session != m_session)   // acknowledges a previous session
+        return;
+    for (uint16_t s = m_oldestUnacked; s != m_nextSequence; s++) {
+        CSentMessage& message = m_sent[s % RELIABLE_WINDOW];
+        if (!message.m_inUse)
+            continue;
+        int d = SequenceDistance(s, ack);
+        if ((d > 0) && ((d < 2) || (d > RELIABLE_WINDOW + 1) || !(ackBits & (1u << (d - 2)))))
+            continue;
+        if (message.m_sendCount == 1)  // round trip times of resent messages are ambiguous (Karn's algorithm)
+            UpdateRTO(int(now - message.m_sentTime));
+        message.m_inUse = false;
+    }
+    while ((m_oldestUnacked != m_nextSequence) && !m_sent[m_oldestUnacked % RELIABLE_WINDOW].m_inUse)
+        m_oldestUnacked++;
+    FillWindow();
+}
+
+
+void CReliableChannel::UpdateRTO(int rtt) {
+    if (m_srtt < 0.0f) {
+        m_srtt = float(rtt);
+        m_rttVar = float(rtt) * 0.5f;
+    }
+    else {
+        m_rttVar = 0.75f * m_rttVar + 0.25f * fabsf(m_srtt - float(rtt));
+        m_srtt = 0.875f * m_srtt + 0.125f * float(rtt);
+    }
+    m_rto = int(m_srtt + 4.0f * m_rttVar);
+    if (m_rto < MIN_RTO)
+        m_rto = MIN_RTO;
+    else if (m_rto > MAX_RTO)
+        m_rto = MAX_RTO;
+}
+
+
+bool CReliableChannel::Receive(uint16_t session, uint16_t base, uint16_t sequence, const uint8_t* data, size_t length) {
+    if (session != m_peerSession) {  // the peer has (re)started its session
+        m_peerSession = session;
+        m_expected = base;
+        for (int i = 0; i < RELIABLE_WINDOW; i++)
+            m_received[i].m_isValid = false;
+    }
+    m_ackPending = true;    // acknowledge duplicates too: the peer may have missed our ack
+    int d = SequenceDistance(sequence, m_expected);
+    if ((d < 0) || (d >= RELIABLE_WINDOW))
+        return false;
+    CReceivedMessage& message = m_received[sequence % RELIABLE_WINDOW];
+    if (message.m_isValid && (message.m_sequence == sequence))
+        return false;
+    message.m_data = CString((char*) data, int(length));
+    message.m_sequence = sequence;
+    message.m_isValid = true;
+    return true;
+}
+
+
+bool CReliableChannel::Deliver(CString& data) {
+    CReceivedMessage& message = m_received[m_expected % RELIABLE_WINDOW];
+    if (!message.m_isValid || (message.m_sequence != m_expected))
+        return false;
+    data = std::move(message.m_data);
+    message.m_isValid = false;
+    m_expected++;
+    return true;
+}
+
+
+// bit i: message AckSequence () + 2 + i has been received
+uint32_t CReliableChannel::AckBits(void) {
+    uint32_t bits = 0;
+    for (int i = 0; i < 32; i++) {
+        uint16_t s = uint16_t(m_expected + 1 + i);
+        CReceivedMessage& message = m_received[s % RELIABLE_WINDOW];
+        if (message.m_isValid && (message.m_sequence == s))
+            bits |= 1u << i;
+    }
+    return bits;
+}
+
+// =================================================================================================
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "cstring.h"
+#include "clist.h"
+#include "networkpacket.h"
+
+#define RELIABLE_WINDOW     32      // max. number of messages in flight (= width of the selective ack bit field + 1)
+#define INITIAL_RTO         250     // [ms] retransmission timeout before the first round trip time has been measured
+#define MIN_RTO             50
+#define MAX_RTO             2000
+
+// =================================================================================================
+// Reliable, ordered delivery of messages to a single peer
+//
+// Messages are numbered consecutively per session (starting at 1) && resent until the peer has acknowledged them.
+// The peer acknowledges the last message delivered in order plus the RELIABLE_WINDOW - 1 messages following it
+// as a bit field (selective ack), so that only messages actually lost are resent. The retransmission timeout
+// is derived from the measured round trip time (RFC 6298).
+// Each side picks a random session id when its channel is reset. A receiver seeing a new session id
+// restarts delivery at the oldest message the sender still has in flight.
+//
+// The channel is carried by the binary packets exchanged with the peer anyway (see CNetworkHandler::FlushPacket):
+// RELIABLE record: <session (uint16)><oldest unacknowledged sequence (uint16)><sequence (uint16)><length (varint)><message>
+// ACK record:      <peer's session (uint16)><last sequence delivered in order (uint16)><selective ack bits (uint32)>
+
+class CReliableChannel {
+    public:
+        class CSentMessage {
+            public:
+                CString     m_data;
+                uint16_t    m_sequence;
+                uint32_t    m_sentTime;
+                int         m_sendCount;
+                bool        m_inUse;
+
+                CSentMessage() : m_sequence(0), m_sentTime(0), m_sendCount(0), m_inUse(false) {}
+        };
+
+        class CReceivedMessage {
+            public:
+                CString     m_data;
+                uint16_t    m_sequence;
+                bool        m_isValid;
+
+                CReceivedMessage() : m_sequence(0), m_isValid(false) {}
+        };
+
+        // sending
+        uint16_t            m_session;
+        uint16_t            m_nextSequence;     // sequence number of the next message put in flight
+        uint16_t            m_oldestUnacked;
+        CSentMessage        m_sent[RELIABLE_WINDOW];
+        CList<CString>      m_queue;            // messages waiting for room in the send window
+        float               m_srtt;             // smoothed round trip time [ms] (< 0: not measured yet)
+        float               m_rttVar;
+        int                 m_rto;
+        uint32_t            m_resends;          // statistics
+        // receiving
+        uint16_t            m_peerSession;      // zero: nothing received yet
+        uint16_t            m_expected;         // sequence number of the next message to be delivered
+        CReceivedMessage    m_received[RELIABLE_WINDOW];
+        bool                m_ackPending;
+
+        CReliableChannel() {
+            Reset();
+        }
+
+        void Reset(void);
+
+        // queue a message. Returns false if it is too large to ever fit into a packet
+        bool Send(const uint8_t* data, size_t length);
+
+        inline bool Send(CString& message) {
+            return Send((uint8_t*) message.Buffer(), message.Length());
+        }
+
+        // return the next message that has to be (re)sent now, or nullptr
+        CSentMessage* NextDue(uint32_t now);
+
+        inline void MarkSent(CSentMessage* message, uint32_t now) {
+            message->m_sentTime = now;
+            if (message->m_sendCount++)
+                m_resends++;
+        }
+
+        // process the peer's acknowledgement of our messages
+        void Acknowledge(uint16_t session, uint16_t ack, uint32_t ackBits, uint32_t now);
+
+        // store a message received from the peer. Returns false if it had been received before
+        bool Receive(uint16_t session, uint16_t base, uint16_t sequence, const uint8_t* data, size_t length);
+
+        // remove the next message that can be delivered in order. Returns false if there is none
+        bool Deliver(CString& message);
+
+        // last message delivered in order
+        inline uint16_t AckSequence(void) {
+            return m_expected - 1;
+        }
+
+        uint32_t AckBits(void);
+
+        // size of a record carrying a message of length bytes
+        static inline size_t RecordSize(size_t length) {
+            return 12 + length;    // id, session, base, sequence, length (varint, at most 5 bytes)
+        }
+
+    private:
+        void FillWindow(void);
+
+        void UpdateRTO(int rtt);
+
+        inline int RetransmitTimeout(int sendCount) {
+            int rto = m_rto << ((sendCount > 4) ? 4 : sendCount - 1);   // exponential backoff
+            return (rto > MAX_RTO) ? MAX_RTO : rto;
+        }
+};
+
+// =================================================================================================
@@ -0,0 +1,73 @@
+#include <utility>
+
+#include "networkfragments.h"
+#include "lzcompressor.h"
+
+// =================================================================================================
+
+CFragmentedMessage::CFragmentedMessage(CString& message) {
+    m_messageLength = message.Length();
+    CLZCompressor::Compress((const uint8_t*) message.Buffer(), message.Length(), m_data);
+    if (m_data.Length() < m_messageLength)
+        m_flags = FRAGMENT_COMPRESSED;
+    else {
+        m_data = message;
+        m_flags = 0;
+    }
+    m_fragmentCount = int((m_data.Length() + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE);
+    if (m_fragmentCount == 0)
+        m_fragmentCount = 1;
+}
+
+// =================================================================================================
+
+void CFragmentAssembler::Reset(void) {
+    m_data = "";
+    m_nextFragment = 0;
+    m_fragmentCount = 0;
+    m_flags = 0;
+    m_messageLength = 0;
+}
+
+
+// A fragment other than the expected one means that the transfer the previous fragments belonged to has been cut short
+// (the sender's channel has been reset): fragment 0 always starts a new message. Malformed fragments discard what
+// has been received of the message so far
+int CFragmentAssembler::Add(int fragment, int fragmentCount, uint8_t flags, size_t messageLength, const uint8_t* data, size_t length, CString& message) {
+    if ((fragment >= fragmentCount) || (messageLength > MAX_FRAGMENTED_LENGTH) || (length > FRAGMENT_SIZE))
+        return -1;
+    if (fragment == 0) {
+        size_t maxFragments = (messageLength + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE;
+        if (size_t(fragmentCount) > ((maxFragments > 0) ? maxFragments : 1)) {
+            Reset();
+            return -1;
+        }
+        m_data = "";
+        m_fragmentCount = fragmentCount;
+        m_flags = flags;
+        m_messageLength = messageLength;
+    }
+    else if ((fragment != m_nextFragment) || (fragmentCount != m_fragmentCount) || (flags != m_flags) || (messageLength != m_messageLength)) {
+        Reset();
+        return -1;
+    }
+    if (((fragment < fragmentCount - 1) && (length != FRAGMENT_SIZE)) || (m_data.Length() + length > messageLength)) {
+        Reset();
+        return -1;
+    }
+    m_data.Append((const char*) data, length);
+    m_nextFragment = fragment + 1;
+    if (m_nextFragment < fragmentCount)
+        return 0;
+    bool isValid;
+    if (flags & FRAGMENT_COMPRESSED)
+        isValid = CLZCompressor::Decompress((const uint8_t*) m_data.Buffer(), m_data.Length(), messageLength, message);
+    else {
+        isValid = (m_data.Length() == messageLength);
+        message = std::move(m_data);
+    }
+    Reset();
+    return isValid ? 1 : -1;
+}
+
+// =================================================================================================
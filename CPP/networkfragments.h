@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "cstring.h"
+
+#define FRAGMENT_SIZE           1024        // message bytes per FRAGMENT record (leaves room for the RELIABLE record around it)
+#define MAX_FRAGMENTS           0xFFFF
+#define MAX_FRAGMENTED_LENGTH   0x1000000   // longest message accepted (16 MB), so a malformed length can't exhaust memory
+#define FRAGMENT_COMPRESSED     1           // fragment flag: the message has been compressed (see CLZCompressor)
+
+// =================================================================================================
+// Messages too large for a single packet
+//
+// The reliable channel delivers messages in order, but each one has to fit into a single packet. Larger messages
+// (the join snapshot, the player && projectile lists of busy matches, the map) are compressed && split into
+// FRAGMENT records of at most FRAGMENT_SIZE bytes, each of which is sent as a message of its own through the
+// channel (see CNetworkHandler::QueueReliable). The receiver collects them per peer && handles the reassembled
+// message as if the channel had delivered it.
+// FRAGMENT record: <fragment (uint16)><fragment count (uint16)><flags (byte)><message length (varint)><length (varint)><data>
+// The message length is that of the original (uncompressed) message.
+
+// the data of a message to be sent in fragments: the message compressed, unless that doesn't make it any shorter
+class CFragmentedMessage {
+    public:
+        CString     m_data;
+        size_t      m_messageLength;
+        uint8_t     m_flags;
+        int         m_fragmentCount;
+
+        CFragmentedMessage(CString& message);
+
+        inline const uint8_t* Fragment(int fragment) {
+            return (const uint8_t*) m_data.Buffer() + size_t(fragment) * FRAGMENT_SIZE;
+        }
+
+        inline size_t FragmentLength(int fragment) {
+            size_t offset = size_t(fragment) * FRAGMENT_SIZE;
+            return (m_data.Length() - offset < FRAGMENT_SIZE) ? m_data.Length() - offset : FRAGMENT_SIZE;
+        }
+};
+
+// =================================================================================================
+// Reassembly of the fragmented messages received from a peer
+//
+// The first fragment of a message decides its fragment count, flags && length, && the data sent are never longer than
+// the message (see CFragmentedMessage). Fragments claiming more, && all but the last fragment not being full, are
+// rejected, so a peer can't make the assembler buffer more than the message length it has announced.
+
+class CFragmentAssembler {
+    public:
+        CString     m_data;             // fragments received so far
+        int         m_nextFragment;     // next fragment expected
+        int         m_fragmentCount;    // of the message being received
+        uint8_t     m_flags;
+        size_t      m_messageLength;
+
+        CFragmentAssembler() : m_nextFragment(0), m_fragmentCount(0), m_flags(0), m_messageLength(0) {}
+
+        void Reset(void);
+
+        // add a fragment. Returns 1 && the message once its last fragment has arrived, 0 if more fragments are
+        // expected && -1 if the fragment is malformed || out of order
+        int Add(int fragment, int fragmentCount, uint8_t flags, size_t messageLength, const uint8_t* data, size_t length, CString& message);
+};
+
+// =================================================================================================
@@ -1,12 +1,18 @@
 #include <stdint.h>
+#include <ctype.h>
 
-#include "networkHandler.h"
-#include "controlsHandler.h"
-#include "gameData.h"
-#include "gameItems.h"
-#include "actorHandler.h"
-#include "argHandler.h"
+#include "networkhandler.h"
+#ifndef HEADLESS
+#   include "controlshandler.h"
+#endif
+#include "gamedata.h"
+#include "gameitems.h"
+#include "actorhandler.h"
+#include "arghandler.h"
 #include "maploader.h"
+#include "physicshandler.h"
+#include "virtualnetwork.h"
+#include "networkcapture.h"
 
 // =================================================================================================
 
@@ -16,6 +22,34 @@
 #   define LOG(msg, ...)
 #endif
 
+// indexed by the message ids (eMessageIds)
+const CNetworkHandler::CMessageHandler CNetworkHandler::m_messageHandlers[CNetworkHandler::miCount] = {
+    CMessageHandler("APPLY", &CNetworkHandler::HandleApply),                     // process join request sent to game host
+    CMessageHandler("ACCEPT", &CNetworkHandler::HandleAccept),                   // receive position && heading #include "game host
+    CMessageHandler("REQUESTMAP", &CNetworkHandler::HandleMapRequest),           // send map data to new player
+    CMessageHandler("SYNCMAP", &CNetworkHandler::SyncMap),                       // process map data #include "game host
+    CMessageHandler("REQUESTPARAMS", &CNetworkHandler::HandleParamsRequest),     // send game parameters to new player
+    CMessageHandler("SYNCPARAMS", &CNetworkHandler::SyncParams),                 // process game parameters #include "game host
+    CMessageHandler("REQUESTPLAYERS", &CNetworkHandler::HandlePlayersRequest),   // send list of all players to new player
+    CMessageHandler("SYNCPLAYERS", &CNetworkHandler::SyncPlayers),               // add all players #include "player message to actor list that aren't already in it
+    CMessageHandler("REQUESTSHOTS", &CNetworkHandler::HandleProjectilesRequest), // send currently live projectiles to new player
+    CMessageHandler("SYNCSHOTS", &CNetworkHandler::SyncProjectiles),             // add projectiles #include "message to actor list
+    CMessageHandler("ENTER", &CNetworkHandler::HandleEnter),                     // compute position && heading for new player && send them to him/her
+    CMessageHandler("ANIMATION", &CNetworkHandler::HandleAnimation),             // update sending player's animation state (which determines whether && which animation sound to play)
+    CMessageHandler("UPDATE", &CNetworkHandler::HandleUpdate, &CNetworkHandler::HandleUpdateRecord),     // update all local actors owned by the sending player with positions && headings #include "the message
+    CMessageHandler("FIRE", &CNetworkHandler::HandleFire, &CNetworkHandler::HandleFireRecord),           // create a projectile fired by another player
+    CMessageHandler("HIT", &CNetworkHandler::HandleHit, &CNetworkHandler::HandleHitRecord),              // integrate hit at a player into local player data
+    CMessageHandler("DESTROY", &CNetworkHandler::HandleDestroy, &CNetworkHandler::HandleDestroyRecord),  // destroy a projectile that had hit another player
+    CMessageHandler("LEAVE", &CNetworkHandler::HandleLeave),                     // remove sending player #include "player list
+    CMessageHandler("REJECT", &CNetworkHandler::HandleReject),                   // react to some message sent to another player having been rejected by that player for some reason
+    CMessageHandler("RELIABLE", nullptr, &CNetworkHandler::HandleReliableRecord),// deliver messages received through the reliable channel in order
+    CMessageHandler("ACK", nullptr, &CNetworkHandler::HandleAckRecord),          // release reliable messages the peer has received
+    CMessageHandler("ELECT", &CNetworkHandler::HandleElect),                     // collect another player's vote for the new game host
+    CMessageHandler("JOIN", nullptr, &CNetworkHandler::HandleJoinRecord),        // collect && apply the join snapshot sent by the game host
+    CMessageHandler("CLOCK", nullptr, &CNetworkHandler::HandleClockRecord),      // measure the offset of the sender's clock to ours
+    CMessageHandler("FRAGMENT", nullptr, &CNetworkHandler::HandleFragmentRecord) // reassemble a message too large for a single packet
+};
+
 // =================================================================================================
 
 CNetworkHandler::CNetworkHandler() : CUDP() {
@@ -25,49 +59,99 @@ CNetworkHandler::CNetworkHandler() : CUDP() {
     m_hostAddress = argHandler->StrVal("hostaddress", 0, CString("127.0.0.1"));
     m_hostPorts[0] = argHandler->IntVal("hostport", 0, 0);
     m_hostPorts[1] = 0;
-    m_messageHandlers = {
-        CMessageHandler("APPLY", &CNetworkHandler::HandleApply),                     // process join request sent to game host
-        CMessageHandler("ACCEPT", &CNetworkHandler::HandleAccept),                   // receive position && heading #include "game host
-        CMessageHandler("REQUESTMAP", &CNetworkHandler::HandleMapRequest),           // send map data to new player
-        CMessageHandler("SYNCMAP", &CNetworkHandler::SyncMap),                       // process map data #include "game host
-        CMessageHandler("REQUESTPARAMS", &CNetworkHandler::HandleParamsRequest),     // send game parameters to new player
-        CMessageHandler("SYNCPARAMS", &CNetworkHandler::SyncParams),                 // process game parameters #include "game host
-        CMessageHandler("REQUESTPLAYERS", &CNetworkHandler::HandlePlayersRequest),   // send list of all players to new player
-        CMessageHandler("SYNCPLAYERS", &CNetworkHandler::SyncPlayers),               // add all players #include "player message to actor list that aren't already in it
-        CMessageHandler("REQUESTSHOTS", &CNetworkHandler::HandleProjectilesRequest), // send currently live projectiles to new player
-        CMessageHandler("SYNCSHOTS", &CNetworkHandler::SyncProjectiles),             // add projectiles #include "message to actor list
-        CMessageHandler("ENTER", &CNetworkHandler::HandleEnter),                     // compute position && heading for new player && send them to him/her
-        CMessageHandler("ANIMATION", &CNetworkHandler::HandleAnimation),             // update sending player's animation state (which determines whether && which animation sound to play)
-        CMessageHandler("UPDATE", &CNetworkHandler::HandleUpdate),                   // update all local actors owned by the sending player with positions && headings #include "the message
-        CMessageHandler("FIRE", &CNetworkHandler::HandleFire),                       // create a projectile fired by another player
-        CMessageHandler("HIT", &CNetworkHandler::HandleHit),                         // integrate hit at a player into local player data
-        CMessageHandler("DESTROY", &CNetworkHandler::HandleDestroy),                 // destroy a projectile that had hit another player
-        CMessageHandler("LEAVE", &CNetworkHandler::HandleLeave),                     // remove sending player #include "player list
-        CMessageHandler("REJECT", &CNetworkHandler::HandleReject)                    // react to some message sent to another player having been rejected by that player for some reason
-    };
 
-    m_idMap.SetComparator(CString::Compare);
-    for (auto [id, h] : m_messageHandlers)
-        m_idMap.Insert(h.m_name, CString(id) + CString("#"));
+    for (int id = 0; id < miCount; id++)
+        m_messageHeaders[id] = CString(id) + CString("#");
 
     m_joinStateHandlers = { 
         &CNetworkHandler::SendApply, &CNetworkHandler::SendSyncMap, &CNetworkHandler::SendSyncParams, 
-        &CNetworkHandler::SendSyncPlayers, &CNetworkHandler::SendSyncProjectiles, &CNetworkHandler::SendEnter 
+        &CNetworkHandler::SendSyncPlayers, &CNetworkHandler::SendSyncProjectiles, &CNetworkHandler::SendEnter,
+        nullptr, &CNetworkHandler::SendApply    // jsSnapshot: apply again if the host doesn't respond
     };
-    m_fps = 60;
+    m_fps = argHandler->IntVal("networkfps", 0, 30);
+    if (m_fps < 1)
+        m_fps = 1;
     m_frameTime = 1000 / m_fps;             // m_fps
+    m_interpolationDelay = argHandler->IntVal("interpolationdelay", 0, 2 * m_frameTime);   // ~ two network frames
+    m_correctionDelay = argHandler->IntVal("projectilecorrectiondelay", 0, 500);
+    m_lagCompensation = argHandler->IntVal("lagcompensation", 0, 250);
+    m_relay = argHandler->BoolVal("relaymode", 0, false);   // only the host's setting counts (see SyncParams)
+    m_interestManagement = argHandler->BoolVal("interestmanagement", 0, true);
+    m_audibleDistance = argHandler->FloatVal("audibledistance", 0, 30.0f);     // see CSoundHandler::m_maxAudibleDistance
+    m_audibleInterval = (m_fps > 15) ? m_fps / 15 : 1;     // ~ 15 updates per second
+    m_hiddenInterval = m_fps;                               // ~ one update per second
+    m_adaptiveSendRate = argHandler->BoolVal("adaptivesendrate", 0, true);
+    m_minPeerFps = argHandler->IntVal("minpeerfps", 0, 5);
+    if (m_minPeerFps > m_fps)
+        m_minPeerFps = m_fps;
+    m_peerBandwidth = argHandler->IntVal("peerbandwidth", 0, 32000);
+    m_minPeerBandwidth = (m_peerBandwidth < 2000) ? m_peerBandwidth : 2000;
+    m_statsFile = argHandler->StrVal("statsfile", 0, CString(""));
+    m_statsInterval = argHandler->IntVal("statsinterval", 0, 5000);
+    m_electing = false;
+    m_electionDuration = 1500;
+    m_electionNumber = 0;
+    m_bestElectionNumber = 0;
+    m_bestElectionColor = -1;
+    m_matchOffset = 0;
+    m_matchTime = 0;
+    m_haveMatchTime = false;
+    m_updateSequence = uint16_t(rand());  // a client restarting under the same color doesn't look like it's sending old updates
     m_joinDelay = 5000;             // 5 seconds between two consecutive join attempts
     m_joinStateDelay = 500;
     m_timeoutPeriod = 30 * 1000;    // seconds [ms] without message #include "a player after which the player will be removed #include "the game
     m_mapRow = -1;
     m_threadedListener = argHandler->BoolVal("multithreading", 0, true);
+    m_messages.Create(argHandler->IntVal("messagequeuesize", 0, 512));
+    m_messageOverflows = 0;
     m_listen = true;
+    m_binaryFormat = argHandler->BoolVal("binaryformat", 0, true);
     m_joinState = IamMaster() ? jsConnected : jsApply;
+    m_requestedJoinState = jsApply;
     m_semicolon = CString(";");
     m_colon = ":";
     m_hashtag = "#";
     m_syncingAddress = "";
+    m_syncingPorts[0] = m_syncingPorts[1] = 0;
+    m_sender = nullptr;
+    m_replay = nullptr;
+    CreateTransports();
+}
+
+
+// the wrapping transports own the ones they wrap
+void CNetworkHandler::CreateTransports(void) {
+    CString replayFile = argHandler->StrVal("replayfile", 0, CString(""));
+    if (!replayFile.Empty()) {
+        m_replay = new CReplayTransport(replayFile, argHandler->FloatVal("replayspeed", 0, 1.0f));
+        SetTransport(0, m_replay);
+        SetTransport(1, new CReplayTransport());
+        m_threadedListener = false;     // process the datagrams in the order && at the frames they are handed out
+        return;
+    }
+    if (argHandler->BoolVal("virtualnetwork", 0, false)) {
+        SetTransport(0, new CVirtualSocket());
+        SetTransport(1, new CVirtualSocket());
+    }
+    CLinkParams link;
+    link.m_latency = argHandler->IntVal("netlatency", 0, 0);
+    link.m_jitter = argHandler->IntVal("netjitter", 0, 0);
+    link.m_loss = argHandler->FloatVal("netloss", 0, 0.0f);
+    link.m_duplication = argHandler->FloatVal("netduplication", 0, 0.0f);
+    link.m_reordering = argHandler->FloatVal("netreordering", 0, 0.0f);
+    link.m_bandwidth = argHandler->IntVal("netbandwidth", 0, 0);
+    if (!link.IsPerfect())
+        m_sockets[0] = new CImpairedTransport(m_sockets[0], link, uint32_t(argHandler->IntVal("netseed", 0, 1)));
+    CString captureFile = argHandler->StrVal("capturefile", 0, CString(""));
+    if (!captureFile.Empty() && m_capture.Open(captureFile)) {
+        m_sockets[0] = new CCaptureTransport(m_sockets[0], &m_capture);
+        m_sockets[1] = new CCaptureTransport(m_sockets[1], &m_capture);
+    }
+}
+
 
+bool CNetworkHandler::ReplayFinished(void) {
+    return m_replay && m_replay->Finished();
 }
 
 
@@ -77,8 +161,9 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
     OpenSocket(m_localPorts[0], 0);
     OpenSocket(m_localPorts[1], 1);
     actorHandler->m_viewer->SetAddress(m_localAddress, m_localPorts);
+    actorHandler->Reindex();
     if (m_threadedListener)
-        m_listener.Start(&m_listen);
+        m_listener.Start(&m_listen, this);
 }
 
     void CNetworkHandler::Destroy(void) {
@@ -93,6 +178,58 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
     }
 
 
+    // text messages are counted with their "SMIBAT" prefix, as they go over the wire
+    bool CNetworkHandler::Transmit(CString message, CString address, uint16_t port, CNetworkPeer* peer) {
+        const char* payload = message.Buffer();
+        size_t length = message.Length() + 6;
+        m_stats.m_traffic.Sent(length);
+        m_stats.Sent((payload && isdigit(uint8_t(*payload))) ? int(strtol(payload, nullptr, 10)) : -1, length);
+        if (peer)
+            peer->m_traffic.Sent(length);
+        return CUDP::Transmit(message, address, port);
+    }
+
+
+    // the peer's traffic is counted by SendPacket
+    bool CNetworkHandler::Transmit(CPacketWriter& packet, CString address, uint16_t port) {
+        m_stats.m_traffic.Sent(packet.Length());
+        return CUDP::Transmit(packet, address, port);
+    }
+
+
+    void CNetworkHandler::WriteStats(void) {
+        FILE* file = fopen(m_statsFile.Buffer(), "w");
+        if (!file)
+            return;
+        const char* names[miCount];
+        for (int id = 0; id < miCount; id++)
+            names[id] = m_messageHandlers[id].m_name;
+        m_stats.Write(file, names, miCount);
+        fprintf(file, "match time %u s (%d ms ahead of the local clock)\n", MatchTime() / 1000, m_matchOffset);
+        fprintf(file, "fragmented messages sent %u (%llu bytes, compressed to %llu)\n", m_stats.m_fragmentedMessages,
+                (unsigned long long) m_stats.m_fragmentedBytes, (unsigned long long) m_stats.m_compressedBytes);
+        fprintf(file, "actor updates dropped %u (%u reordered, %u duplicates)\n", m_stats.m_reorderedUpdates + m_stats.m_duplicateUpdates,
+                m_stats.m_reorderedUpdates, m_stats.m_duplicateUpdates);
+        fprintf(file, "actors left out of full snapshots %u\n", m_stats.m_droppedActors);
+        fprintf(file, "\nmessage queue %zu (max %zu, capacity %zu, dropped %zu)\n", m_stats.m_queueDepth, m_messages.HighWater(), m_messages.Capacity(), m_messages.Overflows());
+        fprintf(file, "\n%-22s %5s %8s %12s %8s %12s %8s %6s %6s %6s %8s %11s %9s %6s\n", "peer", "color", "in", "bytes in", "out", "bytes out", "rtt [ms]", "loss", "fps", "kB/s", "resends", "clock [ms]", "reordered", "dups");
+        for (auto [i, a] : actorHandler->m_actors)
+            if (a->IsPlayer() && !a->IsLocalActor()) {
+                CNetworkPeer& peer = ((CPlayer*) a)->m_peer;
+                CTrafficStats& traffic = peer.m_traffic;
+                CCongestionControl& congestion = peer.m_congestion;
+                CString address = a->GetAddress() + ":" + CString(a->GetPort(0));
+                fprintf(file, "%-22s %5d %8u %12llu %8u %12llu %8.1f %6.3f %6.1f %6.1f %8u %11d %9u %6u\n",
+                        address.Buffer(), a->GetColorIndex(),
+                        traffic.m_packetsIn, (unsigned long long) traffic.m_bytesIn, traffic.m_packetsOut, (unsigned long long) traffic.m_bytesOut,
+                        peer.m_binaryFormat ? congestion.m_srtt : -1.0f, congestion.m_loss,
+                        peer.m_binaryFormat ? congestion.Rate(m_fps) : float(m_fps), congestion.m_bandwidth / 1000.0f, peer.m_channel.m_resends,
+                        peer.m_clock.m_offset, peer.m_reorderedUpdates, peer.m_duplicateUpdates);
+            }
+        fclose(file);
+    }
+
+
     // message handling helper functions ========================================
 
     CString CNetworkHandler::BuildMessage(const char* delim, std::initializer_list<CString> values) {
@@ -119,43 +256,199 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
     }
 
 
-    // construct a message with all update info for actor 
+    // construct a message with all update info for actor (numbered with the current update sequence number)
     CString CNetworkHandler::UpdateMessage(CActor* actor) {
+        CString colorIndex = BuildMessage(":", { CString(actor->GetColorIndex()), CString(int(m_updateSequence)) });
         if (actor->IsPlayer())
-            return BuildMessage(";", { CString(actor->GetId()), CString(actor->GetColorIndex()), VectorToMessage(actor->GetPosition()), VectorToMessage(actor->GetOrientation()),
+            return BuildMessage(";", { CString(actor->GetId()), colorIndex, VectorToMessage(actor->GetPosition()), VectorToMessage(actor->GetOrientation()),
                                        CString(actor->m_hitPoints), CString(actor->GetScore()), CString(actor->m_lifeState), CString(actor->m_scale), CString(actor->GetPort()) });
         else
-            return BuildMessage(";", { CString(actor->GetId()), CString(actor->GetColorIndex()), VectorToMessage(actor->GetPosition()), VectorToMessage(actor->GetOrientation()) });
+            return BuildMessage(";", { CString(actor->GetId()), colorIndex, VectorToMessage(actor->GetPosition()), VectorToMessage(actor->GetOrientation()) });
     }
 
 
-    CString CNetworkHandler::PlayerMessage(CPlayer* player) {
-        return BuildMessage(";", { player->GetAddress (), CString (player->GetPort (0)), CString (player->GetPort (1)), CString (player->GetColorIndex ()) });
+    // format: ENTER<color>;<rx port>[;<binary format version>;<join snapshot version>]
+    CString CNetworkHandler::EnterMessage(void) {
+        CString message = BuildMessage("", { MessageHeader(miEnter), CString(actorHandler->m_viewer->m_colorIndex),  m_semicolon, CString(InPort()) });
+        if (m_binaryFormat)
+            message += BuildMessage(";", { CString(""), CString(PACKET_VERSION), CString(JOIN_VERSION) });
+        return message;
     }
 
 
-    CString CNetworkHandler::IdFromName(const char* textId) {
-        CString* id = m_idMap.Find(CString (textId));
-        return id ? *id : CString("");
+    // format: MAP<row number>;<row text> (see SendMap)
+    CString CNetworkHandler::MapMessage(int row, CString& text) {
+        return BuildMessage(";", { MessageHeader(miSyncMap) + CString(row), text });
+    }
+
+
+    // format: PARAMS<fire delay>;<heal delay>;<respawn delay>;<immunity duration>;<points for kill>;<projectile size>;<projectile speed>;<move speed>;<turn speed>;<relay mode>;<max players>
+    CString CNetworkHandler::ParamsMessage(void) {
+        return
+            BuildMessage(";", { 
+                MessageHeader(miSyncParams) + CString(gameData->m_fireMode), 
+                CString(gameData->m_fireDelay),
+                CString(gameData->m_healDelay), 
+                CString(gameData->m_respawnDelay), 
+                CString(gameData->m_immunityDuration),
+                CString(gameData->m_pointsForKill), 
+                CString(gameData->m_projectileSize),
+                CString(gameData->m_projectileSpeed), 
+#ifndef HEADLESS
+                CString(controlsHandler->GetMoveSpeed()), 
+                CString(controlsHandler->GetTurnSpeed()),
+#else           // the dedicated server has no controls, so take its speeds directly from its settings (see CControlsHandler)
+                CString(argHandler->FloatVal("movespeed", 0, 1.0f) / 20.0f), 
+                CString(argHandler->FloatVal("turnspeed", 0, 1.0f)),
+#endif
+                CString(m_relay ? 1 : 0),
+                CString(gameData->m_maxPlayers)
+            });
+    }
+
+
+    // format: PLAYERS<player data>[;<player data> [...]]
+    // player data: <address>:<port>;<color index>
+    CString CNetworkHandler::PlayersMessage(CPlayer* recipient) {
+        CString message;
+        message.Reserve(500);
+        message += MessageHeader(miSyncPlayers);
+        int count = 0;
+        // add addresses of all other players to player requesting to join
+        for (auto [i, a] : actorHandler->m_actors) {
+            if (a->IsPlayer () && (a != recipient)) {  // player
+                if (count++ > 0)    // !the first entry in the list
+                    message += ";";
+                message += BuildMessage(";", { a->GetAddress () + ":" + CString (a->GetPort (0)), CString (a->GetPort (1)), CString (a->GetColorIndex ())});
+            }
+        }
+        return message;
+    }
+
+
+    // format: SHOTS<shot data>[;<shot data> [...]]
+    // shot data: <actor id>;<parent color index>
+    CString CNetworkHandler::ProjectilesMessage(void) {
+        CString message;
+        message.Reserve(500);
+        message += MessageHeader(miSyncShots);
+        int count = 0;
+        for (auto [i, a] : actorHandler->m_actors) {
+            if (a->IsProjectile ()) {  // projectile
+                if (count++ > 0)    // !the first entry in the list
+                    message += ";";
+                message += CString(a->m_id);
+                message += ";";
+                message += CString(a->GetColorIndex ());
+            }
+        }
+        return message;
+    }
+
+
+    // format: ACCEPT<color>;<position>;<orientation>;<address> (see HandleAccept)
+    CString CNetworkHandler::AcceptMessage(CPlayer* player) {
+        return BuildMessage(";", { MessageHeader(miAccept) + CString(player->m_colorIndex), VectorToMessage(player->GetPosition()), VectorToMessage(player->GetOrientation()), player->m_address });
+    }
+
+
+    void CNetworkHandler::ActorState(CActor* actor, CActorState& state) {
+        state.m_id = actor->GetId();
+        state.m_colorIndex = actor->GetColorIndex();
+        state.m_position = actor->GetPosition();
+        state.m_orientation = actor->GetOrientation();
+        if (!actor->IsLocalActor()) {   // relayed: pass on the state as received, not as currently displayed
+            CVector angles;
+            if (actor->m_states.Newest(state.m_position, angles))
+                state.m_orientation = -angles;
+            else
+                state.m_orientation = -state.m_orientation;
+        }
+        if (actor->IsPlayer()) {
+            state.m_hitPoints = actor->m_hitPoints;
+            state.m_score = int(actor->GetScore());
+            state.m_lifeState = actor->m_lifeState;
+            state.m_scale = actor->m_scale;
+            state.m_port = actor->GetPort();
+        }
+        state.Quantize();
+    }
+
+
+    // binary version of UpdateMessage, covering all actors of the snapshot
+    // format: <record length (uint16)><baseline sequence (uint16)><send time (uint32)><view time (uint32)><update sequence (uint16)>
+    //         <actor count (varint)><changed flags (1 bit per actor)>[<actor data>[...]]
+    // actor data: <id (varint)><color (byte)><field mask (byte)><field values (see CActorState::Write)>
+    // The send time is the match time the actor states have been taken at. The view time is the match time at which we
+    // currently see the receiver (see ViewTime, 0: unknown). The update sequence number is that of
+    // the states of our own actors (see HandleUpdate). Relayed actors carry their owners' numbers in their states.
+    // Actors whose state equals that of the actor at the same place in the baseline snapshot are just flagged as unchanged.
+    // For all other actors, only the fields differing from the baseline are sent (all fields if not in the baseline).
+    void CNetworkHandler::UpdateRecord(CPacketWriter& packet, CSnapshot& snapshot, CSnapshot* baseline, uint32_t viewTime) {
+        int fieldMasks[MAX_SNAPSHOT_ACTORS];
+        packet.WriteByte(uint8_t(miUpdate));
+        size_t start = packet.Length();
+        packet.WriteUInt16(0);
+        packet.WriteUInt16(baseline ? baseline->m_sequence : 0);
+        packet.WriteUInt32(gameData->m_matchTime);
+        packet.WriteUInt32(viewTime);
+        packet.WriteUInt16(m_updateSequence);
+        packet.WriteVarInt(uint32_t(snapshot.m_actorCount));
+        uint8_t flags = 0;
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            CActorState& state = snapshot.m_actors[i];
+            CActorState* base = baseline ? baseline->Find(state.m_id, state.m_colorIndex) : nullptr;
+            fieldMasks[i] = base ? state.Compare(*base) : state.FieldMask();
+            if (fieldMasks[i] || !baseline || (base != baseline->m_actors.Buffer(i)))
+                flags |= 1 << (i & 7);
+            else
+                fieldMasks[i] = -1;    // unchanged
+            if (((i & 7) == 7) || (i == snapshot.m_actorCount - 1)) {
+                packet.WriteByte(flags);
+                flags = 0;
+            }
+        }
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            if (fieldMasks[i] < 0)
+                continue;
+            CActorState& state = snapshot.m_actors[i];
+            packet.WriteVarInt(uint32_t(state.m_id));
+            packet.WriteByte(uint8_t(state.m_colorIndex));
+            packet.WriteByte(uint8_t(fieldMasks[i]));
+            state.Write(packet, fieldMasks[i]);
+        }
+        packet.WriteUInt16At(start, uint16_t(packet.Length() - start - 2));
     }
 
 
     int CNetworkHandler::IdFromMessage(CMessage& message) {
-        auto values = message.m_payload.Split('#');
-		if (values.Empty())
-			return -1;			
-		int id = int(values[0]);
-        return (id < m_messageHandlers.Length()) ? id : -1;
+		int id = message.Id();
+        return (id < miCount) ? id : -1;
     }
 
 
     // networking helper functions ========================================
 
     CPlayer* CNetworkHandler::FindPlayer(CString & address, uint16_t port) {
-        for (auto [i, a] : actorHandler->m_actors)
-            // check for port too as there may be players in the same local network && behind the same router/firewall, sharing the same ip address && just using different ports
-            if (a->IsPlayer () && (a->GetAddress () == address) && (a->GetPort (1) == port))
-                return (CPlayer*) a;
+        return actorHandler->FindPlayer(address, port);
+    }
+
+
+    CNetworkPeer* CNetworkHandler::FindPeer(CString& address, uint16_t port, int portType) {
+        CPlayer* player = nullptr;
+        if (portType == 1)
+            player = FindPlayer(address, port);
+        else {
+            for (auto [i, a] : actorHandler->m_actors)
+                if (a->IsPlayer() && !a->IsLocalActor() && (a->GetPort(0) == port) && (a->GetAddress() == address)) {
+                    player = (CPlayer*) a;
+                    break;
+                }
+        }
+        if (player)
+            return &player->m_peer;
+        if ((m_syncingAddress != "") && (port == m_syncingPorts[portType]) && (address == m_syncingAddress))
+            return &m_syncingPeer;
         return nullptr;
     }
 
@@ -181,6 +474,8 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
             return 1;
         if (m_joinState == jsApply)
             return 0;
+        if (m_electing)     // the host is gone && we are about to pick a new one
+            return 1;
         CPlayer* host = FindPlayer(m_hostAddress, m_hostPorts[1]);
         if (!host)
             return 0;
@@ -189,15 +484,78 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         return 1;
     }
 
+    // Corrections slowing the match time down hold it until our clock has caught up
+    uint32_t CNetworkHandler::MatchTime(void) {
+        uint32_t matchTime = SDL_GetTicks() + uint32_t(m_matchOffset);
+        if ((m_matchTime == 0) || (int(matchTime - m_matchTime) > 0))
+            m_matchTime = matchTime;
+        return m_matchTime;
+    }
+
+
+    // Players whose states are interpolated are displayed at the time the owner has sent the state shown (see
+    // CInterpolationBuffer::SendTime), all others at the time it has sent its most recent snapshot
+    uint32_t CNetworkHandler::ViewTime(CPlayer* player) {
+        uint32_t viewTime;
+        if (player->m_states.SendTime(DisplayTime(), viewTime))
+            return viewTime;
+        return (m_interpolationDelay > 0) ? 0 : player->m_peer.m_snapshotTime;
+    }
+
+
+    int CNetworkHandler::ViewLag(CActor* shooter) {
+        if (!m_lagCompensation || !shooter || !shooter->IsPlayer() || shooter->IsLocalActor())
+            return 0;
+        int viewLag = ((CPlayer*) shooter)->m_peer.m_viewLag;
+        return (viewLag < m_lagCompensation) ? viewLag : m_lagCompensation;
+    }
+
+
     bool CNetworkHandler::TimedOut (CPlayer* player) {
         return !player->IsLocalActor() && (gameData->m_gameTime - player->m_lastMessageTime > m_timeoutPeriod);
     }
 
+
+    // check whether any remote player needs to be sent text messages
+    bool CNetworkHandler::HaveTextPeers(void) {
+        for (auto [i, a] : actorHandler->m_actors)
+            if (a->IsPlayer () && !a->IsLocalActor() && !((CPlayer*) a)->m_peer.m_binaryFormat)
+                return true;
+        return false;
+    }
+
+    bool CNetworkHandler::IsHost(CPlayer* player) {
+        return (player->GetPort(1) == m_hostPorts[1]) && (player->GetAddress() == m_hostAddress);
+    }
+
+
+    CPlayer* CNetworkHandler::RelayHost(void) {
+        if (!m_relay || m_electing || IamMaster())
+            return nullptr;
+        CPlayer* host = FindPlayer(m_hostAddress, m_hostPorts[1]);
+        return (host && host->m_peer.m_binaryFormat) ? host : nullptr;
+    }
+
+
+    void CNetworkHandler::RelayMessage(CString& message, CPlayer* origin, bool reliable) {
+        for (auto [i, a] : actorHandler->m_actors)
+            if (a->IsPlayer () && (a != origin) && !a->IsLocalActor()) {
+                CNetworkPeer& peer = ((CPlayer*) a)->m_peer;
+                if (!peer.m_binaryFormat)   // text peers get everything directly from its sender
+                    continue;
+                if (!reliable || !peer.m_channel.Send(message))
+                    Transmit(message, a->GetAddress (), a->GetPort (0), &peer);
+            }
+    }
+
     // send functions ========================================
 
     void CNetworkHandler::SendApply(void) {
         LOG("SendApply\n")
-        Transmit(BuildMessage("", { IdFromName("APPLY"), CString(InPort()) }), m_hostAddress, m_hostPorts[0]);
+        CString message = BuildMessage("", { MessageHeader(miApply), CString(InPort()) });
+        if (m_binaryFormat)     // ask for a join snapshot
+            message += BuildMessage(";", { CString(""), CString(actorHandler->m_viewer->m_colorIndex), CString(PACKET_VERSION), CString(JOIN_VERSION) });
+        Transmit(message, m_hostAddress, m_hostPorts[0]);
     }
 
 
@@ -205,25 +563,25 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         m_mapRow = -1;
         m_stringMap.Destroy();
         LOG("SendSyncMap\n")
-        Transmit(BuildMessage("", { IdFromName("REQUESTMAP"), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
+        SendReliable(BuildMessage("", { MessageHeader(miRequestMap), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
     }
 
 
     void CNetworkHandler::SendSyncParams(void) {
         LOG("SendSyncParams\n")
-        Transmit(BuildMessage("", { IdFromName("REQUESTPARAMS"), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
+        SendReliable(BuildMessage("", { MessageHeader(miRequestParams), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
     }
 
 
     void CNetworkHandler::SendSyncProjectiles(void) {
         LOG("SendSyncProjectiles\n")
-        Transmit(BuildMessage("", { IdFromName("REQUESTSHOTS"), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
+        SendReliable(BuildMessage("", { MessageHeader(miRequestShots), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
     }
 
 
     void CNetworkHandler::SendSyncPlayers(void) {
         LOG("SendSyncPlayers\n")
-        Transmit(BuildMessage("", { IdFromName("REQUESTPLAYERS"), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
+        SendReliable(BuildMessage("", { MessageHeader(miRequestPlayers), CString(actorHandler->m_viewer->GetPort(0)) }), m_hostAddress, m_hostPorts[0]);
     }
 
 
@@ -239,98 +597,231 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
             address = m_hostAddress;
             port = m_hostPorts[0];
         }
-        Transmit(BuildMessage("", { IdFromName("ENTER"), CString(actorHandler->m_viewer->m_colorIndex),  m_semicolon, CString(InPort()) }), address, port);
+        SendReliable(EnterMessage(), address, port);   // falls back to a text message for peers we don't know yet
     }
 
 
     // accept tells the player requesting to join his own ip address since it it somewhat tedious to determine your own external ip address when behing a router, firewall && what not
     void CNetworkHandler::SendAccept(CPlayer * player) {
         LOG("SendAccept\n")
-        CString message = BuildMessage(";", { IdFromName("ACCEPT") + CString(player->m_colorIndex), VectorToMessage(player->GetPosition()), VectorToMessage(player->GetOrientation()), player->m_address });
-        Transmit(message, player->m_address, player->GetPort(0));
+        SendReliable(AcceptMessage(player), player->m_address, player->GetPort(0));
     }
 
 
     // format: MAP:<tag>:<text line #include "map file>
     //         tags: reversed line number (starting at line count of map - 1) => 0 for last line
+    // Binary peers get all rows as a single message, separated by line feeds, which compresses well (see QueueReliable)
     void CNetworkHandler::SendMap(CString address, uint16_t port) {
         LOG("SendMap\n")
         int l = int (gameItems->m_map->m_stringMap.Length());
+        CNetworkPeer* peer = m_binaryFormat ? FindPeer(address, port, 0) : nullptr;
+        if (peer && peer->m_binaryFormat) {
+            CString rows;
+            for (auto [i, s] : gameItems->m_map->m_stringMap) {
+                if (!rows.Empty())
+                    rows += "\n";
+                rows += MapMessage(--l, s);
+            }
+            if (QueueReliable(*peer, rows))
+                return;
+            l = int (gameItems->m_map->m_stringMap.Length());
+        }
         for (auto [i, s] : gameItems->m_map->m_stringMap)
-            Transmit(BuildMessage (";", { IdFromName("SYNCMAP") + CString(--l), s }), address, port);
+            SendReliable(MapMessage(--l, s), address, port);
     }
 
 
-    // format: PARAMS:<fire delay>;<heal delay>;<respawn delay>;<immunity duration>;<points for kill>;<projectile size>;<projectile speed>;<move speed>;<turn speed>
     void CNetworkHandler::SendParams(CString address, uint16_t port) {
         LOG("SendParams\n")
-        CString message = 
-            BuildMessage(";", { 
-                IdFromName("SYNCPARAMS") + CString(gameData->m_fireMode), 
-                CString(gameData->m_fireDelay),
-                CString(gameData->m_healDelay), 
-                CString(gameData->m_respawnDelay), 
-                CString(gameData->m_immunityDuration),
-                CString(gameData->m_pointsForKill), 
-                CString(gameData->m_projectileSize),
-                CString(gameData->m_projectileSpeed), 
-                CString(controlsHandler->GetMoveSpeed()), 
-                CString(controlsHandler->GetTurnSpeed()) 
-            });
-        Transmit(message, address, port);
+        SendReliable(ParamsMessage(), address, port);
     }
 
 
-    // format: PLAYERS<player data>[;<player data> [...]]
-    // player data: <address>:<port>;<color index>
     void CNetworkHandler::SendPlayers(CString address, uint16_t port) {
         LOG("SendPlayers\n")
-        CString message;
-        message.Reserve(500);
-        message += IdFromName("SYNCPLAYERS");
-        // add addresses of all other players to player requesting to join
-        for (auto [i, a] : actorHandler->m_actors) {
-            if (a->IsPlayer ()) {  // player
-                if (i > 0)    // !the first entry in the list
-                    message += ";";
-                message += BuildMessage(";", { a->GetAddress () + ":" + CString (a->GetPort (0)), CString (a->GetPort (1)), CString (a->GetColorIndex ())});
-            }
-        }
-        Transmit(message, address, port);
+        SendReliable(PlayersMessage(), address, port);
     }
 
 
-    // format: SHOTS<shot data>[;<shot data> [...]]
-    // shot data: <actor id>;<parent color index>
     void CNetworkHandler::SendProjectiles(CString address, uint16_t port) {
         LOG("SendProjectiles\n")
-        CString message;
-        message.Reserve(500);
-        message += IdFromName("SYNCSHOTS");
-        // add addresses of all other players to player requesting to join
-        for (auto [i, a] : actorHandler->m_actors) {
-            if (a->IsProjectile ()) {  // projectile
-                if (i > 0)    // !the first entry in the list
-                    message += ";";
-                message += CString(a->m_id);
-                message += ";";
-                message += CString(a->GetColorIndex ());
-            }
-        }
-        Transmit(message, address, port);
+        SendReliable(ProjectilesMessage(), address, port);
+    }
+
+
+    // The join snapshot consists of the messages the client would otherwise request one by one (map rows, game
+    // parameters, players, projectiles, accept), separated by line feeds. It is the only record of its message, which
+    // usually gets compressed && fragmented (see QueueReliable).
+    // JOIN record: <join snapshot version (byte)><length (varint)><data>
+    void CNetworkHandler::SendJoin(CPlayer* player) {
+        LOG("SendJoin\n")
+        CString data;
+        int l = int (gameItems->m_map->m_stringMap.Length());
+        for (auto [i, s] : gameItems->m_map->m_stringMap)
+            data += MapMessage(--l, s) + "\n";
+        data += ParamsMessage() + "\n";
+        data += PlayersMessage(player) + "\n";
+        data += ProjectilesMessage() + "\n";
+        data += AcceptMessage(player);
+        CPacketWriter header;
+        header.WriteByte(uint8_t(miJoin));
+        header.WriteByte(JOIN_VERSION);
+        header.WriteVarInt(uint32_t(data.Length()));
+        CString record((char*) header.Buffer() + PACKET_HEADER_SIZE, int(header.Length() - PACKET_HEADER_SIZE));
+        record.Append(data.Buffer(), data.Length());
+        QueueReliable(player->m_peer, record);
     }
 
 
     // send an update message to a single player
     void CNetworkHandler::SendUpdate(CString address, uint16_t port) {
         LOG("SendUpdate\n")
-        Transmit(IdFromName("UPDATE") + UpdateMessage(actorHandler->m_viewer), address, port);
+        NextUpdateSequence();
+        Transmit(MessageHeader(miUpdate) + UpdateMessage(actorHandler->m_viewer), address, port);
     }
 
 
     void CNetworkHandler::SendReject(CString address, uint16_t port, const char* reason) {
         LOG("SendReject\n")
-        Transmit(IdFromName("REJECT") + CString (reason), address, port);
+        Transmit(MessageHeader(miReject) + CString (reason), address, port);
+    }
+
+
+    // queue the current snapshot for a binary peer, delta compressed against the last snapshot the peer has acknowledged
+    void CNetworkHandler::SendSnapshot(CPlayer* player, CSnapshot& snapshot) {
+        CNetworkPeer& peer = player->m_peer;
+        CSnapshot* baseline = peer.SentSnapshot(peer.m_snapshotAck);
+        CSnapshot& sent = m_adaptiveSendRate ? BudgetSnapshot(peer, snapshot, baseline) : snapshot;
+        CPacketWriter record;
+        UpdateRecord(record, sent, baseline, ViewTime(player));
+        QueueRecords(player, record);
+        peer.StoreSnapshot(peer.m_sentSnapshots, sent, peer.PendingSequence());
+        for (int i = 0; i < sent.m_actorCount; i++) {
+            CActorState& state = sent.m_actors[i];
+            if (state.IsPlayer() && (state.m_colorIndex < MAX_PLAYERS))
+                peer.m_sentPositions[state.m_colorIndex] = state.m_position;
+        }
+    }
+
+
+    // players come first, so that projectile corrections are the ones left out if the snapshot gets full
+    CSnapshot& CNetworkHandler::MergeSnapshot(CPlayer* player, CSnapshot& relayed) {
+        m_mergedSnapshot.Copy(m_snapshot);
+        int colorIndex = player->GetColorIndex();
+        for (int i = 0; i < relayed.m_actorCount; i++)
+            if ((relayed.m_actors[i].m_colorIndex != colorIndex) && !m_mergedSnapshot.Add(relayed.m_actors[i]))
+                m_stats.m_droppedActors++;
+        return m_mergedSnapshot;
+    }
+
+
+    // Actors the player can see are sent with every snapshot, actors it can only hear every m_audibleInterval frames
+    // && all others every m_hiddenInterval frames, so that scores && hit points still get around. A player is also
+    // sent as long as the peer can see the position it has last been sent at: Otherwise a player walking out of the
+    // peer's sight would remain standing at the spot where the peer has seen it last.
+    // Peers sent fewer snapshots than there are network frames (see CCongestionControl) count their own snapshots
+    // instead of the network frames, && the intervals shrink accordingly.
+    CSnapshot& CNetworkHandler::FilterSnapshot(CPlayer* player, CSnapshot& snapshot) {
+        if (!m_interestManagement)
+            return snapshot;
+        CMap* map = gameItems->m_map;
+        CNetworkPeer& peer = player->m_peer;
+        CVector viewPosition = player->GetPosition();
+        float rateScale = peer.m_congestion.Rate(m_fps) / float(m_fps);
+        int audibleInterval = int(roundf(float(m_audibleInterval) * rateScale));
+        int hiddenInterval = int(roundf(float(m_hiddenInterval) * rateScale));
+        m_interestSnapshot.m_actorCount = 0;
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            CActorState& state = snapshot.m_actors[i];
+            CVector* sentPosition = (state.IsPlayer() && (state.m_colorIndex < MAX_PLAYERS)) ? peer.m_sentPositions + state.m_colorIndex : nullptr;
+            int interest = map->Interest(viewPosition, state.m_position, m_audibleDistance);
+            if ((interest < 2) && sentPosition && (map->Interest(viewPosition, *sentPosition, m_audibleDistance) == 2))
+                interest = 2;
+            int interval = (interest == 2) ? 1 : (interest == 1) ? audibleInterval : hiddenInterval;
+            if ((interval > 1) && ((peer.m_snapshotCount + uint32_t(state.m_colorIndex)) % uint32_t(interval) != 0))    // spread the updates of different players
+                continue;
+            m_interestSnapshot.Add(state);
+        }
+        return m_interestSnapshot;
+    }
+
+
+    // Every actor's priority grows with each snapshot it is left out of, so everybody gets its turn eventually.
+    // The sizes of the actor states are estimated by encoding them against the baseline the way UpdateRecord will.
+    // The actors chosen keep their order, so that unchanged ones still line up with the baseline.
+    CSnapshot& CNetworkHandler::BudgetSnapshot(CNetworkPeer& peer, CSnapshot& snapshot, CSnapshot* baseline) {
+        int order[MAX_SNAPSHOT_ACTORS];
+        int sizes[MAX_SNAPSHOT_ACTORS];
+        bool chosen[MAX_SNAPSHOT_ACTORS];
+        peer.Prioritize(snapshot);
+        int budget = peer.m_congestion.Budget() - 16 - (snapshot.m_actorCount + 7) / 8;   // record header && change flags
+        CPacketWriter scratch;
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            CActorState& state = snapshot.m_actors[i];
+            CActorState* base = baseline ? baseline->Find(state.m_id, state.m_colorIndex) : nullptr;
+            int fieldMask = base ? state.Compare(*base) : state.FieldMask();
+            scratch.Reset();
+            scratch.WriteVarInt(uint32_t(state.m_id));
+            scratch.WriteByte(uint8_t(state.m_colorIndex));
+            scratch.WriteByte(uint8_t(fieldMask));
+            state.Write(scratch, fieldMask);
+            sizes[i] = int(scratch.Length() - PACKET_HEADER_SIZE);
+            chosen[i] = false;
+            int j = i;
+            for (; (j > 0) && (peer.m_priorities[order[j - 1]].m_priority < peer.m_priorities[i].m_priority); j--)
+                order[j] = order[j - 1];
+            order[j] = i;
+        }
+        int chosenCount = 0;
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            int a = order[i];
+            if (sizes[a] <= budget) {
+                budget -= sizes[a];
+                chosen[a] = true;
+                peer.m_priorities[a].m_priority = 0.0f;
+                chosenCount++;
+            }
+        }
+        if (chosenCount == snapshot.m_actorCount)
+            return snapshot;
+        m_budgetSnapshot.m_actorCount = 0;
+        for (int i = 0; i < snapshot.m_actorCount; i++)
+            if (chosen[i])
+                m_budgetSnapshot.Add(snapshot.m_actors[i]);
+        return m_budgetSnapshot;
+    }
+
+
+    void CNetworkHandler::SendReliable(CString message, CString address, uint16_t port) {
+        CNetworkPeer* peer = m_binaryFormat ? FindPeer(address, port, 0) : nullptr;
+        if (!peer || !peer->m_binaryFormat || !QueueReliable(*peer, message))
+            Transmit(message, address, port, peer);
+    }
+
+
+    // FRAGMENT record: see networkfragments.h
+    bool CNetworkHandler::QueueReliable(CNetworkPeer& peer, CString& message) {
+        if (peer.m_channel.Send(message))
+            return true;
+        CFragmentedMessage fragments(message);
+        if (fragments.m_fragmentCount > MAX_FRAGMENTS)
+            return false;
+        for (int fragment = 0; fragment < fragments.m_fragmentCount; fragment++) {
+            size_t length = fragments.FragmentLength(fragment);
+            CPacketWriter record;
+            record.WriteByte(uint8_t(miFragment));
+            record.WriteUInt16(uint16_t(fragment));
+            record.WriteUInt16(uint16_t(fragments.m_fragmentCount));
+            record.WriteByte(fragments.m_flags);
+            record.WriteVarInt(uint32_t(fragments.m_messageLength));
+            record.WriteVarInt(uint32_t(length));
+            record.WriteBytes(fragments.Fragment(fragment), length);
+            peer.m_channel.Send(record.Buffer() + PACKET_HEADER_SIZE, record.Length() - PACKET_HEADER_SIZE);
+        }
+        m_stats.m_fragmentedMessages++;
+        m_stats.m_fragmentedBytes += message.Length();
+        m_stats.m_compressedBytes += fragments.m_data.Length();
+        return true;
     }
 
 
@@ -340,8 +831,17 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
             player = actorHandler->CreatePlayer(colorIndex, CVector (NAN, NAN, NAN), CVector (0,0,0), address, ports [0], ports [1]);
             if (!player)
                 SendReject (address, ports [0], "full");
-            else
+            else {
                 player->UpdateLastMessageTime ();
+                if ((address == m_syncingAddress) && (ports[1] == m_syncingPorts[1])) {
+                    // keep the messages exchanged while joining in flight && continue the packet sequence the client is used to
+                    player->m_peer.m_channel = m_syncingPeer.m_channel;
+                    player->m_peer.m_fragments = m_syncingPeer.m_fragments;
+                    player->m_peer.m_sequence = m_syncingPeer.m_sequence;
+                    player->m_peer.m_congestion = m_syncingPeer.m_congestion;
+                    player->m_peer.m_traffic = m_syncingPeer.m_traffic;
+                }
+            }
         }
         return player;
     }
@@ -358,9 +858,9 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
 
     // incoming message processing functions ========================================
 
-    //format: APPLY<host address>;<client rx port>
+    //format: APPLY<client rx port>[;<client color>;<binary format version>;<join snapshot version>]
     int CNetworkHandler::HandleApply(CMessage& message) {
-        if (!message.IsValid(1))
+        if (!message.IsValid(-1))
             return message.m_result;
         LOG ("HandleApply\n")
         if (m_syncingAddress == "")
@@ -369,17 +869,36 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
             SendReject (message.m_address, message.Int (0), "sync in progress");
             return -1;
         }
-        SendEnter(message.m_address, message.Int(0));
+        // the client (re)starts joining, so anything still in flight from a previous attempt is obsolete
+        m_syncingPorts[0] = uint16_t(message.Int(0));
+        m_syncingPorts[1] = message.m_port;
+        m_syncingPeer.Reset();
+        Transmit(EnterMessage(), message.m_address, message.Int(0));  // as text: the client doesn't know us yet
+        if (!m_binaryFormat || (message.m_numValues < 4) || (message.Int(2) != PACKET_VERSION) || (message.Int(3) != JOIN_VERSION))
+            return 1;   // the client will request the join data one by one
+        // the client will apply the join snapshot right away, so it is a player from now on
+        int colorIndex = message.Int(1);
+        if (!gameData->ColorIsAvailable(colorIndex))
+            colorIndex = -1;
+        CPlayer* player = AddPlayer(message.m_address, m_syncingPorts, colorIndex);
+        m_syncingAddress = "";
+        m_syncingPeer.Reset();
+        if (!player)
+            return -1;
+        player->m_peer.m_binaryFormat = true;
+        gameItems->m_map->FindSpawnPosition(player);
+        player->UpdateLastMessageTime ();
+        SendJoin(player);
         return 1;
     }
 
 
-    //format: ENTER<client color>;<client rx port>
+    //format: ENTER<client color>;<client rx port>[;<binary format version>[;<join snapshot version>]]
     int CNetworkHandler::HandleEnter(CMessage& message) {
-        if (!message.IsValid(2))
+        if (!message.IsValid(-2))
             return message.m_result;
         LOG("HandleEnter\n")
-        if (OutOfSync(jsConnected, false) && OutOfSync(jsApply)) // this message is permitted when already connected
+        if (OutOfSync(jsConnected, false) && OutOfSync(jsSnapshot, false) && OutOfSync(jsApply)) // this message is permitted when already connected
             return -1;
         int colorIndex = message.Int(0);
         if (IamMaster()) {   // reassign color if requested color is already in use
@@ -390,18 +909,28 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         CPlayer* player = AddPlayer(message.m_address, ports, colorIndex);  // colorIndex == -1 --> assign an available random color
         if (!player)
             return -1;
+        player->m_peer.m_binaryFormat = m_binaryFormat && (message.m_numValues > 2) && (message.Int(2) == PACKET_VERSION);
         if (IamMaster()) {
             gameItems->m_map->FindSpawnPosition(player);
             player->UpdateLastMessageTime ();
             SendAccept(player);
             m_syncingAddress = "";
+            m_syncingPeer.Reset();
         }
         else {
             if (message.m_address == m_hostAddress)
                 m_hostPorts[1] = message.m_port;
         }
-    if (m_joinState == jsApply)
-        m_joinState = jsMap;
+    if (m_joinState == jsApply) {
+        if (m_binaryFormat && player->m_peer.m_binaryFormat && (message.m_numValues > 3) && (message.Int(3) == JOIN_VERSION) && (message.m_address == m_hostAddress)) {
+            // the host is sending the join snapshot already (see HandleApply)
+            m_joinState = jsSnapshot;
+            m_requestedJoinState = jsSnapshot;
+            m_joinStateTimer.Start();
+        }
+        else
+            m_joinState = jsMap;
+    }
     return 1;
     }
 
@@ -449,7 +978,7 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
 
     // format: PARAMS<heal delay>;<respawn delay>;<immunity duration>;<move speed>;<turn speed>
     int CNetworkHandler::SyncParams(CMessage& message) {
-        if (!message.IsValid(9))
+        if (!message.IsValid(-10))  // the relay flag && the player limit are optional
             return message.m_result;
         LOG("SyncParams\n")
         if (OutOfSync(jsParams))
@@ -462,8 +991,13 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         gameData->m_pointsForKill = message.Int(5);
         gameData->m_projectileSize = message.Float(6);
         gameData->m_projectileSpeed = message.Float(7);
+#ifndef HEADLESS    // the dedicated server is the host, so it never receives these
         controlsHandler->SetMoveSpeed(message.Float(8));
         controlsHandler->SetTurnSpeed(message.Float(9));
+#endif
+        m_relay = (message.m_numValues > 10) && (message.Int(10) != 0);
+        if (message.m_numValues > 11)   // the host decides how many players the game has room for
+            gameData->SetMaxPlayers(message.Int(11));
         m_joinState = jsPlayers;
         return 1;
     }
@@ -548,6 +1082,7 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         actorHandler->m_viewer->SetPosition(message.Vector(1));
         actorHandler->m_viewer->SetOrientation(message.Vector(2));
         actorHandler->m_viewer->m_address = message.Str(3);
+        actorHandler->Reindex();    // the viewer's color && address have changed
         actorHandler->m_viewer->ForceRespawn();
         m_joinState = jsConnected;
         return 1;
@@ -555,15 +1090,12 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
 
 
     // format: FIRE<projectile id>;<projectile parent color index>
+    // Only binary peers send the flight data (see BroadcastFire). Text peers move the projectile with its updates.
     int CNetworkHandler::HandleFire(CMessage& message) {
-        if (!message.IsValid(2))
+        if (!message.IsValid(-2))
             return message.m_result;
         LOG("HandleFire\n")
-        CPlayer* parent = actorHandler->FindPlayer(message.Int(1));
-        if (!parent)
-            return -1;
-        CProjectile* projectile = actorHandler->CreateProjectile(parent, message.Int(0));
-        return projectile ? 1 : -1;
+        return ApplyFire(message.Int(0), message.Int(1));
     }
 
 
@@ -579,48 +1111,46 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
     }
 
 
-    // message: UPDATE<id>;<color>;<position>;<orientation>[;<player info>]
+    // message: UPDATE<id>;<color>[:<sequence>];<position>;<orientation>[;<player info>]
     // position: <x>,<y>,<z> (3 x float)
     // orientation: <pitch>,<yaw>,<roll> (3 x float angles)
-    // player info: <hitpoints>;<score>;<life state>;<scale> (only for players, !for projectiles)
+    // player info: <hitpoints>;<score>;<life state>;<scale>;<port> (only for players, !for projectiles)
+    // sequence: update sequence number of the sender (older clients neither send it, nor read the color beyond the
+    // number). UDP may deliver an actor's updates out of order || twice, so the actor && the sequence number are read
+    // ahead of tokenizing the message, && updates not newer than the last one applied are dropped right away.
     // an update #include "an unknown player will cause creation of that player since that player must have been accepted by the gamehost
     // || he wouldn't know this client's address. Receiving messages #include "unknown players may be the result of a previous disconnect
     int CNetworkHandler::HandleUpdate(CMessage& message) {
+        CActorState state;
+        uint16_t sequence = 0;
+        const char* ps = message.m_payload.Buffer() ? strchr(message.m_payload.Buffer(), '#') : nullptr;
+        if (ps) {
+            char* pe;
+            state.m_id = int(strtol(ps + 1, &pe, 10));
+            if (*pe == ';') {
+                state.m_colorIndex = int(strtol(pe + 1, &pe, 10));
+                if (*pe == ':')
+                    sequence = uint16_t(strtoul(pe + 1, nullptr, 10));
+            }
+        }
+        CActor* actor = actorHandler->FindActor(state.m_id, state.m_colorIndex);
+        if (IsStaleUpdate(actor, sequence, message))
+            return 0;
         if (!message.IsValid(-4))
             return message.m_result;
         // LOG("HandleUpdate\n")
-        int actorId = message.Int(0);
-        int colorIndex = message.Int(1);
-        CActor* actor = actorHandler->FindActor(actorId, colorIndex);
-        if (!actor) {
-            if (actorId != 0)
-                return 0;
+        state.m_position = message.Vector(2);
+        state.m_orientation = message.Vector(3);
+        if (state.IsPlayer()) {
             if (message.m_numValues < 9)
                 return -1;
-            uint16_t inPort = message.Int(8);
-            uint16_t ports[2] = { inPort, message.m_port };
-            actor = AddPlayer(message.m_address, ports, colorIndex);  // colorIndex == -1 --> assign an available random color
-            if (!actor) {
-                SendReject(message.m_address, inPort, "unknown");
-                return 0;
-            }
+            state.m_hitPoints = message.Int(4);
+            state.m_score = message.Int(5);
+            state.m_lifeState = message.Int(6);
+            state.m_scale = message.Float(7);
+            state.m_port = message.Int(8);
         }
-        actor->m_camera.BumpPosition();
-        actor->SetPosition(message.Vector(2));
-        actor->SetOrientation(-message.Vector(3));
-        actor->UpdateLastMessageTime();
-        if (actorId == 0) {  // player
-            if (message.m_numValues < 9)
-                return -1;
-            actor->SetHitPoints(message.Int(4));
-            actor->SetScore(message.Int(5));
-            actor->SetLifeState(CActor::eLifeStates (message.Int(6)));
-            actor->SetScale(message.Float(7));
-        }
-        else {
-            actor->UpdateFrozenTime();
-        }
-        return 1;
+        return ApplyUpdate(actor, state, message, 0, sequence);
     }
 
 
@@ -629,15 +1159,7 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         if (!message.IsValid(2))
             return message.m_result;
         LOG("HandleHit\n")
-        CPlayer* target = actorHandler->FindPlayer(message.Int(0));
-        if (!target)
-            return -1;
-        CPlayer* hitter = actorHandler->FindPlayer(message.Int(1));
-        if (!hitter)
-            return -1;
-        target->RegisterHit(hitter);
-        target->UpdateLastMessageTime ();
-        return 1;
+        return ApplyHit(message.Int(0), message.Int(1));
     }
 
 
@@ -656,7 +1178,13 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
             return message.m_result;
         // values = message.payload.Split (";")
         LOG("HandleLeave\n")
-        return actorHandler->DeletePlayer(message.Int(0)) ? 1 : -1;
+        CPlayer* player = actorHandler->FindPlayer(message.Int(0));
+        bool hostLeft = player && !IamMaster() && IsHost(player);
+        if (!actorHandler->DeletePlayer(message.Int(0)))
+            return -1;
+        if (hostLeft)
+            StartElection();
+        return 1;
     }
 
 
@@ -679,12 +1207,449 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
     }
 
 
+    // format: ELECT<number>;<color>
+    int CNetworkHandler::HandleElect(CMessage& message) {
+        if (!message.IsValid(2))
+            return message.m_result;
+        LOG("HandleElect\n")
+        if (m_joinState != jsConnected)
+            return 0;
+        StartElection();    // the host is gone for the sender, so it will soon be for us, too
+        uint32_t number = uint32_t(strtoul(message.Value(0), nullptr, 10));
+        int colorIndex = message.Int(1);
+        if ((number < m_bestElectionNumber) || ((number == m_bestElectionNumber) && (colorIndex < m_bestElectionColor))) {
+            m_bestElectionNumber = number;
+            m_bestElectionColor = colorIndex;
+        }
+        return 1;
+    }
+
+
+    // an update from an unknown player will cause creation of that player (see HandleUpdate)
+    int CNetworkHandler::ApplyUpdate(CActor* actor, CActorState& state, CMessage& message, uint32_t sendTime, uint16_t sequence) {
+        if (!actor) {
+            if (!state.IsPlayer())
+                return 0;
+            if (m_sender && (m_sender->GetColorIndex() != state.m_colorIndex))  // relayed by the host: we can't tell the player's address
+                return 0;
+            uint16_t ports[2] = { state.m_port, message.m_port };
+            actor = AddPlayer(message.m_address, ports, state.m_colorIndex);  // colorIndex == -1 --> assign an available random color
+            if (!actor) {
+                SendReject(message.m_address, state.m_port, "unknown");
+                return 0;
+            }
+        }
+        if (sequence)
+            actor->m_updateSequence = sequence;
+        if (actor->IsProjectile() && ((CProjectile*) actor)->m_isSimulated) {
+            ((CProjectile*) actor)->Correct(state.m_position);
+            actor->UpdateLastMessageTime();
+            return 1;
+        }
+        if ((m_interpolationDelay > 0) && state.m_position.IsValid()) {
+            CVector angles = -state.m_orientation;
+            // with synchronized clocks, the send time plus the transmission delay is the arrival time without the jitter
+            uint32_t arrivalTime = message.m_time;
+            if (sendTime && HaveMatchTime() && m_sender && m_sender->m_peer.m_clock.m_synchronized)
+                arrivalTime = LocalTime(sendTime) + uint32_t(m_sender->m_peer.m_clock.Delay());
+            actor->m_states.Add(arrivalTime, sendTime, state.m_position, angles);
+            if (!actor->HavePosition()) {   // nothing to interpolate from yet
+                actor->SetPosition(state.m_position);
+                actor->SetOrientation(angles);
+            }
+        }
+        else {
+            actor->m_states.Reset();
+            actor->m_camera.BumpPosition();
+            actor->SetPosition(state.m_position);
+            actor->SetOrientation(-state.m_orientation);
+        }
+        actor->UpdateLastMessageTime();
+        if (state.IsPlayer()) {
+            actor->SetHitPoints(state.m_hitPoints);
+            actor->SetScore(state.m_score);
+            actor->SetLifeState(CActor::eLifeStates (state.m_lifeState));
+            actor->SetScale(state.m_scale);
+        }
+        else {
+            actor->UpdateFrozenTime();
+        }
+        return 1;
+    }
+
+
+    int CNetworkHandler::ApplyFire(int id, int colorIndex) {
+        CPlayer* parent = actorHandler->FindPlayer(colorIndex);
+        if (!parent)
+            return -1;
+        CProjectile* projectile = actorHandler->CreateProjectile(parent, id);
+        return projectile ? 1 : -1;
+    }
+
+
+    // The shot has been fired at match time fireTime. Move it to where it is now.
+    int CNetworkHandler::ApplyFire(int id, int colorIndex, CVector origin, CVector direction, uint32_t fireTime) {
+        CPlayer* parent = actorHandler->FindPlayer(colorIndex);
+        if (!parent)
+            return -1;
+        if (!origin.IsValid() || !direction.IsValid() || (direction.Len() < 0.5f))
+            return ApplyFire(id, colorIndex);
+        CProjectile* projectile = actorHandler->CreateProjectile(parent, id);
+        if (!projectile)
+            return -1;
+        int age = HaveMatchTime() ? int(MatchTime() - fireTime) : 0;
+        if (age < 0)
+            age = 0;
+        else if (age > MAX_PROJECTILE_AGE)
+            age = MAX_PROJECTILE_AGE;
+        projectile->Launch(origin, direction.Normalize(), float(age) / float(physicsHandler->m_frameTime));
+        return 1;
+    }
+
+
+    int CNetworkHandler::ApplyHit(int targetColorIndex, int hitterColorIndex) {
+        CPlayer* target = actorHandler->FindPlayer(targetColorIndex);
+        if (!target)
+            return -1;
+        CPlayer* hitter = actorHandler->FindPlayer(hitterColorIndex);
+        if (!hitter)
+            return -1;
+        target->RegisterHit(hitter);
+        target->UpdateLastMessageTime ();
+        return 1;
+    }
+
+    // binary record processing functions ========================================
+
+    // format: see UpdateRecord
+    // Snapshots older than the last one applied && snapshots whose baseline isn't available (anymore) are skipped.
+    // The sender will keep using older baselines (or none) until we acknowledge a newer snapshot.
+    int CNetworkHandler::HandleUpdateRecord(CPacketReader& packet, CMessage& message) {
+        size_t length = packet.ReadUInt16();
+        size_t end = packet.m_offset + length;
+        uint16_t baseSequence = packet.ReadUInt16();
+        uint32_t sendTime = packet.ReadUInt32();
+        uint32_t viewTime = packet.ReadUInt32();
+        uint16_t updateSequence = packet.ReadUInt16();
+        CNetworkPeer* peer = m_sender ? &m_sender->m_peer : nullptr;
+        if (peer && peer->IsStale(packet.m_sequence)) {
+            CountStaleUpdate(peer, packet.m_sequence == peer->m_lastSnapshot);
+            packet.SkipTo(end);
+            return 0;
+        }
+        CSnapshot* baseline = (peer && baseSequence) ? peer->ReceivedSnapshot(baseSequence) : nullptr;
+        // the host treats a client as a player as soon as it has sent the join snapshot, so snapshots may arrive before
+        // the client has got the map && knows the other players
+        if ((m_joinState != jsConnected) || (baseSequence && !baseline)) {
+            packet.SkipTo(end);
+            return 0;
+        }
+        CSnapshot& snapshot = m_peerSnapshot;
+        uint32_t actorCount = packet.ReadVarInt();  // unsigned, so a malformed count can't turn negative
+        if (actorCount > MAX_SNAPSHOT_ACTORS) {
+            packet.SkipTo(end);
+            return -1;
+        }
+        snapshot.Reserve(int(actorCount));
+        snapshot.m_actorCount = int(actorCount);
+        uint8_t flags[(MAX_SNAPSHOT_ACTORS + 7) / 8];
+        for (int i = 0; i < (snapshot.m_actorCount + 7) / 8; i++)
+            flags[i] = packet.ReadByte();
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            CActorState& state = snapshot.m_actors[i];
+            if (!(flags[i >> 3] & (1 << (i & 7)))) { // unchanged
+                if (!baseline || (i >= baseline->m_actorCount)) {
+                    packet.SkipTo(end);
+                    return -1;
+                }
+                state = baseline->m_actors[i];
+            }
+            else {
+                int id = int(packet.ReadVarInt());
+                int colorIndex = packet.ReadByte();
+                int fieldMask = packet.ReadByte();
+                CActorState* base = baseline ? baseline->Find(id, colorIndex) : nullptr;
+                if (base)
+                    state = *base;
+                else {
+                    state = CActorState();
+                    state.m_id = id;
+                    state.m_colorIndex = colorIndex;
+                }
+                state.Read(packet, fieldMask);
+            }
+        }
+        if (packet.m_error || (packet.m_offset != end)) {
+            packet.SkipTo(end);
+            return -1;
+        }
+        if (peer) {
+            peer->StoreSnapshot(peer->m_receivedSnapshots, snapshot, packet.m_sequence);
+            peer->m_lastSnapshot = packet.m_sequence;
+            peer->m_snapshotTime = sendTime;
+            // the peer has sent the snapshot at sendTime && has seen us as we were at viewTime then
+            if (viewTime) {
+                int viewLag = int(sendTime - viewTime);
+                peer->m_viewLag = (viewLag < 0) ? 0 : viewLag;
+            }
+        }
+        // relayed actors' states have been sent at times on their owners' clocks we don't know, && carry their owners'
+        // update sequence numbers. The host sends an actor's last state again until its owner has sent a new one.
+        int colorIndex = m_sender ? m_sender->GetColorIndex() : -1;
+        for (int i = 0; i < snapshot.m_actorCount; i++) {
+            CActorState& state = snapshot.m_actors[i];
+            bool isOwn = (state.m_colorIndex == colorIndex);
+            uint16_t sequence = isOwn ? updateSequence : state.m_sequence;
+            CActor* actor = actorHandler->FindActor(state.m_id, state.m_colorIndex);
+            if (!IsStaleUpdate(actor, sequence, message, !isOwn))
+                ApplyUpdate(actor, state, message, isOwn ? sendTime : 0, sequence);
+        }
+        return 1;
+    }
+
+
+    // Sequence numbers far behind the last update rather indicate that the actor's owner has restarted (see CNetworkPeer::IsStale)
+    bool CNetworkHandler::IsStaleUpdate(CActor* actor, uint16_t sequence, CMessage& message, bool mayRepeat) {
+        if (!actor || !sequence || !actor->m_updateSequence)
+            return false;
+        uint16_t age = actor->m_updateSequence - sequence;
+        if ((age >= 1024) || ((age == 0) && mayRepeat))
+            return false;
+        CountStaleUpdate(FindPeer(message.m_address, message.m_port, 1), age == 0);
+        return true;
+    }
+
+
+    void CNetworkHandler::CountStaleUpdate(CNetworkPeer* peer, bool isDuplicate) {
+        if (isDuplicate) {
+            m_stats.m_duplicateUpdates++;
+            if (peer)
+                peer->m_duplicateUpdates++;
+        }
+        else {
+            m_stats.m_reorderedUpdates++;
+            if (peer)
+                peer->m_reorderedUpdates++;
+        }
+    }
+
+
+    // format: <projectile id (varint)><projectile parent color (byte)><origin (position)><direction><fire time (uint32)>
+    int CNetworkHandler::HandleFireRecord(CPacketReader& packet, CMessage& message) {
+        int id = int(packet.ReadVarInt());
+        int colorIndex = packet.ReadByte();
+        CVector origin = packet.ReadPosition();
+        CVector direction = packet.ReadDirection();
+        uint32_t fireTime = packet.ReadUInt32();
+        if (packet.m_error)
+            return -1;
+        LOG("HandleFireRecord\n")
+        return ApplyFire(id, colorIndex, origin, direction, fireTime);
+    }
+
+
+    // format: <target color (byte)><hitter color (byte)>
+    int CNetworkHandler::HandleHitRecord(CPacketReader& packet, CMessage& message) {
+        int targetColorIndex = packet.ReadByte();
+        int hitterColorIndex = packet.ReadByte();
+        if (packet.m_error)
+            return -1;
+        LOG("HandleHitRecord\n")
+        return ApplyHit(targetColorIndex, hitterColorIndex);
+    }
+
+
+    // format: <id (varint)><color (byte)>
+    int CNetworkHandler::HandleDestroyRecord(CPacketReader& packet, CMessage& message) {
+        int id = int(packet.ReadVarInt());
+        int colorIndex = packet.ReadByte();
+        if (packet.m_error)
+            return -1;
+        LOG("HandleDestroyRecord\n")
+        return actorHandler->DeleteActor(id, colorIndex) ? 1 : -1;
+    }
+
+
+    // format: see networkchannel.h
+    // The message is either a text message (starting with its decimal id) || a sequence of binary records.
+    // The peer is looked up again for every message delivered, since handling a message may remove it
+    // || (when a client has finished joining) move its channel to the new player.
+    int CNetworkHandler::HandleReliableRecord(CPacketReader& packet, CMessage& message) {
+        uint16_t session = packet.ReadUInt16();
+        uint16_t base = packet.ReadUInt16();
+        uint16_t sequence = packet.ReadUInt16();
+        size_t length = packet.ReadVarInt();
+        const uint8_t* data = packet.ReadBytes(length);
+        if (packet.m_error)
+            return -1;
+        CNetworkPeer* peer = FindPeer(message.m_address, message.m_port, 1);
+        if (!peer)
+            return 0;   // the sender will repeat the message until we know it
+        if (!peer->m_channel.Receive(session, base, sequence, data, length))
+            return 0;
+        CString payload;
+        while ((peer = FindPeer(message.m_address, message.m_port, 1)) && peer->m_channel.Deliver(payload)) {
+            bool isText = !payload.Empty() && isdigit(uint8_t(*payload.Buffer()));
+            if (IamRelay()) {
+                CPlayer* origin = FindPlayer(message.m_address, message.m_port);
+                int id = isText ? int(strtol(payload.Buffer(), nullptr, 10)) : payload.Empty() ? -1 : uint8_t(*payload.Buffer());
+                if (origin && origin->m_peer.m_binaryFormat && IsRelayed(id))
+                    RelayMessage(payload, origin, true);
+            }
+            DeliverMessage(payload, packet.m_sequence, message);
+        }
+        m_sender = FindPlayer(message.m_address, message.m_port);   // a delivered LEAVE may have removed the sender
+        return 1;
+    }
+
+
+    // The message is either a sequence of binary records || text. Text may consist of several messages separated by
+    // line feeds (see SendMap).
+    void CNetworkHandler::DeliverMessage(CString& payload, uint16_t sequence, CMessage& message) {
+        if (payload.Empty() || !isdigit(uint8_t(*payload.Buffer()))) {
+            CPacketReader records((uint8_t*) payload.Buffer(), payload.Length());
+            records.m_sequence = sequence;
+            ProcessRecords(records, message);
+            return;
+        }
+        CMessage& m = m_deliveredMessage;
+        char* data = payload.Buffer();
+        size_t length = payload.Length();
+        for (size_t start = 0, end; start < length; start = end + 1) {
+            for (end = start; (end < length) && (data[end] != '\n'); end++)
+                ;
+            if ((start == 0) && (end == length))
+                m.m_payload = std::move(payload);
+            else
+                m.m_payload = CString(data + start, int(end - start));
+            m.m_address = message.m_address;
+            m.m_port = message.m_port;
+            m.m_time = message.m_time;
+            m.m_numValues = 0;
+            m.m_result = 0;
+            DispatchMessage(m);
+        }
+    }
+
+
+    // format: see networkchannel.h
+    int CNetworkHandler::HandleAckRecord(CPacketReader& packet, CMessage& message) {
+        uint16_t session = packet.ReadUInt16();
+        uint16_t ack = packet.ReadUInt16();
+        uint32_t ackBits = packet.ReadUInt32();
+        if (packet.m_error)
+            return -1;
+        CNetworkPeer* peer = FindPeer(message.m_address, message.m_port, 1);
+        if (!peer)
+            return 0;
+        peer->m_channel.Acknowledge(session, ack, ackBits, SDL_GetTicks());
+        return 1;
+    }
+
+
+    // format: <clock (uint32)><echo (uint32)><hold time (varint)><match time (uint32)>
+    // The clock is the sender's, the echo is the clock value of our last clock record it has received && the hold
+    // time is how long it has held that record (see CClockSync). The game host's match time is taken over, so all
+    // players share it: a host elected later keeps it going.
+    int CNetworkHandler::HandleClockRecord(CPacketReader& packet, CMessage& message) {
+        uint32_t peerTime = packet.ReadUInt32();
+        uint32_t echoTime = packet.ReadUInt32();
+        uint32_t holdTime = packet.ReadVarInt();
+        uint32_t matchTime = packet.ReadUInt32();
+        if (packet.m_error)
+            return -1;
+        CNetworkPeer* peer = FindPeer(message.m_address, message.m_port, 1);
+        if (!peer)
+            return 0;
+        CClockSync& clock = peer->m_clock;
+        clock.Received(peerTime, echoTime, holdTime, message.m_time);
+        if (clock.m_synchronized && m_sender && !IamMaster() && IsHost(m_sender)) {
+            m_matchOffset = clock.m_offset + int(matchTime - peerTime);
+            if (!m_haveMatchTime) {   // until now, the match time has been our clock: jump to the host's
+                m_matchTime = SDL_GetTicks() + uint32_t(m_matchOffset);
+                m_haveMatchTime = true;
+            }
+        }
+        return 1;
+    }
+
+
+    // format: see SendJoin
+    int CNetworkHandler::HandleJoinRecord(CPacketReader& packet, CMessage& message) {
+        int version = packet.ReadByte();
+        size_t length = packet.ReadVarInt();
+        const uint8_t* data = packet.ReadBytes(length);
+        if (packet.m_error || (version != JOIN_VERSION))
+            return -1;
+        if ((m_joinState != jsSnapshot) || (message.m_address != m_hostAddress))
+            return 0;
+        m_joinData = CString((char*) data, int(length));
+        if (ApplyJoinSnapshot(message))
+            return 1;
+        m_joinState = jsApply;
+        return -1;
+    }
+
+
+    // format: see networkfragments.h
+    // Fragments arrive in order (reliable channel). The reassembled message is handled as if the channel had delivered it.
+    int CNetworkHandler::HandleFragmentRecord(CPacketReader& packet, CMessage& message) {
+        int fragment = packet.ReadUInt16();
+        int fragmentCount = packet.ReadUInt16();
+        uint8_t flags = packet.ReadByte();
+        size_t messageLength = packet.ReadVarInt();
+        size_t length = packet.ReadVarInt();
+        const uint8_t* data = packet.ReadBytes(length);
+        if (packet.m_error)
+            return -1;
+        CNetworkPeer* peer = FindPeer(message.m_address, message.m_port, 1);
+        if (!peer)
+            return 0;
+        if ((m_joinState == jsSnapshot) && (message.m_address == m_hostAddress))
+            m_joinStateTimer.Start();  // the host is responding (see SendJoin)
+        CString payload;
+        int result = peer->m_fragments.Add(fragment, fragmentCount, flags, messageLength, data, length, payload);
+        if (result > 0) {
+            DeliverMessage(payload, packet.m_sequence, message);
+            m_sender = FindPlayer(message.m_address, message.m_port);   // see HandleReliableRecord
+        }
+        return result;
+    }
+
+
+    // the messages are handled as if they had been received one by one, walking through the join states
+    bool CNetworkHandler::ApplyJoinSnapshot(CMessage& message) {
+        LOG("ApplyJoinSnapshot\n")
+        m_mapRow = -1;
+        m_stringMap.Destroy();
+        m_joinState = jsMap;
+        CMessage m;
+        m.m_address = message.m_address;
+        m.m_port = message.m_port;
+        m.m_time = message.m_time;
+        char* data = m_joinData.Buffer();
+        for (size_t start = 0, end; start < m_joinData.Length(); start = end + 1) {
+            for (end = start; (end < m_joinData.Length()) && (data[end] != '\n'); end++)
+                ;
+            m.m_payload = CString(data + start, int(end - start));
+            m.m_numValues = 0;
+            m.m_result = 0;
+            DispatchMessage(m);
+        }
+        m_joinData = "";
+        return m_joinState == jsConnected;
+    }
+
+
     void CNetworkHandler::HandleTimeouts(void) {
         for (auto [i, a] : actorHandler->m_actors) {
             if (a->IsPlayer () && !a->IsViewer() && TimedOut((CPlayer*) a)) {
+                bool hostLost = !IamMaster() && (m_joinState == jsConnected) && IsHost((CPlayer*) a);
                 if (IamMaster())
                     BroadcastDestroy(a);
                 actorHandler->DeleteActor(a->m_id, a->GetColorIndex ());
+                if (hostLost)
+                    StartElection();
             }
         }
     }
@@ -702,49 +1667,207 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         }
     }
 
+    // host election ========================================
+
+    void CNetworkHandler::StartElection(void) {
+        if (m_electing)
+            return;
+        LOG("StartElection\n")
+        m_electing = true;
+        m_electionNumber = uint32_t(rand());
+        m_bestElectionNumber = m_electionNumber;
+        m_bestElectionColor = actorHandler->m_viewer->GetColorIndex();
+        m_electionTimer.Start();
+        m_electionResendTimer.Start();
+        BroadcastElect();
+    }
+
+
+    // format: ELECT<number>;<color>
+    void CNetworkHandler::BroadcastElect(void) {
+        Broadcast(BuildMessage(";", { MessageHeader(miElect) + CString(size_t(m_electionNumber)), CString(actorHandler->m_viewer->GetColorIndex()) }));
+    }
+
+
+    // votes are repeated a few times since they are sent to everybody directly && unreliably
+    void CNetworkHandler::UpdateElection(void) {
+        if (!m_electing)
+            return;
+        if (!m_electionTimer.HasPassed(m_electionDuration, false)) {
+            if (m_electionResendTimer.HasPassed(m_joinStateDelay, true))
+                BroadcastElect();
+            return;
+        }
+        m_electing = false;
+        if (m_bestElectionColor == actorHandler->m_viewer->GetColorIndex()) {
+            LOG("Elected as game host\n")
+            m_hostAddress = m_localAddress;
+            m_hostPorts[0] = InPort();
+            m_hostPorts[1] = OutPort();
+            return;
+        }
+        CPlayer* host = actorHandler->FindPlayer(m_bestElectionColor);
+        if (!host) {    // the winner has left meanwhile
+            StartElection();
+            return;
+        }
+        m_hostAddress = host->GetAddress();
+        m_hostPorts[0] = host->GetPort(0);
+        m_hostPorts[1] = host->GetPort(1);
+    }
+
     // broadcast functions ========================================
 
 
-    void CNetworkHandler::Broadcast(CString message) {
+    void CNetworkHandler::Broadcast(CString message, CPacketWriter* packet, bool reliable) {
+        CPlayer* relayHost = RelayHost();
         for (auto [i, a] : actorHandler->m_actors)
-            if (a->IsPlayer () && !a->IsLocalActor()) // players have id zero
-                Transmit(message, a->GetAddress (), a->GetPort (0));
+            if (a->IsPlayer () && !a->IsLocalActor()) { // players have id zero
+                CNetworkPeer& peer = ((CPlayer*) a)->m_peer;
+                if (relayHost && (a != relayHost) && peer.m_binaryFormat)  // the host will forward it
+                    continue;
+                if (reliable && peer.m_binaryFormat) {
+                    if (packet ? peer.m_channel.Send(packet->Buffer() + PACKET_HEADER_SIZE, packet->Length() - PACKET_HEADER_SIZE) : QueueReliable(peer, message))
+                        continue;
+                }
+                if (packet && peer.m_binaryFormat)
+                    QueueRecords((CPlayer*) a, *packet);
+                else
+                    Transmit(message, a->GetAddress (), a->GetPort (0), &peer);
+            }
+    }
+
+
+    // add records to the player's outgoing packet. Send the packet first if the records don't fit into it anymore
+    void CNetworkHandler::QueueRecords(CPlayer* player, CPacketWriter& records) {
+        if (!records.Empty())
+            m_stats.Sent(records.m_data[PACKET_HEADER_SIZE], records.Length() - PACKET_HEADER_SIZE);
+        if (!player->m_peer.m_packet.Fits(records))
+            SendPacket(player->m_peer, player->GetAddress (), player->GetPort (0));
+        player->m_peer.m_packet.Append(records);
+    }
+
+
+    void CNetworkHandler::SendPacket(CNetworkPeer& peer, CString address, uint16_t port) {
+        if (!peer.m_packet.Empty()) {
+            CCongestionControl& congestion = peer.m_congestion;
+            uint16_t sequence = peer.NextSequence();
+            peer.m_packet.SetHeader(sequence, peer.m_lastSnapshot, congestion.m_receivedSequence, congestion.m_receivedBits);
+            congestion.Sent(sequence, SDL_GetTicks());
+            peer.m_traffic.Sent(peer.m_packet.Length());
+            Transmit(peer.m_packet, address, port);
+        }
+        peer.m_packet.Reset();
+    }
+
+
+    // the acknowledgement rides along with whatever else is sent to the peer this frame
+    void CNetworkHandler::FlushPacket(CNetworkPeer& peer, CString address, uint16_t port) {
+        if (peer.m_binaryFormat) {
+            CReliableChannel& channel = peer.m_channel;
+            CPacketWriter& packet = peer.m_packet;
+            uint32_t now = SDL_GetTicks();
+            if (channel.m_ackPending) {
+                if (packet.Space() < 9)
+                    SendPacket(peer, address, port);
+                packet.WriteByte(uint8_t(miAck));
+                packet.WriteUInt16(channel.m_peerSession);
+                packet.WriteUInt16(channel.AckSequence());
+                packet.WriteUInt32(channel.AckBits());
+                channel.m_ackPending = false;
+                m_stats.Sent(miAck, 9);
+            }
+            if (peer.m_clock.Due(now)) {
+                if (packet.Space() < 18)
+                    SendPacket(peer, address, port);
+                size_t start = packet.Length();
+                packet.WriteByte(uint8_t(miClock));
+                packet.WriteUInt32(now);
+                packet.WriteUInt32(peer.m_clock.m_peerTime);
+                packet.WriteVarInt(peer.m_clock.HoldTime(now));
+                packet.WriteUInt32(MatchTime());
+                peer.m_clock.m_sendTime = now;
+                m_stats.Sent(miClock, packet.Length() - start);
+            }
+            for (CReliableChannel::CSentMessage* m; (m = channel.NextDue(now)) != nullptr; channel.MarkSent(m, now)) {
+                if (packet.Space() < CReliableChannel::RecordSize(m->m_data.Length()))
+                    SendPacket(peer, address, port);
+                packet.WriteByte(uint8_t(miReliable));
+                packet.WriteUInt16(channel.m_session);
+                packet.WriteUInt16(channel.m_oldestUnacked);
+                packet.WriteUInt16(m->m_sequence);
+                packet.WriteVarInt(uint32_t(m->m_data.Length()));
+                packet.WriteBytes((uint8_t*) m->m_data.Buffer(), m->m_data.Length());
+                m_stats.Sent(miReliable, CReliableChannel::RecordSize(m->m_data.Length()));
+            }
+        }
+        SendPacket(peer, address, port);
+    }
+
+
+    void CNetworkHandler::FlushPackets(void) {
+        for (auto [i, a] : actorHandler->m_actors)
+            if (a->IsPlayer () && !a->IsLocalActor())
+                FlushPacket(((CPlayer*) a)->m_peer, a->GetAddress (), a->GetPort (0));
+        if (m_syncingAddress != "")
+            FlushPacket(m_syncingPeer, m_syncingAddress, m_syncingPorts[0]);
     }
 
 
     // format: ANIMATION<color>;<animation>
     void CNetworkHandler::BroadcastAnimation(void) {
-        Broadcast(IdFromName("ANIMATION") + CString(actorHandler->m_viewer->GetColorIndex ()) + ";" + CString(actorHandler->m_viewer->m_animation));
+        Broadcast(MessageHeader(miAnimation) + CString(actorHandler->m_viewer->GetColorIndex ()) + ";" + CString(actorHandler->m_viewer->m_animation));
     }
 
 
     // tell every other player that we've been hit, && who hit us
     // format: HIT:<target color>:<hitter color>
-    // will always be sent asap
+    // will always be sent asap (binary peers: reliably, with the next network frame)
     void CNetworkHandler::BroadcastHit(CActor * player, CActor * hitter) {
         LOG("BroadcastHit\n")
-        Broadcast(IdFromName("HIT") + CString(player->GetColorIndex ()) + ";" + CString(hitter->GetColorIndex ()));
+        CPacketWriter packet;
+        packet.WriteByte(uint8_t(miHit));
+        packet.WriteByte(uint8_t(player->GetColorIndex ()));
+        packet.WriteByte(uint8_t(hitter->GetColorIndex ()));
+        Broadcast(MessageHeader(miHit) + CString(player->GetColorIndex ()) + ";" + CString(hitter->GetColorIndex ()), &packet, true);
     }
 
 
     // tell every other player that we have fired a projectile
     // format: FIRE:<id>;<parent color>
-    // will always be sent asap
+    // binary peers also get the projectile's origin, direction && fire time: Projectiles fly straight at a constant speed,
+    // so this is all they need to move it themselves. Text peers may be older clients, which only accept the id && color
+    // && move the projectile with its updates.
+    // will always be sent asap (binary peers: reliably, with the next network frame)
     void CNetworkHandler::BroadcastFire(CProjectile * projectile) {
         LOG("BroadcastFire\n")
-        Broadcast(IdFromName("FIRE") + CString(projectile->m_id) + ";" + CString(projectile->GetColorIndex()));
+        CVector origin = projectile->GetPosition();
+        CVector direction = projectile->Direction();
+        uint32_t fireTime = gameData->m_matchTime;
+        CPacketWriter packet;
+        packet.WriteByte(uint8_t(miFire));
+        packet.WriteVarInt(uint32_t(projectile->m_id));
+        packet.WriteByte(uint8_t(projectile->GetColorIndex()));
+        packet.WritePosition(origin);
+        packet.WriteDirection(direction);
+        packet.WriteUInt32(fireTime);
+        Broadcast(MessageHeader(miFire) + CString(projectile->m_id) + ";" + CString(projectile->GetColorIndex()), &packet, true);
     }
 
 
     void CNetworkHandler::BroadcastDestroy(CActor * actor) {
         LOG("BroadcastDestroy\n")
-        Broadcast(IdFromName("DESTROY") + CString(actor->m_id) + ";" + CString(actor->GetColorIndex()));
+        CPacketWriter packet;
+        packet.WriteByte(uint8_t(miDestroy));
+        packet.WriteVarInt(uint32_t(actor->m_id));
+        packet.WriteByte(uint8_t(actor->GetColorIndex()));
+        Broadcast(MessageHeader(miDestroy) + CString(actor->m_id) + ";" + CString(actor->GetColorIndex()), &packet, true);
     }
 
 
     void CNetworkHandler::BroadcastEnter(void) {
         LOG("BroadcastEnter\n")
-        Broadcast(IdFromName("ENTER") + CString(actorHandler->m_viewer->GetColorIndex ()));
+        Broadcast(MessageHeader(miEnter) + CString(actorHandler->m_viewer->GetColorIndex ()));
     }
 
 
@@ -752,7 +1875,8 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
     void CNetworkHandler::BroadcastLeave(int colorIndex) {
         if (colorIndex < 0)
             colorIndex = actorHandler->m_viewer->GetColorIndex ();
-        Broadcast(IdFromName("LEAVE") + CString(colorIndex));
+        Broadcast(MessageHeader(miLeave) + CString(colorIndex), nullptr, true);
+        FlushPackets();     // the players are removed right away, so there won't be another chance to send it
         for (auto [i, a] : actorHandler->m_actors)
             if (a->IsPlayer () && !a->IsViewer()) // players have id zero
                 actorHandler->DeletePlayer(a->GetColorIndex ());
@@ -761,53 +1885,170 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
 
     // inform every other player about our position && heading && position && heading of each of our shots
     // will be sent at the network fps
+    // binary peers receive a delta compressed snapshot of all actors instead (see SendSnapshot)
+    // Binary peers move our projectiles themselves (see BroadcastFire), so they only get their positions every now && then
+    // to correct for any divergence. Text peers may be older clients && need them every frame.
+    // In relay mode, clients only send their snapshot to the host, && the host adds the actors of all other binary peers
+    // to the snapshots it sends.
     void CNetworkHandler::BroadcastUpdate(void) {
         int colorIndex = actorHandler->m_viewer->GetColorIndex ();
+        bool needText = HaveTextPeers();     // don't format text messages nobody needs
+        bool correct = m_correctionTimer.HasPassed(m_correctionDelay, true);
+        CPlayer* relayHost = RelayHost();
+        bool relay = IamRelay();
+        uint32_t now = SDL_GetTicks();
+        CList<CString> messages;
+        CActorState state;
+        NextUpdateSequence();
+        m_snapshot.m_actorCount = 0;
+        for (auto [i, a] : actorHandler->m_actors)
+            if (a->GetColorIndex() == colorIndex) {   // actor is viewer || child of viewer
+                ActorState(a, state);
+                if ((a->IsPlayer() || correct) && !m_snapshot.Add(state))
+                    m_stats.m_droppedActors++;
+                if (needText)
+                    messages.Append(MessageHeader(miUpdate) + UpdateMessage(a));
+            }
+        CSnapshot& relayed = m_peerSnapshot;    // not in use outside of packet processing
+        relayed.m_actorCount = 0;
+        if (relay) {
+            for (int pass = 0; pass < 2; pass++)    // players first
+                for (auto [i, a] : actorHandler->m_actors)
+                    if ((a->GetColorIndex() != colorIndex) && (a->IsPlayer() == (pass == 0)) && (a->IsPlayer() || correct)) {
+                        CPlayer* owner = a->IsPlayer() ? (CPlayer*) a : actorHandler->FindPlayer(a->GetColorIndex());
+                        if (owner && owner->m_peer.m_binaryFormat) {
+                            ActorState(a, state);
+                            state.m_sequence = a->m_updateSequence;
+                            if (!relayed.Add(state))
+                                m_stats.m_droppedActors++;
+                        }
+                    }
+        }
         for (auto [i, a] : actorHandler->m_actors)
-            if (a->GetColorIndex() == colorIndex)   // actor is viewer || child of viewer
-                Broadcast(IdFromName("UPDATE") + UpdateMessage(a));
+            if (a->IsPlayer () && !a->IsLocalActor()) {
+                CNetworkPeer& peer = ((CPlayer*) a)->m_peer;
+                if (peer.m_binaryFormat) {
+                    if (relayHost && (a != relayHost))
+                        continue;
+                    if (m_adaptiveSendRate) {
+                        peer.m_congestion.Adjust(now, float(m_minPeerFps), float(m_fps), float(m_minPeerBandwidth), float(m_peerBandwidth));
+                        if (!peer.m_congestion.SnapshotDue(m_fps))
+                            continue;
+                    }
+                    peer.m_snapshotCount++;
+                    if (relayHost)  // the host needs everything to pass it on
+                        SendSnapshot((CPlayer*) a, m_snapshot);
+                    else
+                        SendSnapshot((CPlayer*) a, FilterSnapshot((CPlayer*) a, relay ? MergeSnapshot((CPlayer*) a, relayed) : m_snapshot));
+                }
+                else
+                    for (auto [j, m] : messages)
+                        Transmit(m, a->GetAddress (), a->GetPort (0), &peer);
+            }
     }
 
 
+    // the same list a joining player gets (see SyncPlayers)
     void CNetworkHandler::BroadcastPlayers(void) {
-        CString message = IdFromName("PLAYERS");
-        // add addresses of all other players to player requesting to join
-        for (auto [i, a] : actorHandler->m_actors) {
-            if (a->IsPlayer ()) {
-                if (i > 0)
-                    message += ";";
-                message += PlayerMessage((CPlayer*) a);
-            }
-        }
-        Broadcast(message);
+        Broadcast(PlayersMessage());
     }
 
 
     void CNetworkHandler::ProcessMessage(CMessage& message) {
         UpdateLastMessageTime(message);    // update last message time of player who sent this message
+        bool isBinary = message.IsBinary();
+        size_t length = message.m_payload.Length() + (isBinary ? 0 : 6);    // CUDP::Receive has stripped the text prefix
+        m_stats.m_traffic.Received(length);
+        CNetworkPeer* peer = FindPeer(message.m_address, message.m_port, 1);
+        if (peer)
+            peer->m_traffic.Received(length);
+        if (isBinary)
+            ProcessPacket(message);
+        else {
+            if (IamRelay() && IsRelayed(IdFromMessage(message))) {
+                CPlayer* origin = FindPlayer(message.m_address, message.m_port);
+                if (origin && origin->m_peer.m_binaryFormat)
+                    RelayMessage(message.m_payload, origin, false);
+            }
+            DispatchMessage(message);
+        }
+    }
+
+
+    void CNetworkHandler::DispatchMessage(CMessage& message) {
         int id = IdFromMessage(message);
+        if ((id >= 0) && !m_messageHandlers [id].m_handler)     // binary only message
+            id = -1;
         if (id < 0) {
             if (!message.Empty ())
-                ;// LOG("Received faulty message '%s'\n", message.m_payload.Buffer ());
+                m_stats.m_parseFailures++; // LOG("Received faulty message '%s'\n", message.m_payload.Buffer ());
         }
         else {
 #ifdef _DEBUG
-            if (id != 12) // UPDATE
-                LOG("%s\n", (char*) m_messageHandlers [id].m_name)
+            if (id != miUpdate)
+                LOG("%s\n", m_messageHandlers [id].m_name)
 #endif
-            if ((this->*m_messageHandlers [id].m_handler)(message) < 0)
-                ; // LOG("Received faulty %s message '%s'\n", m_messageHandlers [id].m_name.Buffer (), message.m_payload.Buffer ());
+            m_stats.Received(id, message.m_payload.Length());
+            uint64_t t = SDL_GetPerformanceCounter();
+            int result = (this->*m_messageHandlers [id].m_handler)(message);
+            m_stats.Handled(id, result, message.m_result < 0, SDL_GetPerformanceCounter() - t);    // m_result < 0: failed IsValid
+            if (result < 0)
+                ; // LOG("Received faulty %s message '%s'\n", m_messageHandlers [id].m_name, message.m_payload.Buffer ());
         }
     }
 
 
+    // process all records of a binary packet
+    void CNetworkHandler::ProcessPacket(CMessage& message) {
+        CPacketReader packet((uint8_t*) message.m_payload.Buffer(), message.m_payload.Length());
+        if (!packet.ReadHeader()) {
+            m_stats.m_parseFailures++;
+            return;
+        }
+        m_sender = FindPlayer(message.m_address, message.m_port);
+        if (m_sender)
+            m_sender->m_peer.UpdateSnapshotAck(packet.m_ack);
+        // a peer sending binary packets can obviously process them
+        CNetworkPeer* peer = FindPeer(message.m_address, message.m_port, 1);
+        if (peer) {
+            peer->m_binaryFormat = m_binaryFormat;
+            peer->m_congestion.Received(packet.m_sequence, message.m_time);
+            peer->m_congestion.Acknowledged(packet.m_receivedSequence, packet.m_receivedBits, message.m_time);
+        }
+        ProcessRecords(packet, message);
+        m_sender = nullptr;
+    }
+
+
+    void CNetworkHandler::ProcessRecords(CPacketReader& packet, CMessage& message) {
+        while (!packet.AtEnd()) {
+            size_t start = packet.m_offset;
+            int id = packet.ReadByte();
+            tRecordHandler handler = (id < miCount) ? m_messageHandlers [id].m_recordHandler : nullptr;
+            if (!handler) {
+                LOG("Received unknown record type %d\n", id)
+                m_stats.m_parseFailures++;
+                break;  // records don't have a length field, so the rest of the packet can't be parsed
+            }
+            uint64_t t = SDL_GetPerformanceCounter();
+            int result = (this->*handler)(packet, message);
+            m_stats.Handled(id, result, packet.m_error, SDL_GetPerformanceCounter() - t);  // a truncated record sets the error flag
+            m_stats.Received(id, packet.m_offset - start);
+        }
+    }
+
+
+    // process the messages queued by the listener thread. The queue is lock free, so the listener keeps
+    // receiving while the messages are being processed
     void CNetworkHandler::ProcessMessages(void) {
-        if (!m_messages.Empty()) {
-            m_listener.Lock();
-            for (auto [i, m] : m_messages)
-                ProcessMessage(m);
-            m_messages.Destroy();
-            m_listener.Unlock();
+        m_stats.m_queueDepth = m_messages.Length();
+        for (CMessage* m; (m = m_messages.Peek()) != nullptr; m_messages.Release())
+            ProcessMessage(*m);
+        size_t overflows = m_messages.Overflows();
+        if (overflows != m_messageOverflows) {
+            fprintf(stderr, "Network message queue overflow: %zu messages dropped (%zu total, queue size %zu)\n",
+                    overflows - m_messageOverflows, overflows, m_messages.Capacity());
+            m_messageOverflows = overflows;
         }
     }
 
@@ -821,10 +2062,20 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         if (m_joinState == jsApply) {
             if (!m_joinTimer.HasPassed(m_joinDelay, true))
                 return false;
+            m_requestedJoinState = jsApply;
         }
         else {
-            if (!m_joinStateTimer.HasPassed(m_joinStateDelay, true))
+            // requests sent through the reliable channel get through eventually, so they are only sent once per join state
+            // (and repeated if the host doesn't respond at all). Text peers are polled.
+            CPlayer* host = FindPlayer(m_hostAddress, m_hostPorts[1]);
+            if (host && host->m_peer.m_binaryFormat) {
+                if ((m_requestedJoinState == m_joinState) && !m_joinStateTimer.HasPassed(m_joinDelay, false))
+                    return false;
+                m_joinStateTimer.Start();
+            }
+            else if (!m_joinStateTimer.HasPassed(m_joinStateDelay, true))
                 return false;
+            m_requestedJoinState = m_joinState;
         }
         tJoinStateHandler stateHandler = m_joinStateHandlers[m_joinState];
         if (stateHandler)
@@ -837,19 +2088,20 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
         if (m_threadedListener)
             ProcessMessages();
         else {
-            CTimer listenTimer (5);
-            listenTimer.Start();
-            while (!listenTimer.HasPassed(5)) {    // listen && Handle messages for max. ~ 5 ms
-                CMessage message = Receive();
-                if (message.Empty())
-                    break;
-                ProcessMessage(message);
+            while (WaitForMessages(0)) {    // handle all messages that have arrived, without blocking
+                if (Receive(m_message) && !m_message.Empty())
+                    ProcessMessage(m_message);
             }
         }
     }
 
 
+    // Received messages are handed to the game every game frame, so they don't wait for the next network frame. Only
+    // sending is paced by the network frame rate.
     void CNetworkHandler::Update(void) {
+        gameData->m_matchTime = MatchTime();
+        BeginBatch();   // send everything this frame produces in one go
+        Listen ();
         if (m_updateTimer.HasPassed(m_frameTime, true)) {
             if (Joined()) {
                 BroadcastUpdate();
@@ -857,9 +2109,13 @@ void CNetworkHandler::Create(CString address, uint16_t port) {
                 //     BroadcastPlayers ();
                 HandleTimeouts();
             }
+            UpdateElection();
+            FlushPackets();
             HandleDisconnect ();
-            Listen ();
         }
+        SendBatch();
+        if (!m_statsFile.Empty() && m_statsTimer.HasPassed(m_statsInterval, true))
+            WriteStats();
     }
 
 CNetworkHandler* networkHandler = nullptr;
@@ -1,7 +1,9 @@
 #pragma once 
 
 #include <stdint.h>
-#include <winsock.h>
+#ifdef _WIN32
+#   include <winsock.h>
+#endif
 
 #include "SDL_net.h"
 #include "SDL_thread.h"
@@ -9,13 +11,19 @@
 #include "cstring.h"
 #include "clist.h"
 #include "cavltree.h"
+#include "cringbuffer.h"
 #include "timer.h"
 #include "vector.h"
 #include "actor.h"
 #include "player.h"
+#include "networkpeer.h"
 #include "projectile.h"
 #include "udp.h"
 #include "networklistener.h"
+#include "networkcapture.h"
+
+#define MAX_PROJECTILE_AGE  1000    // [ms] projectiles reported later than that are assumed to have been delayed on the way
+#define JOIN_VERSION        2       // format of the join snapshot (see SendJoin)
 
 // =================================================================================================
 // High level networking functions
@@ -23,7 +31,9 @@
 // Full n x n peer to peer network
 //
 // Every player manages the data of his own actor && any shots he fires. This means that every player
-// - detects whether his character has been hit && who hit it && will report that to all other players
+// - detects whether his character has been hit && who hit it && will report that to all other players. As the shooter
+//   sees him some time in the past, a remote player's shot is tested against where he has been at that time (lag
+//   compensation): Binary peers tell each other in their snapshots at which time they see each other (see UpdateRecord)
 // - updates all other players about his position && heading && the position && heading of all his shots
 //
 // This means that a client does !move around other actors than his own avatar && his own shots
@@ -33,9 +43,7 @@
 // 
 // - The game host's only task is to accept new players, give them the list of all players already in the game 
 // && assign an available color to them
-// - If the game host leaves #include "the game, he will randomly make another player game host
-// - If the game host gets disconnected, nobody can join a match in progress anymore, but any players in the match
-//   can keep playing
+// - If the game host leaves the game || gets disconnected, the remaining players elect a new game host (see below)
 //
 // For scoring purposes, players are identified by their color. Projectiles are identified by their parent player's color 
 // && an id that is unique on their client. The (id:color) tuple forms a match-wide unique projectile id by which projectiles
@@ -45,24 +53,62 @@
 //
 // - Every message will be prefixed with "SMIBAT", followed by a message index, followed by an optional value list
 // - Values will be semicolon separated
-// Find all message below in CnetworkHandler->messageHandlers
+// Find all message below in CNetworkHandler::m_messageHandlers (ids: eMessageIds)
 //
-// Alternatively, the game host could be taking over processing all collisions && updating all players
-// with all actor positions && headings. In that case, every client would only send his data to the host,
-// the host would Handle all client data && send the result to every client. The other clients would only need
-// to talk to each other in case the host unexpectedly drops out of the game (e.g. disconnects), in which case
-// they would need to negotiate a new game host. To negotiate a new host, each client could create a random number
-// && send it to each other. The client with the lowest number becomes the new host. In case of a tie, the tied
-// clients repeat this until resolution.
+// Alternatively, the game host can relay all traffic between the players (relay mode, chosen by the host && passed
+// on to joining players with the game parameters). In that case, every client only sends his data to the host,
+// && the host sends every client a single merged snapshot of all actors the client doesn't own && forwards the
+// game events (FIRE, HIT, DESTROY, ANIMATION, LEAVE) the other players have sent. This only works for binary peers;
+// text peers keep exchanging messages with everybody. The clients only talk to each other directly when joining
+// && in case the host drops out of the game (leaves || times out), in which case they negotiate a new game host:
+// Each client creates a random number && sends it to each other (ELECT). The client with the lowest number becomes
+// the new host. Ties are resolved by the lower color index rather than by repeating the vote.
 //
 // All data will be transmitted as text (I have no idea how to transform binary data back to object data in Python).
 // However, since there isn't a lot of data, this shouldn't be a problem.
 // Heading && position will be transmitted as three float angles (pitch, yaw, bank) && three float coordinates (x,y,z)
 // They will be packed in a string && can be parsed out of the string by the receiver.
+//
+// Peers announcing support for it in their ENTER message will be sent the high frequency messages (UPDATE, FIRE, HIT, 
+// DESTROY) in a compact binary format instead (see networkpacket.h). Peers sending binary packets are assumed to 
+// understand them, too. Binary records are collected per peer && sent once per network frame, packing as many
+// records as possible into each datagram.
+// Binary clients don't walk through the join states one request at a time: Their APPLY tells the host their color
+// && format versions, && the host answers with its ENTER && a join snapshot (map, game parameters, players,
+// projectiles && the client's spawn position, see SendJoin) sent through the reliable channel. The client applies it
+// once it has arrived completely, && is connected after a single round trip plus the transfer time.
+// Messages too large for a single packet (the join snapshot, long player && projectile lists, the map) are sent to
+// binary peers compressed && in fragments (see networkfragments.h && QueueReliable).
+// Instead of UPDATE messages, binary peers receive a snapshot of all actors owned by the local player, delta compressed
+// against the most recent snapshot the peer has acknowledged (see UpdateRecord).
+// Messages that must not get lost (FIRE, HIT, DESTROY, LEAVE && everything exchanged while joining after the host's
+// ENTER) are sent to binary peers through a reliable ordered channel (see networkchannel.h) carried by the same packets.
+// UPDATE snapshots stay unreliable: a lost snapshot is superseded by the next one anyway.
+// Each peer's snapshot only contains the actors of interest to it (interest management, see FilterSnapshot): Actors
+// in segments the peer's segment has a line of sight to are sent every frame, actors within hearing distance less
+// often && all others about once per second.
+// Each binary peer's link is watched by a congestion controller (see congestioncontrol.h) that lowers the rate at which
+// the peer is sent snapshots && the number of bytes a snapshot may take when packets get lost || delayed, && slowly
+// raises them again afterwards. If the actors of interest don't fit into the budget, those that have waited longest
+// (players counting double) are sent first (see BudgetSnapshot).
+// Traffic is counted per peer && per message type at all times && can be written to a file periodically (see
+// networkstats.h).
+// For testing, the datagrams can be exchanged through an in-memory network instead of sockets (virtualNetwork) && be
+// received with simulated latency, jitter, loss, duplication, reordering && bandwidth caps (net* settings, see
+// virtualnetwork.h).
+// All datagrams can be recorded to a capture file (captureFile) && a capture can be replayed instead of receiving
+// datagrams (replayFile, replaySpeed), e.g. to profile message processing || to reproduce a session (see
+// networkcapture.h).
+// Updates are numbered by their sender, && updates older than the last one applied to an actor (UDP reorders
+// datagrams) || received twice are dropped before they are parsed any further (see HandleUpdate).
+// Binary peers synchronize their clocks through CLOCK records (see clocksync.h). The game host's clock serves as match
+// time for everybody (see MatchTime), && all time stamps sent (shots' fire times, snapshots' send && view times) are
+// match times, so they can be compared to each other && to our own match time directly.
 
 class CNetworkHandler : public CUDP {
     public:
         typedef int (CNetworkHandler::*tMessageHandler) (CMessage&);
+        typedef int (CNetworkHandler::*tRecordHandler) (CPacketReader&, CMessage&);
         typedef void (CNetworkHandler::*tJoinStateHandler) (void);
 
         typedef enum {
@@ -72,19 +118,51 @@ class CNetworkHandler : public CUDP {
             jsPlayers = 3,      // wait for the host to send the list of participants
             jsProjectiles = 4,  // wait for the host to send the list of shots currently present
             jsEnter = 5,        // wait for the host to send position && heading
-            jsConnected = 6     // connected, ready to play
+            jsConnected = 6,    // connected, ready to play
+            jsSnapshot = 7      // wait for the host to send the join snapshot (replaces jsMap .. jsEnter)
         } eJoinStates;
 
+        // message ids as transmitted (decimal number followed by '#' in text messages, first byte of binary records)
+        typedef enum {
+            miApply = 0,
+            miAccept = 1,
+            miRequestMap = 2,
+            miSyncMap = 3,
+            miRequestParams = 4,
+            miSyncParams = 5,
+            miRequestPlayers = 6,
+            miSyncPlayers = 7,
+            miRequestShots = 8,
+            miSyncShots = 9,
+            miEnter = 10,
+            miAnimation = 11,
+            miUpdate = 12,
+            miFire = 13,
+            miHit = 14,
+            miDestroy = 15,
+            miLeave = 16,
+            miReject = 17,
+            miReliable = 18,    // binary only: message sent through the reliable channel
+            miAck = 19,         // binary only: acknowledgement of reliable messages
+            miElect = 20,
+            miJoin = 21,        // binary only: join snapshot
+            miClock = 22,       // binary only: clock synchronization (see CClockSync)
+            miFragment = 23,    // binary only: part of a message too large for a single packet (see networkfragments.h)
+            miCount
+        } eMessageIds;
+
         // ========================================
 
         class CMessageHandler {
         public:
-            CString         m_name;
+            const char*     m_name;
             tMessageHandler m_handler;
+            tRecordHandler  m_recordHandler;    // handler for the binary version of the message
 
-            CMessageHandler () : m_handler (nullptr) {}
+            constexpr CMessageHandler () : m_name (""), m_handler (nullptr), m_recordHandler (nullptr) {}
 
-            CMessageHandler(const char* name, tMessageHandler handler) : m_name(CString (name)), m_handler(handler) { }
+            constexpr CMessageHandler(const char* name, tMessageHandler handler, tRecordHandler recordHandler = nullptr) 
+                : m_name(name), m_handler(handler), m_recordHandler(recordHandler) { }
         };
 
         // ========================================
@@ -94,31 +172,76 @@ class CNetworkHandler : public CUDP {
         uint16_t        m_localPorts[2];
         CString         m_hostAddress;
         uint16_t        m_hostPorts[2];
-        CList<CMessage> m_messages;
+        CRingBuffer<CMessage>   m_messages;     // messages received by the listener thread, waiting to be processed
+        size_t                  m_messageOverflows; // dropped messages already reported
+        CMessage                m_message;          // receive buffer of the non threaded listener
+        CMessage                m_deliveredMessage; // text message delivered by a reliable channel
 
-        CList<CMessageHandler>      m_messageHandlers;
-        CArray<tJoinStateHandler>   m_joinStateHandlers;
-        CAvlTree<CString, CString>  m_idMap;
+        static const CMessageHandler    m_messageHandlers[miCount];
+        CString                         m_messageHeaders[miCount];  // "<id>#", prefix of all text messages
+        CArray<tJoinStateHandler>       m_joinStateHandlers;
 
-        int             m_fps;
+        int             m_fps;              // network frames (updates sent) per second
         int             m_frameTime;
+        int             m_interpolationDelay;   // [ms] remote actors are displayed this far in the past (0: as received)
+        int             m_correctionDelay;  // [ms] between two snapshots including our projectiles (receivers simulate them)
+        int             m_lagCompensation;  // [ms] max. time remote players' shots are tested against our past positions (0: off)
+        uint16_t        m_updateSequence;   // sequence number of the last update of the local actors sent (see HandleUpdate).
+                                            // All of them are sent together, so it numbers each one's updates.
+        bool            m_relay;            // relay mode: binary peers only exchange data with the game host
+        CSnapshot       m_mergedSnapshot;   // relay mode: snapshot sent by the host to a single client
+        bool            m_interestManagement;   // send peers actors out of their sight less often
+        float           m_audibleDistance;  // path distance up to which actors out of sight are still of interest
+        int             m_audibleInterval;  // network frames between two updates of actors a peer can only hear
+        int             m_hiddenInterval;   // network frames between two updates of actors a peer can neither see nor hear
+        CSnapshot       m_interestSnapshot; // snapshot reduced to the actors of interest to a single peer
+        bool            m_adaptiveSendRate; // adapt each binary peer's snapshot rate && size to its link (see CCongestionControl)
+        int             m_minPeerFps;       // lowest snapshot rate a peer is throttled to
+        int             m_peerBandwidth;    // [bytes/s] most snapshot data a peer is sent
+        int             m_minPeerBandwidth;
+        CSnapshot       m_budgetSnapshot;   // snapshot reduced to the actors fitting into a peer's budget
+        CNetworkStats   m_stats;
+        CString         m_statsFile;        // file the statistics are written to periodically (empty: none)
+        int             m_statsInterval;    // [ms]
+        CTimer          m_statsTimer;
+        CCaptureWriter  m_capture;          // records all datagrams if a capture file has been set
+        CReplayTransport*   m_replay;       // replays a capture instead of receiving datagrams (owned by CUDP)
+        bool            m_electing;         // a new game host is being elected
+        CTimer          m_electionTimer;
+        CTimer          m_electionResendTimer;
+        int             m_electionDuration; // [ms] to wait for the other players' votes
+        uint32_t        m_electionNumber;   // our vote
+        int             m_matchOffset;      // [ms] match time minus our clock
+        uint32_t        m_matchTime;        // match time last handed out
+        bool            m_haveMatchTime;    // the match time has been taken from the game host
+        uint32_t        m_bestElectionNumber;
+        int             m_bestElectionColor;
         CTimer          m_updateTimer;
         CTimer          m_joinTimer;
         CTimer          m_joinStateTimer;
         CTimer          m_playerUpdateTimer;
+        CTimer          m_correctionTimer;
         int             m_joinDelay;        // 5 seconds between two consecutive join attempts
         int             m_joinStateDelay;
         int             m_timeoutPeriod;    // seconds [ms] without message #include "a player after which the player will be removed #include "the game
         CList<CString>  m_stringMap;
         int             m_mapRow;
+        CString         m_joinData;         // join snapshot received
         bool            m_threadedListener;
         bool            m_listen;
+        bool            m_binaryFormat;     // use binary messages with peers supporting them
         CListener       m_listener;
         eJoinStates     m_joinState;
+        int             m_requestedJoinState;   // join state the host has last been sent a request for
+        CSnapshot       m_snapshot;         // states of all local actors, taken once per network frame
+        CSnapshot       m_peerSnapshot;     // snapshot being decoded from a binary packet
+        CPlayer*        m_sender;           // sender of the binary packet being processed
         CString         m_semicolon;
         CString         m_colon;
         CString         m_hashtag;
         CString         m_syncingAddress;
+        uint16_t        m_syncingPorts[2];
+        CNetworkPeer    m_syncingPeer;      // client currently joining (the host doesn't know it as a player yet)
 
         // ========================================
 
@@ -136,6 +259,21 @@ class CNetworkHandler : public CUDP {
 
         void SetHostAddress(CString address, uint16_t port);
 
+        // replace CUDP's sockets by virtual, impaired, capturing || replaying transports as the settings ask for
+        void CreateTransports(void);
+
+        // all datagrams of the capture being replayed have been processed
+        bool ReplayFinished(void);
+
+        // count the datagrams && messages sent (see CNetworkStats) && pass them on to CUDP. Text messages count towards
+        // the traffic of peer, if the caller knows it
+        bool Transmit(CString message, CString address, uint16_t port, CNetworkPeer* peer = nullptr);
+
+        bool Transmit(CPacketWriter& packet, CString address, uint16_t port);
+
+        // write the network statistics && the state of every peer's link to m_statsFile
+        void WriteStats(void);
+
         // message handling helper functions ========================================
 
         CString BuildMessage(const char* delim, std::initializer_list<CString> values);
@@ -145,9 +283,35 @@ class CNetworkHandler : public CUDP {
             // construct a message with all update info for actor 
         CString UpdateMessage(CActor* actor);
 
-        CString PlayerMessage(CPlayer* player);
+        CString EnterMessage(void);
+
+        CString MapMessage(int row, CString& text);
 
-        CString IdFromName(const char* textId);
+        CString ParamsMessage(void);
+
+        // all players except recipient
+        CString PlayersMessage(CPlayer* recipient = nullptr);
+
+        CString ProjectilesMessage(void);
+
+        CString AcceptMessage(CPlayer* player);
+
+            // quantized state of an actor as sent in binary update records
+        void ActorState(CActor* actor, CActorState& state);
+
+            // append a binary update record (snapshot delta compressed against baseline) to packet
+        void UpdateRecord(CPacketWriter& packet, CSnapshot& snapshot, CSnapshot* baseline, uint32_t viewTime);
+
+        inline CString& MessageHeader(eMessageIds id) {
+            return m_messageHeaders[id];
+        }
+
+        // number the next update of the local actors (skipping zero, which marks updates without a sequence number)
+        inline uint16_t NextUpdateSequence(void) {
+            if (++m_updateSequence == 0)
+                m_updateSequence = 1;
+            return m_updateSequence;
+        }
 
         int IdFromMessage(CMessage& message);
 
@@ -155,6 +319,9 @@ class CNetworkHandler : public CUDP {
 
         CPlayer* FindPlayer(CString& address, uint16_t port);
 
+        // find the peer (player || client currently joining) with the given address && in (0) || out (1) port
+        CNetworkPeer* FindPeer(CString& address, uint16_t port, int portType);
+
         size_t RemotePlayerCount(void);
 
         void UpdateLastMessageTime(CMessage& message);
@@ -165,8 +332,52 @@ class CNetworkHandler : public CUDP {
 
         int IamConnected(void);
 
+        // time remote actors are currently displayed at (see CInterpolationBuffer)
+        inline uint32_t DisplayTime(void) {
+            return SDL_GetTicks() - uint32_t(m_interpolationDelay);
+        }
+
+        // [ms] time all machines of the match agree on, within the accuracy of the clock synchronization. It is the
+        // clock of the game host that started the match && never runs backwards (see CClockSync)
+        uint32_t MatchTime(void);
+
+        // the game host's match time is known (until then, the match time is our clock)
+        inline bool HaveMatchTime(void) {
+            return m_haveMatchTime || IamMaster();
+        }
+
+        // convert a match time to our clock
+        inline uint32_t LocalTime(uint32_t matchTime) {
+            return matchTime - uint32_t(m_matchOffset);
+        }
+
+        // match time the player is currently displayed at (0: unknown)
+        uint32_t ViewTime(CPlayer* player);
+
+        // [ms] how far in the past the shooter sees the local player (lag compensation, see CCollisionHandler)
+        int ViewLag(CActor* shooter);
+
         bool TimedOut (CPlayer* player);
 
+        bool HaveTextPeers(void);
+
+        bool IsHost(CPlayer* player);
+
+        // the host if all data for binary peers is to be sent to the host only (relay mode), otherwise nullptr
+        CPlayer* RelayHost(void);
+
+        inline bool IamRelay(void) {
+            return m_relay && IamMaster() && !m_electing;
+        }
+
+        // messages the host forwards in relay mode
+        inline bool IsRelayed(int id) {
+            return (id == miAnimation) || (id == miFire) || (id == miHit) || (id == miDestroy) || (id == miLeave);
+        }
+
+        // forward a message received from origin to all other binary peers
+        void RelayMessage(CString& message, CPlayer* origin, bool reliable);
+
         // send functions ========================================
 
         void SendApply(void);
@@ -193,10 +404,31 @@ class CNetworkHandler : public CUDP {
 
         void SendProjectiles(CString address, uint16_t port);
 
+        // send everything a binary client needs to join in one go
+        void SendJoin(CPlayer* player);
+
         void SendUpdate(CString address, uint16_t port);
 
         void SendReject(CString address, uint16_t port, const char * reason);
 
+        void SendSnapshot(CPlayer* player, CSnapshot& snapshot);
+
+        // relay mode: add the states of all actors of the other binary peers to the host's snapshot for player
+        CSnapshot& MergeSnapshot(CPlayer* player, CSnapshot& relayed);
+
+        // reduce snapshot to the actors due to be sent to player this network frame (see CMap::Interest)
+        CSnapshot& FilterSnapshot(CPlayer* player, CSnapshot& snapshot);
+
+        // reduce snapshot to the actors with the highest priority fitting into the peer's snapshot budget
+        CSnapshot& BudgetSnapshot(CNetworkPeer& peer, CSnapshot& snapshot, CSnapshot* baseline);
+
+        // send message through the peer's reliable channel, || as plain text message if the peer can't handle that
+        void SendReliable(CString message, CString address, uint16_t port);
+
+        // queue message in the peer's reliable channel, sending it compressed && in fragments if it doesn't fit into
+        // a single packet. Returns false if it is too large even for that
+        bool QueueReliable(CNetworkPeer& peer, CString& message);
+
         CPlayer* AddPlayer(CString address, uint16_t ports[], int colorIndex);
 
         bool OutOfSync(eJoinStates joinState, bool isFinal = true);
@@ -239,13 +471,77 @@ class CNetworkHandler : public CUDP {
 
         int HandleReject(CMessage& message);
 
+        int HandleElect(CMessage& message);
+
+        // apply an update that has passed IsStaleUpdate to actor (nullptr: unknown actor)
+        int ApplyUpdate(CActor* actor, CActorState& state, CMessage& message, uint32_t sendTime = 0, uint16_t sequence = 0);
+
+        // check whether an update numbered sequence is older than || the same as the last one applied to actor
+        // (mayRepeat: the same one is fine)
+        bool IsStaleUpdate(CActor* actor, uint16_t sequence, CMessage& message, bool mayRepeat = false);
+
+        void CountStaleUpdate(CNetworkPeer* peer, bool isDuplicate);
+
+        int ApplyFire(int id, int colorIndex);
+
+        // launch a projectile with the flight data sent by the shooter (see CProjectile::Launch)
+        int ApplyFire(int id, int colorIndex, CVector origin, CVector direction, uint32_t fireTime);
+
+        int ApplyHit(int targetColorIndex, int hitterColorIndex);
+
+        // binary record processing functions ========================================
+
+        int HandleUpdateRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleFireRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleHitRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleDestroyRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleReliableRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleAckRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleJoinRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleClockRecord(CPacketReader& packet, CMessage& message);
+
+        int HandleFragmentRecord(CPacketReader& packet, CMessage& message);
+
+        // handle a message the reliable channel has delivered || that has been reassembled from fragments
+        void DeliverMessage(CString& payload, uint16_t sequence, CMessage& message);
+
+        // process the messages of a completely received join snapshot. Returns false if joining failed
+        bool ApplyJoinSnapshot(CMessage& message);
+
         void HandleTimeouts(void);
 
         void HandleDisconnect(void);
 
+        // host election ========================================
+
+        void StartElection(void);
+
+        void BroadcastElect(void);
+
+        void UpdateElection(void);
+
         // broadcast functions ========================================
 
-        void Broadcast(CString message);
+        // queue the records of packet for peers supporting the binary format (if a packet is passed), && send message to all others
+        // reliable: send the records (or message, if no packet is passed) to binary peers through their reliable channel
+        void Broadcast(CString message, CPacketWriter* packet = nullptr, bool reliable = false);
+
+        void QueueRecords(CPlayer* player, CPacketWriter& records);
+
+        void SendPacket(CNetworkPeer& peer, CString address, uint16_t port);
+
+        // add acknowledgement && due reliable messages to the peer's packet && send it
+        void FlushPacket(CNetworkPeer& peer, CString address, uint16_t port);
+
+        // send all binary records collected during the current network frame
+        void FlushPackets(void);
 
         void BroadcastAnimation(void);
 
@@ -265,6 +561,12 @@ class CNetworkHandler : public CUDP {
 
          void ProcessMessage(CMessage& message);
 
+         void DispatchMessage(CMessage& message);
+
+         void ProcessPacket(CMessage& message);
+
+         void ProcessRecords(CPacketReader& packet, CMessage& message);
+
          void ProcessMessages(void);
 
          bool Joined(void);
@@ -1,36 +1,43 @@
 #include "networklistener.h"
-#include "networkHandler.h"
+#include "networkhandler.h"
 
 // =================================================================================================
 
 int CListener::Run(void* dataPtr) {
     CListenerData& data = *((CListenerData*) dataPtr);
+    CNetworkHandler* handler = data.m_handler;
 
+    CMessage overflow;  // receives messages that don't fit into the message queue anymore
     while (*data.m_listen) {
-        CMessage message = networkHandler->Receive();
-        if (message.Empty ())
-            Sleep(5);
-        else {
-            SDL_mutexP (data.m_lock);
-            networkHandler->m_messages.Append(message);
-            SDL_mutexV (data.m_lock);
-        }
+        // receive directly into the next free queue slot
+        CMessage* message = handler->m_messages.Reserve();
+        if (!handler->Receive(message ? *message : overflow))
+            handler->WaitForMessages(-1);    // sleep until something arrives || Stop() is called
+        else if (message)
+            handler->m_messages.Commit();
+        else
+            handler->m_messages.Push(overflow);  // dropped && counted unless a slot has been freed meanwhile
     }
     return 0;
 }
 
 
-bool CListener::Start(bool *listen) {
+bool CListener::Start(bool *listen, CNetworkHandler* handler) {
     m_data.m_listen = listen;
+    m_data.m_handler = handler;
     m_data.m_thread = SDL_CreateThread(CListener::Run, "network listener", &m_data);
     return (m_data.m_thread != nullptr);
 }
 
 
+// CNetworkHandler::Destroy() is called again by the network handler's destructor
 void CListener::Stop(void) {
+    if (!m_data.m_thread)
+        return;
     *m_data.m_listen = false;
+    m_data.m_handler->StopWaiting();
     SDL_WaitThread(m_data.m_thread, nullptr);
-
+    m_data.m_thread = nullptr;
 }
 
 // =================================================================================================
@@ -6,7 +6,9 @@
 #include "SDL_thread.h"
 #include "SDL_mutex.h"
 #include "networkmessage.h"
-//#include "networkHandler.h"
+//#include "networkhandler.h"
+
+class CNetworkHandler;
 
 // =================================================================================================
 
@@ -19,8 +21,9 @@ class CListener {
                 SDL_Thread* m_thread;
                 SDL_mutex*  m_lock;
                 bool*       m_listen;
+                CNetworkHandler*    m_handler;  // the listener's own handler: a process may run several (see CBot)
 
-                CListenerData (bool* listen = nullptr) : m_thread (nullptr), m_lock (nullptr), m_listen (listen) {}
+                CListenerData (bool* listen = nullptr) : m_thread (nullptr), m_lock (nullptr), m_listen (listen), m_handler (nullptr) {}
         };
 
         CListenerData m_data;
@@ -45,7 +48,7 @@ class CListener {
             }
         }
     
-        bool Start(bool * listen);
+        bool Start(bool * listen, CNetworkHandler* handler);
 
         void Stop(void);
 
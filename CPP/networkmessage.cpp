@@ -19,14 +19,31 @@ bool CMessage::IsValid(int valueCount) {
             < 0: specifies the required minimum number of parameters
             == 0: don't check parameter count
     */
-    m_values = m_payload.Split('#');
-    CString keyword = m_values[0];
-    m_values = m_values[1].Split(';');
-    if (!m_values[0].Empty())
-        m_numValues = m_values.Length();
-    else {
-        m_values = CList<CString>();
-        m_numValues = 0;
+    // tokenize the payload in place: <id>#<value>[;<value>[...]]
+    const char* payload = m_payload.Buffer() ? m_payload.Buffer() : "";
+    const char* delim = strchr(payload, '#');
+    int keywordLength = delim ? int(delim - payload) : int(m_payload.Length());
+    m_numValues = 0;
+    if (delim && delim[1] && (delim[1] != ';')) {   // an empty first value means there are no values at all
+        for (const char* ps = delim + 1; *ps && (*ps != '#'); ps++) {
+            const char* pe = ps;
+            for (; *pe && (*pe != ';') && (*pe != '#'); pe++)
+                ;
+            if ((m_numValues >= MAX_MESSAGE_VALUES) && (m_numValues - MAX_MESSAGE_VALUES == m_moreTokens.Length())) {   // a reassembled message
+                m_moreTokens.Resize(m_moreTokens.Length() ? 2 * m_moreTokens.Length() : MAX_MESSAGE_VALUES);
+                if (m_numValues - MAX_MESSAGE_VALUES == m_moreTokens.Length()) {
+                    fprintf(stderr, "message %.*s has too many values\n", keywordLength, payload);
+                    m_result = -1;
+                    return false;
+                }
+            }
+            CToken& token = Token(m_numValues++);
+            token.m_offset = uint32_t(ps - payload);
+            token.m_length = uint32_t(pe - ps);
+            if (*pe != ';')
+                break;
+            ps = pe;
+        }
     }
     if (valueCount == 0) {
         m_result = 1;
@@ -44,9 +61,44 @@ bool CMessage::IsValid(int valueCount) {
             return true;
         }
     }
-    fprintf(stderr, "message %s has wrong number of values (expected %d, found %zd)", keyword.Buffer (), valueCount, m_numValues);
+    fprintf(stderr, "message %.*s has wrong number of values (expected %d, found %zd)", keywordLength, payload, valueCount, m_numValues);
     m_result = -1;
     return false;
 }
 
+
+int CMessage::Id(void) {
+    const char* ps = m_payload.Buffer();
+    if (!ps || !isdigit(*ps))
+        return -1;
+    int id = 0;
+    for (; isdigit(*ps); ps++)
+        id = id * 10 + (*ps - '0');
+    return (*ps == '#') ? id : -1;
+}
+
+
+CVector CMessage::Vector(size_t i) {
+    const char* ps = Value(i);
+    char* pe;
+    float coords[3];
+    for (int j = 0; j < 3; j++) {
+        coords[j] = strtof(ps, &pe);
+        ps = (*pe == ',') ? pe + 1 : pe;
+    }
+    return CVector(coords[0], coords[1], coords[2]);
+}
+
+
+CString CMessage::Address(size_t i, uint16_t& port) {
+    const char* ps = Value(i);
+    const char* pe = (const char*) memchr(ps, ':', ValueLength(i));
+    if (!pe) {
+        port = 0;
+        return Str(i);
+    }
+    port = uint16_t(strtoul(pe + 1, nullptr, 10));
+    return CString(ps, int(pe - ps));
+}
+
 // =================================================================================================
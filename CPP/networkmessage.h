@@ -4,7 +4,11 @@
 
 #include "cstring.h"
 #include "clist.h"
+#include "carray.h"
 #include "vector.h"
+#include "networkpacket.h"
+
+#define MAX_MESSAGE_VALUES  512     // values a message holds itself: a datagram can't hold more (at least two characters per value)
 
 // =================================================================================================
 // network data and address
@@ -21,8 +25,13 @@ class CMessage {
             ip address of the sender
         port:
             udp port of the sender
-        values:
-            List of single values #include "the payload
+        time:
+            time of reception [ms]
+        tokens:
+            offsets && lengths of the single values in the payload (the values aren't copied)
+        moreTokens:
+            tokens of the values beyond MAX_MESSAGE_VALUES. Only messages reassembled from fragments (see
+            networkfragments.h) have that many values, so datagrams are tokenized without allocating memory.
         numValues:
             Number of values
         result:
@@ -35,14 +44,22 @@ class CMessage {
     */
 
     public:
+        class CToken {
+            public:
+                uint32_t    m_offset;
+                uint32_t    m_length;
+        };
+
         CString         m_payload;
         CString         m_address;
         uint16_t        m_port;
-        CList<CString>  m_values;
+        uint32_t        m_time;
+        CToken          m_tokens[MAX_MESSAGE_VALUES];
+        CArray<CToken>  m_moreTokens;
         size_t          m_numValues;
         int             m_result;
 
-        CMessage() : m_numValues (0), m_port (0), m_result (0) {}
+        CMessage() : m_numValues (0), m_port (0), m_time (0), m_result (0) {}
 
         CMessage(CString message, CString address, uint16_t port) {
             /*
@@ -60,6 +77,7 @@ class CMessage {
             m_payload = message;
             m_address = address;
             m_port = port;
+            m_time = 0;
             m_numValues = 0;
             m_result = 0;
         }
@@ -69,8 +87,25 @@ class CMessage {
             return m_payload.Empty();
         }
 
+        // binary packets don't carry the "SMIBAT" prefix, but a packet header (see networkpacket.h)
+        inline bool IsBinary(void) {
+            return CPacketReader::IsPacket((uint8_t*) m_payload.Buffer(), m_payload.Length());
+        }
+
         bool IsValid(int valueCount = 0);
 
+        // return the numeric message id preceding the '#' (-1 if there is none)
+        int Id(void);
+
+        // start of the i-th value in the payload. Values end at the next delimiter
+        inline const char* Value(size_t i) {
+            return (i < m_numValues) ? m_payload.Buffer() + Token(i).m_offset : "";
+        }
+
+        inline size_t ValueLength(size_t i) {
+            return (i < m_numValues) ? Token(i).m_length : 0;
+        }
+
 
         CString Str(size_t i) {
             /*
@@ -80,7 +115,7 @@ class CMessage {
             -----------
                 i: Index of the requested parameter
             */
-            return m_values[i];
+            return CString(Value(i), int(ValueLength(i)));
         }
 
 
@@ -93,7 +128,7 @@ class CMessage {
             -----------
                 i: Index of the requested parameter
             */
-            return int(m_values[i]);
+            return int(strtol(Value(i), nullptr, 10));
         }
 
 
@@ -105,38 +140,22 @@ class CMessage {
             -----------
                 i: Index of the requested parameter
             */
-            return float(m_values[i]);
+            return strtof(Value(i), nullptr);
         }
 
 
         // format: <x>,<y>,<z> (3 x float)
-        CVector Vector(size_t i) {
-            /*
-            return i-th parameter value as 3D float vector
-
-            Parameters:
-            -----------
-                i: Index of the requested parameter
-            */
-            CList<CString> coords = m_values[i].Split(',');
-            return CVector(float(coords[0]), float(coords[1]), float(coords[2]));
-        }
+        CVector Vector(size_t i);
 
 
 
         // format: <ip v4 address>":"<port>
         // <ip address> = "//.//.//.//" (// = one to three digit subnet id)
-        CString Address(size_t i, uint16_t& port) {
-            /*
-            return i-th parameter value as ip address:port pair
+        CString Address(size_t i, uint16_t& port);
 
-            Parameters:
-            -----------
-                i: Index of the requested parameter
-            */
-            CList<CString> values = m_values[i].Split(':');
-            port = uint16_t(values[1]);
-            return values[0];
+    private:
+        inline CToken& Token(size_t i) {
+            return (i < MAX_MESSAGE_VALUES) ? m_tokens[i] : m_moreTokens[i - MAX_MESSAGE_VALUES];
         }
 };
 
@@ -0,0 +1,278 @@
+#include <math.h>
+
+#include "networkpacket.h"
+
+// =================================================================================================
+// Binary wire format
+
+#define POSITION_SCALE  128.0f
+#define ANGLE_SCALE     (32767.0f / 180.0f)
+#define DIRECTION_SCALE 32767.0f
+#define NO_POSITION     (-32768)    // quantized value of an undefined (NaN) coordinate
+
+static inline int16_t Quantize(float value, float scale) {
+    value = roundf(value * scale);
+    return int16_t((value < -32767.0f) ? -32767.0f : (value > 32767.0f) ? 32767.0f : value);
+}
+
+
+static inline uint8_t QuantizeScale(float scale) {
+    return uint8_t((scale <= 0.0f) ? 0 : (scale >= 1.0f) ? 255 : int(roundf(scale * 255.0f)));
+}
+
+
+static inline CVector QuantizeVector(CVector& v, float scale) {
+    if (!v.IsValid())
+        return CVector(NAN, NAN, NAN);
+    return CVector(float(Quantize(v.X(), scale)) / scale, float(Quantize(v.Y(), scale)) / scale, float(Quantize(v.Z(), scale)) / scale);
+}
+
+
+static inline bool VectorsDiffer(CVector& v1, CVector& v2) {
+    if (!v1.IsValid() || !v2.IsValid())
+        return v1.IsValid() != v2.IsValid();
+    return (v1.X() != v2.X()) || (v1.Y() != v2.Y()) || (v1.Z() != v2.Z());
+}
+
+// =================================================================================================
+
+void CPacketWriter::Reset(void) {
+    m_length = 0;
+    m_overflow = false;
+    WriteByte(PACKET_MAGIC);
+    WriteByte(PACKET_VERSION);
+    WriteUInt16(0);
+    WriteUInt16(0);
+    WriteUInt16(0);
+    WriteUInt32(0);
+}
+
+
+void CPacketWriter::Append(CPacketWriter& other) {
+    if (!Fits(other))
+        m_overflow = true;
+    else {
+        memcpy(m_data + m_length, other.m_data + PACKET_HEADER_SIZE, other.m_length - PACKET_HEADER_SIZE);
+        m_length += other.m_length - PACKET_HEADER_SIZE;
+    }
+}
+
+
+void CPacketWriter::WriteUInt16(uint16_t value) {
+    WriteByte(uint8_t(value));
+    WriteByte(uint8_t(value >> 8));
+}
+
+
+void CPacketWriter::WriteUInt32(uint32_t value) {
+    WriteUInt16(uint16_t(value));
+    WriteUInt16(uint16_t(value >> 16));
+}
+
+
+void CPacketWriter::WriteBytes(const uint8_t* data, size_t length) {
+    if (length > Space())
+        m_overflow = true;
+    else {
+        memcpy(m_data + m_length, data, length);
+        m_length += length;
+    }
+}
+
+
+void CPacketWriter::WriteVarInt(uint32_t value) {
+    while (value > 0x7F) {
+        WriteByte(uint8_t(value | 0x80));
+        value >>= 7;
+    }
+    WriteByte(uint8_t(value));
+}
+
+
+void CPacketWriter::WritePosition(CVector& position) {
+    if (!position.IsValid()) {
+        for (int i = 0; i < 3; i++)
+            WriteUInt16(uint16_t(NO_POSITION));
+    }
+    else {
+        WriteUInt16(uint16_t(Quantize(position.X(), POSITION_SCALE)));
+        WriteUInt16(uint16_t(Quantize(position.Y(), POSITION_SCALE)));
+        WriteUInt16(uint16_t(Quantize(position.Z(), POSITION_SCALE)));
+    }
+}
+
+
+// angles are expected to be in the range of [-180, 180] (see CCamera::ClampAngles)
+void CPacketWriter::WriteAngles(CVector& angles) {
+    WriteUInt16(uint16_t(Quantize(angles.X(), ANGLE_SCALE)));
+    WriteUInt16(uint16_t(Quantize(angles.Y(), ANGLE_SCALE)));
+    WriteUInt16(uint16_t(Quantize(angles.Z(), ANGLE_SCALE)));
+}
+
+
+void CPacketWriter::WriteDirection(CVector& direction) {
+    WriteUInt16(uint16_t(Quantize(direction.X(), DIRECTION_SCALE)));
+    WriteUInt16(uint16_t(Quantize(direction.Y(), DIRECTION_SCALE)));
+    WriteUInt16(uint16_t(Quantize(direction.Z(), DIRECTION_SCALE)));
+}
+
+
+void CPacketWriter::WriteScale(float scale) {
+    WriteByte(QuantizeScale(scale));
+}
+
+// =================================================================================================
+
+bool CPacketReader::ReadHeader(void) {
+    m_offset = 0;
+    m_error = false;
+    if (ReadByte() != PACKET_MAGIC)
+        return false;
+    if (ReadByte() != PACKET_VERSION)
+        return false;
+    m_sequence = ReadUInt16();
+    m_ack = ReadUInt16();
+    m_receivedSequence = ReadUInt16();
+    m_receivedBits = ReadUInt32();
+    return !m_error;
+}
+
+
+uint16_t CPacketReader::ReadUInt16(void) {
+    uint16_t value = ReadByte();
+    return value | (uint16_t(ReadByte()) << 8);
+}
+
+
+uint32_t CPacketReader::ReadUInt32(void) {
+    uint32_t value = ReadUInt16();
+    return value | (uint32_t(ReadUInt16()) << 16);
+}
+
+
+const uint8_t* CPacketReader::ReadBytes(size_t length) {
+    if (length > m_length - m_offset) {
+        m_error = true;
+        return nullptr;
+    }
+    const uint8_t* data = m_data + m_offset;
+    m_offset += length;
+    return data;
+}
+
+
+uint32_t CPacketReader::ReadVarInt(void) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = ReadByte();
+        value |= uint32_t(b & 0x7F) << shift;
+        if (!(b & 0x80))
+            return value;
+    }
+    m_error = true;
+    return 0;
+}
+
+
+CVector CPacketReader::ReadPosition(void) {
+    int16_t x = int16_t(ReadUInt16());
+    int16_t y = int16_t(ReadUInt16());
+    int16_t z = int16_t(ReadUInt16());
+    if ((x == NO_POSITION) || (y == NO_POSITION) || (z == NO_POSITION))
+        return CVector(NAN, NAN, NAN);
+    return CVector(float(x) / POSITION_SCALE, float(y) / POSITION_SCALE, float(z) / POSITION_SCALE);
+}
+
+
+CVector CPacketReader::ReadAngles(void) {
+    int16_t x = int16_t(ReadUInt16());
+    int16_t y = int16_t(ReadUInt16());
+    int16_t z = int16_t(ReadUInt16());
+    return CVector(float(x) / ANGLE_SCALE, float(y) / ANGLE_SCALE, float(z) / ANGLE_SCALE);
+}
+
+
+CVector CPacketReader::ReadDirection(void) {
+    int16_t x = int16_t(ReadUInt16());
+    int16_t y = int16_t(ReadUInt16());
+    int16_t z = int16_t(ReadUInt16());
+    return CVector(float(x) / DIRECTION_SCALE, float(y) / DIRECTION_SCALE, float(z) / DIRECTION_SCALE);
+}
+
+
+float CPacketReader::ReadScale(void) {
+    return float(ReadByte()) / 255.0f;
+}
+
+// =================================================================================================
+
+void CActorState::Quantize(void) {
+    m_position = QuantizeVector(m_position, POSITION_SCALE);
+    m_orientation = QuantizeVector(m_orientation, ANGLE_SCALE);
+    m_scale = float(QuantizeScale(m_scale)) / 255.0f;
+}
+
+
+int CActorState::Compare(CActorState& other) {
+    int fieldMask = 0;
+    if (VectorsDiffer(m_position, other.m_position))
+        fieldMask |= fmPosition;
+    if (VectorsDiffer(m_orientation, other.m_orientation))
+        fieldMask |= fmOrientation;
+    if (m_hitPoints != other.m_hitPoints)
+        fieldMask |= fmHitPoints;
+    if (m_score != other.m_score)
+        fieldMask |= fmScore;
+    if (m_lifeState != other.m_lifeState)
+        fieldMask |= fmLifeState;
+    if (m_scale != other.m_scale)
+        fieldMask |= fmScale;
+    if (m_port != other.m_port)
+        fieldMask |= fmPort;
+    if (m_sequence != other.m_sequence)
+        fieldMask |= fmSequence;
+    return fieldMask & (FieldMask() | fmSequence);
+}
+
+
+// format: [<position>][<orientation>][<hitpoints (byte)>][<score (varint)>][<life state + 1 (byte)>][<scale (byte)>][<port (uint16)>][<sequence (uint16)>]
+void CActorState::Write(CPacketWriter& packet, int fieldMask) {
+    if (fieldMask & fmPosition)
+        packet.WritePosition(m_position);
+    if (fieldMask & fmOrientation)
+        packet.WriteAngles(m_orientation);
+    if (fieldMask & fmHitPoints)
+        packet.WriteByte(uint8_t(m_hitPoints));
+    if (fieldMask & fmScore)
+        packet.WriteInt(m_score);
+    if (fieldMask & fmLifeState)
+        packet.WriteByte(uint8_t(m_lifeState + 1));
+    if (fieldMask & fmScale)
+        packet.WriteScale(m_scale);
+    if (fieldMask & fmPort)
+        packet.WriteUInt16(m_port);
+    if (fieldMask & fmSequence)
+        packet.WriteUInt16(m_sequence);
+}
+
+
+void CActorState::Read(CPacketReader& packet, int fieldMask) {
+    if (fieldMask & fmPosition)
+        m_position = packet.ReadPosition();
+    if (fieldMask & fmOrientation)
+        m_orientation = packet.ReadAngles();
+    if (fieldMask & fmHitPoints)
+        m_hitPoints = packet.ReadByte();
+    if (fieldMask & fmScore)
+        m_score = packet.ReadInt();
+    if (fieldMask & fmLifeState)
+        m_lifeState = int(packet.ReadByte()) - 1;
+    if (fieldMask & fmScale)
+        m_scale = packet.ReadScale();
+    if (fieldMask & fmPort)
+        m_port = packet.ReadUInt16();
+    if (fieldMask & fmSequence)
+        m_sequence = packet.ReadUInt16();
+}
+
+// =================================================================================================
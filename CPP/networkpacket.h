@@ -0,0 +1,248 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "vector.h"
+
+// =================================================================================================
+// Binary wire format
+//
+// Compact alternative to the text messages for the high frequency messages (UPDATE, FIRE, HIT, DESTROY).
+// Binary packets also carry the reliable channel (RELIABLE && ACK records, see networkchannel.h).
+// Whether a peer is sent binary or text messages is negotiated per peer (see CNetworkHandler::HandleEnter).
+//
+// packet: <magic><protocol version><sequence number (uint16)><snapshot ack (uint16)><received sequence (uint16)>
+//         <received bits (uint32)><record>[<record>[...]]
+// record: <message id><record data>
+//
+// The magic byte can never be the first character of a text message (which always starts with "SMIBAT").
+// Record message ids are the ids of the corresponding text messages.
+// Packets sent to a peer are numbered consecutively (skipping zero). The snapshot ack is the sequence number of
+// the most recent packet received from the peer whose actor snapshot (UPDATE record) has been applied (zero: none).
+// The received sequence is the most recent packet received from the peer, the received bits tell which of the 32 packets
+// preceding it have arrived, too (see CCongestionControl).
+// Positions are transmitted as 16 bit fixed point values (1/128 unit, i.e. +/- 256 units), angles as 16 bit
+// fractions of 180 degrees, directions (unit vectors) && scales as 16 and 8 bit fractions of 1, integers as (zigzag encoded) varints.
+
+#define PACKET_MAGIC        0xB5
+#define PACKET_VERSION      12
+#define PACKET_HEADER_SIZE  12
+#define MAX_PACKET_SIZE     1200        // stay well below the ethernet MTU to avoid ip fragmentation
+
+// compare sequence numbers, taking wrap around into account
+static inline bool SequenceIsNewer(uint16_t s1, uint16_t s2) {
+    return int16_t(s1 - s2) > 0;
+}
+
+// =================================================================================================
+// Assemble a binary packet in a fixed size buffer
+
+class CPacketWriter {
+    public:
+        uint8_t     m_data[MAX_PACKET_SIZE];
+        size_t      m_length;
+        bool        m_overflow;
+
+        CPacketWriter() {
+            Reset();
+        }
+
+        // start a new packet (reserves space for the packet header)
+        void Reset(void);
+
+        // fill in sequence number, ack and receive report of the packet header
+        inline void SetHeader(uint16_t sequence, uint16_t ack, uint16_t receivedSequence, uint32_t receivedBits) {
+            WriteUInt16At(2, sequence);
+            WriteUInt16At(4, ack);
+            WriteUInt16At(6, receivedSequence);
+            WriteUInt16At(8, uint16_t(receivedBits));
+            WriteUInt16At(10, uint16_t(receivedBits >> 16));
+        }
+
+        inline uint8_t* Buffer(void) {
+            return m_data;
+        }
+
+        inline size_t Length(void) {
+            return m_length;
+        }
+
+        inline size_t Space(void) {
+            return MAX_PACKET_SIZE - m_length;
+        }
+
+        // true if the packet doesn't contain any records
+        inline bool Empty(void) {
+            return m_length <= PACKET_HEADER_SIZE;
+        }
+
+        // check whether the records of another packet fit into the space left in this packet
+        inline bool Fits(CPacketWriter& other) {
+            return other.m_length - PACKET_HEADER_SIZE <= Space();
+        }
+
+        // append the records of another packet
+        void Append(CPacketWriter& other);
+
+        inline void WriteByte(uint8_t value) {
+            if (m_length < MAX_PACKET_SIZE)
+                m_data[m_length++] = value;
+            else
+                m_overflow = true;
+        }
+
+        void WriteUInt16(uint16_t value);
+
+        void WriteUInt32(uint32_t value);
+
+        void WriteBytes(const uint8_t* data, size_t length);
+
+        // overwrite a value written before (e.g. a record length)
+        inline void WriteUInt16At(size_t offset, uint16_t value) {
+            if (offset + 2 <= m_length) {
+                m_data[offset] = uint8_t(value);
+                m_data[offset + 1] = uint8_t(value >> 8);
+            }
+        }
+
+        void WriteVarInt(uint32_t value);
+
+        // zigzag encoding keeps small negative values small
+        inline void WriteInt(int32_t value) {
+            WriteVarInt((uint32_t(value) << 1) ^ uint32_t(value >> 31));
+        }
+
+        void WritePosition(CVector& position);
+
+        void WriteAngles(CVector& angles);
+
+        void WriteDirection(CVector& direction);
+
+        void WriteScale(float scale);
+};
+
+// =================================================================================================
+// Read the values of a binary packet. Reading past the end of the packet sets the error flag and
+// returns zero values.
+
+class CPacketReader {
+    public:
+        const uint8_t*  m_data;
+        size_t          m_length;
+        size_t          m_offset;
+        bool            m_error;
+        uint16_t        m_sequence;
+        uint16_t        m_ack;
+        uint16_t        m_receivedSequence;
+        uint32_t        m_receivedBits;
+
+        CPacketReader(const uint8_t* data = nullptr, size_t length = 0)
+            : m_data(data), m_length(length), m_offset(0), m_error(false), m_sequence(0), m_ack(0), m_receivedSequence(0), m_receivedBits(0) {}
+
+        // check packet magic and version, read sequence number, ack and receive report
+        bool ReadHeader(void);
+
+        inline bool AtEnd(void) {
+            return m_error || (m_offset >= m_length);
+        }
+
+        inline uint8_t ReadByte(void) {
+            if (m_offset < m_length)
+                return m_data[m_offset++];
+            m_error = true;
+            return 0;
+        }
+
+        // continue reading at offset (e.g. the end of a record that couldn't be processed)
+        inline void SkipTo(size_t offset) {
+            if (offset > m_length)
+                m_error = true;
+            else
+                m_offset = offset;
+        }
+
+        uint16_t ReadUInt16(void);
+
+        uint32_t ReadUInt32(void);
+
+        // return a pointer to the next length bytes of the packet (nullptr if there aren't enough left)
+        const uint8_t* ReadBytes(size_t length);
+
+        uint32_t ReadVarInt(void);
+
+        inline int32_t ReadInt(void) {
+            uint32_t value = ReadVarInt();
+            return int32_t(value >> 1) ^ -int32_t(value & 1);
+        }
+
+        CVector ReadPosition(void);
+
+        CVector ReadAngles(void);
+
+        CVector ReadDirection(void);
+
+        float ReadScale(void);
+
+        // check whether data starts with a binary packet header
+        static inline bool IsPacket(const uint8_t* data, size_t length) {
+            return (length >= PACKET_HEADER_SIZE) && (data[0] == PACKET_MAGIC);
+        }
+};
+
+// =================================================================================================
+// Actor state as carried by an UPDATE message or record
+
+class CActorState {
+    public:
+        typedef enum {
+            fmPosition = 1,
+            fmOrientation = 2,
+            fmHitPoints = 4,
+            fmScore = 8,
+            fmLifeState = 16,
+            fmScale = 32,
+            fmPort = 64,
+            fmSequence = 128,   // only relayed actors (see CNetworkHandler::HandleUpdateRecord)
+            fmProjectile = fmPosition | fmOrientation,  // projectiles only have position and orientation
+            fmPlayer = 127
+        } eFieldMasks;
+
+        int         m_id;
+        int         m_colorIndex;
+        CVector     m_position;
+        CVector     m_orientation;
+        int         m_hitPoints;
+        int         m_score;
+        int         m_lifeState;
+        float       m_scale;
+        uint16_t    m_port;
+        uint16_t    m_sequence;     // update sequence number the actor's owner has sent the state with (0: the sender is the owner)
+
+        CActorState() : m_id(0), m_colorIndex(-1), m_hitPoints(0), m_score(0), m_lifeState(-1), m_scale(1.0f), m_port(0), m_sequence(0) {}
+
+        inline bool IsPlayer(void) {
+            return m_id == 0;
+        }
+
+        inline bool IsActor(int id, int colorIndex) {
+            return (m_id == id) && (m_colorIndex == colorIndex);
+        }
+
+        inline int FieldMask(void) {
+            return (IsPlayer() ? fmPlayer : fmProjectile) | (m_sequence ? fmSequence : 0);
+        }
+
+        // reduce all values to the precision of the binary format, so that states can be compared to states
+        // received from or sent to other players
+        void Quantize(void);
+
+        // return the mask of all fields differing between this and another state
+        int Compare(CActorState& other);
+
+        void Write(CPacketWriter& packet, int fieldMask);
+
+        void Read(CPacketReader& packet, int fieldMask);
+};
+
+// =================================================================================================
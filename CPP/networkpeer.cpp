@@ -0,0 +1,121 @@
+#include "networkpeer.h"
+
+// =================================================================================================
+
+// the room is doubled, so that a snapshot's actors are only moved a few times
+bool CSnapshot::Reserve(int count) {
+    if (count > MAX_SNAPSHOT_ACTORS)
+        return false;
+    int length = int(m_actors.Length());
+    if (length < count) {
+        length = (length < 8) ? 8 : 2 * length;
+        if (length < count)
+            length = count;
+        if (length > MAX_SNAPSHOT_ACTORS)
+            length = MAX_SNAPSHOT_ACTORS;
+        m_actors.Resize(size_t(length));
+    }
+    return true;
+}
+
+
+CActorState* CSnapshot::Find(int id, int colorIndex) {
+    for (int i = 0; i < m_actorCount; i++)
+        if (m_actors[i].IsActor(id, colorIndex))
+            return m_actors.Buffer(i);
+    return nullptr;
+}
+
+
+bool CSnapshot::Add(CActorState& state) {
+    if (!Reserve(m_actorCount + 1))
+        return false;
+    m_actors[m_actorCount++] = state;
+    return true;
+}
+
+
+// only copy the actors actually used
+void CSnapshot::Copy(CSnapshot& other) {
+    m_sequence = other.m_sequence;
+    Reserve(other.m_actorCount);
+    m_actorCount = other.m_actorCount;
+    for (int i = 0; i < m_actorCount; i++)
+        m_actors[i] = other.m_actors[i];
+}
+
+// =================================================================================================
+
+void CNetworkPeer::Reset(void) {
+    m_binaryFormat = false;
+    m_packet.Reset();
+    m_sequence = 0;
+    m_snapshotAck = 0;
+    m_lastSnapshot = 0;
+    m_snapshotTime = 0;
+    m_viewLag = 0;
+    m_clock.Reset();
+    m_fragments.Reset();
+    ForgetPositions();
+    m_congestion.Reset();
+    m_snapshotCount = 0;
+    m_priorityCount = 0;
+    m_traffic.Reset();
+    m_reorderedUpdates = 0;
+    m_duplicateUpdates = 0;
+    for (int i = 0; i < SNAPSHOT_HISTORY; i++)
+        m_sentSnapshots[i].m_sequence = m_receivedSnapshots[i].m_sequence = 0;
+    m_channel.Reset();
+}
+
+
+CSnapshot* CNetworkPeer::FindSnapshot(CSnapshot* history, uint16_t sequence) {
+    if (sequence == 0)
+        return nullptr;
+    CSnapshot* snapshot = history + sequence % SNAPSHOT_HISTORY;
+    return (snapshot->m_sequence == sequence) ? snapshot : nullptr;
+}
+
+
+void CNetworkPeer::StoreSnapshot(CSnapshot* history, CSnapshot& snapshot, uint16_t sequence) {
+    CSnapshot* s = history + sequence % SNAPSHOT_HISTORY;
+    s->Copy(snapshot);
+    s->m_sequence = sequence;
+}
+
+
+void CNetworkPeer::UpdateSnapshotAck(uint16_t ack) {
+    if (ack && ((m_snapshotAck == 0) || SequenceIsNewer(ack, m_snapshotAck) || !SentSnapshot(m_snapshotAck)))
+        m_snapshotAck = ack;
+}
+
+
+// sequence numbers far behind the last snapshot rather indicate that the peer has restarted its session
+bool CNetworkPeer::IsStale(uint16_t sequence) {
+    if (m_lastSnapshot == 0)
+        return false;
+    uint16_t age = m_lastSnapshot - sequence;
+    return age < 1024;
+}
+
+
+void CNetworkPeer::Prioritize(CSnapshot& snapshot) {
+    CActorPriority priorities[MAX_SNAPSHOT_ACTORS];
+    for (int i = 0; i < snapshot.m_actorCount; i++) {
+        CActorState& state = snapshot.m_actors[i];
+        CActorPriority& p = priorities[i];
+        p.m_id = state.m_id;
+        p.m_colorIndex = state.m_colorIndex;
+        p.m_priority = state.IsPlayer() ? 2.0f : 1.0f;
+        for (int j = 0; j < m_priorityCount; j++)
+            if ((m_priorities[j].m_id == p.m_id) && (m_priorities[j].m_colorIndex == p.m_colorIndex)) {
+                p.m_priority += m_priorities[j].m_priority;
+                break;
+            }
+    }
+    m_priorityCount = snapshot.m_actorCount;
+    for (int i = 0; i < m_priorityCount; i++)
+        m_priorities[i] = priorities[i];
+}
+
+// =================================================================================================
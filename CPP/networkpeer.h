@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "carray.h"
+#include "networkpacket.h"
+#include "networkchannel.h"
+#include "congestioncontrol.h"
+#include "networkstats.h"
+#include "clocksync.h"
+#include "networkfragments.h"
+
+#define SNAPSHOT_HISTORY        32      // number of snapshots sent to / received from a peer kept for delta compression
+#define MAX_PLAYERS             64      // most players a game can have room for (see CGameData::SetMaxPlayers)
+#define MAX_PLAYER_PROJECTILES  7       // projectiles in flight per player a snapshot has room for
+// a relay host's snapshots carry every player && all their projectiles (see CNetworkHandler::MergeSnapshot)
+#define MAX_SNAPSHOT_ACTORS     (MAX_PLAYERS * (1 + MAX_PLAYER_PROJECTILES))
+
+// =================================================================================================
+// States of all actors owned by a player at the time the snapshot was taken
+//
+// Every peer keeps 2 * SNAPSHOT_HISTORY snapshots, most of which hold a few actors only, so the actors' room grows
+// with the actors actually added instead of always taking MAX_SNAPSHOT_ACTORS.
+
+class CSnapshot {
+    public:
+        uint16_t    m_sequence;     // sequence number of the packet the snapshot has been sent with (0: unused)
+        int         m_actorCount;
+        CArray<CActorState> m_actors;
+
+        CSnapshot() : m_sequence(0), m_actorCount(0) {}
+
+        // make room for count actors. false if count exceeds MAX_SNAPSHOT_ACTORS
+        bool Reserve(int count);
+
+        CActorState* Find(int id, int colorIndex);
+
+        // false if the snapshot is full
+        bool Add(CActorState& state);
+
+        void Copy(CSnapshot& other);
+};
+
+// =================================================================================================
+// Send priority of an actor: grows with every snapshot the actor could have been sent with but hasn't (see
+// CNetworkHandler::BudgetSnapshot)
+
+class CActorPriority {
+    public:
+        int     m_id;
+        int     m_colorIndex;
+        float   m_priority;
+
+        CActorPriority() : m_id(0), m_colorIndex(-1), m_priority(0.0f) {}
+};
+
+// =================================================================================================
+// Per peer network state of a remote player
+
+class CNetworkPeer {
+    public:
+        bool            m_binaryFormat;     // peer understands the binary wire format
+        CPacketWriter   m_packet;           // binary records waiting to be sent to the peer with the next network frame
+        uint16_t        m_sequence;         // sequence number of the last packet sent to the peer
+        uint16_t        m_snapshotAck;      // most recent snapshot of ours the peer has applied
+        uint16_t        m_lastSnapshot;     // most recent snapshot of the peer's we have applied
+        uint32_t        m_snapshotTime;     // match time the peer has sent that snapshot at (0: unknown)
+        int             m_viewLag;          // [ms] how far in the past the peer sees the local player (see CCollisionHandler)
+        CSnapshot       m_sentSnapshots[SNAPSHOT_HISTORY];
+        CSnapshot       m_receivedSnapshots[SNAPSHOT_HISTORY];
+        CReliableChannel    m_channel;      // FIRE, HIT, DESTROY, LEAVE && the join handshake
+        CFragmentAssembler  m_fragments;    // fragmented message being received through the channel
+        CClockSync      m_clock;            // offset of the peer's clock to ours
+        CVector         m_sentPositions[MAX_PLAYERS];  // player positions last sent to the peer (invalid: none yet)
+        CCongestionControl  m_congestion;   // send rate && bandwidth granted to the peer
+        uint32_t        m_snapshotCount;    // snapshots sent to the peer
+        CActorPriority  m_priorities[MAX_SNAPSHOT_ACTORS];  // of the actors of the last snapshot prioritized, in snapshot order
+        int             m_priorityCount;
+        CTrafficStats   m_traffic;          // datagrams exchanged with the peer
+        uint32_t        m_reorderedUpdates; // updates of the peer's actors dropped (see CNetworkStats)
+        uint32_t        m_duplicateUpdates;
+
+        CNetworkPeer() : m_binaryFormat(false), m_sequence(0), m_snapshotAck(0), m_lastSnapshot(0), m_snapshotTime(0), m_viewLag(0), 
+                         m_snapshotCount(0), m_priorityCount(0), m_reorderedUpdates(0), m_duplicateUpdates(0) {
+            ForgetPositions();
+        }
+
+        inline void ForgetPositions(void) {
+            for (int i = 0; i < MAX_PLAYERS; i++)
+                m_sentPositions[i] = CVector(NAN, NAN, NAN);
+        }
+
+        // forget everything about the peer (e.g. when a different client starts joining)
+        void Reset(void);
+
+        // sequence number the packet currently being assembled will be sent with
+        inline uint16_t PendingSequence(void) {
+            return (m_sequence == 0xFFFF) ? 1 : m_sequence + 1;
+        }
+
+        inline uint16_t NextSequence(void) {
+            return m_sequence = PendingSequence();
+        }
+
+        inline CSnapshot* SentSnapshot(uint16_t sequence) {
+            return FindSnapshot(m_sentSnapshots, sequence);
+        }
+
+        inline CSnapshot* ReceivedSnapshot(uint16_t sequence) {
+            return FindSnapshot(m_receivedSnapshots, sequence);
+        }
+
+        void StoreSnapshot(CSnapshot* history, CSnapshot& snapshot, uint16_t sequence);
+
+        void UpdateSnapshotAck(uint16_t ack);
+
+        // check whether a snapshot received with packet sequence is older than the last one applied
+        bool IsStale(uint16_t sequence);
+
+        // raise the priorities of all actors of snapshot (players count double) && forget those of actors not in it.
+        // Afterwards, m_priorities [i] belongs to snapshot.m_actors [i]
+        void Prioritize(CSnapshot& snapshot);
+
+    private:
+        CSnapshot* FindSnapshot(CSnapshot* history, uint16_t sequence);
+};
+
+// =================================================================================================
@@ -0,0 +1,90 @@
+#include "SDL.h"
+#include "networkstats.h"
+
+// =================================================================================================
+
+void CMessageStats::Reset(void) {
+    m_countIn = m_countOut = 0;
+    m_bytesIn = m_bytesOut = 0;
+    m_rejects = 0;
+    m_failures = 0;
+    m_handlerTime = 0;
+    m_maxHandlerTime = 0;
+}
+
+// =================================================================================================
+
+void CNetworkStats::Reset(void) {
+    m_traffic.Reset();
+    for (int i = 0; i < MAX_MESSAGE_IDS; i++)
+        m_messages[i].Reset();
+    m_parseFailures = 0;
+    m_queueDepth = 0;
+    m_fragmentedMessages = 0;
+    m_fragmentedBytes = 0;
+    m_compressedBytes = 0;
+    m_reorderedUpdates = 0;
+    m_duplicateUpdates = 0;
+    m_droppedActors = 0;
+    m_startTime = SDL_GetTicks();
+    m_tickFrequency = SDL_GetPerformanceFrequency();
+    if (m_tickFrequency == 0)
+        m_tickFrequency = 1;
+}
+
+
+void CNetworkStats::Received(int id, size_t bytes) {
+    CMessageStats* stats = Message(id);
+    if (stats) {
+        stats->m_countIn++;
+        stats->m_bytesIn += bytes;
+    }
+}
+
+
+void CNetworkStats::Sent(int id, size_t bytes) {
+    CMessageStats* stats = Message(id);
+    if (stats) {
+        stats->m_countOut++;
+        stats->m_bytesOut += bytes;
+    }
+}
+
+
+void CNetworkStats::Handled(int id, int result, bool rejected, uint64_t ticks) {
+    CMessageStats* stats = Message(id);
+    if (!stats)
+        return;
+    if (result < 0) {
+        if (rejected)
+            stats->m_rejects++;
+        else
+            stats->m_failures++;
+    }
+    uint32_t time = uint32_t(ticks * 1000000 / m_tickFrequency);
+    stats->m_handlerTime += time;
+    if (stats->m_maxHandlerTime < time)
+        stats->m_maxHandlerTime = time;
+}
+
+
+void CNetworkStats::Write(FILE* file, const char* const* names, int nameCount) {
+    uint32_t seconds = (SDL_GetTicks() - m_startTime) / 1000;
+    fprintf(file, "uptime %u s\n", seconds);
+    fprintf(file, "datagrams in %u (%llu bytes) out %u (%llu bytes)\n",
+            m_traffic.m_packetsIn, (unsigned long long) m_traffic.m_bytesIn, m_traffic.m_packetsOut, (unsigned long long) m_traffic.m_bytesOut);
+    fprintf(file, "parse failures %u\n", m_parseFailures);
+    fprintf(file, "\n%-16s %10s %12s %10s %12s %8s %8s %10s %10s\n", "message", "in", "bytes in", "out", "bytes out", "rejects", "failures", "avg [us]", "max [us]");
+    for (int id = 0; id < MAX_MESSAGE_IDS; id++) {
+        CMessageStats& stats = m_messages[id];
+        if (stats.Empty())
+            continue;
+        fprintf(file, "%-16s %10u %12llu %10u %12llu %8u %8u %10u %10u\n",
+                (id < nameCount) ? names[id] : "?",
+                stats.m_countIn, (unsigned long long) stats.m_bytesIn, stats.m_countOut, (unsigned long long) stats.m_bytesOut,
+                stats.m_rejects, stats.m_failures,
+                stats.m_countIn ? uint32_t(stats.m_handlerTime / stats.m_countIn) : 0, stats.m_maxHandlerTime);
+    }
+}
+
+// =================================================================================================
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define MAX_MESSAGE_IDS     32      // must be at least CNetworkHandler::miCount
+
+// =================================================================================================
+// Network statistics
+//
+// Counters that are always on: They only cost a few additions per datagram && message. Message counters count text
+// messages && binary records alike, by message id. Messages delivered through the reliable channel are counted both as
+// part of their RELIABLE record && as messages of their own type when received; on the sending side, they only show
+// up as RELIABLE records. Handler times include the time spent on messages a handler has delivered (RELIABLE).
+// CNetworkHandler keeps the global counters, every peer those of the datagrams exchanged with it (see CNetworkPeer),
+// and periodically writes all of them to a text file if asked to (see CNetworkHandler::WriteStats).
+
+class CTrafficStats {
+    public:
+        uint32_t    m_packetsIn;        // datagrams
+        uint32_t    m_packetsOut;
+        uint64_t    m_bytesIn;
+        uint64_t    m_bytesOut;
+
+        CTrafficStats() {
+            Reset();
+        }
+
+        inline void Reset(void) {
+            m_packetsIn = m_packetsOut = 0;
+            m_bytesIn = m_bytesOut = 0;
+        }
+
+        inline void Received(size_t bytes) {
+            m_packetsIn++;
+            m_bytesIn += bytes;
+        }
+
+        inline void Sent(size_t bytes) {
+            m_packetsOut++;
+            m_bytesOut += bytes;
+        }
+};
+
+// =================================================================================================
+
+class CMessageStats {
+    public:
+        uint32_t    m_countIn;
+        uint32_t    m_countOut;
+        uint64_t    m_bytesIn;
+        uint64_t    m_bytesOut;
+        uint32_t    m_rejects;          // malformed (wrong number of values, truncated record)
+        uint32_t    m_failures;         // refused by the handler for other reasons
+        uint64_t    m_handlerTime;      // [us]
+        uint32_t    m_maxHandlerTime;
+
+        CMessageStats() {
+            Reset();
+        }
+
+        void Reset(void);
+
+        inline bool Empty(void) {
+            return (m_countIn == 0) && (m_countOut == 0);
+        }
+};
+
+// =================================================================================================
+
+class CNetworkStats {
+    public:
+        CTrafficStats   m_traffic;          // all datagrams
+        CMessageStats   m_messages[MAX_MESSAGE_IDS];
+        uint32_t        m_parseFailures;    // datagrams && records that couldn't be parsed at all
+        size_t          m_queueDepth;       // received messages waiting to be processed when last looked at
+        uint32_t        m_fragmentedMessages;   // messages sent in fragments (see networkfragments.h)
+        uint64_t        m_fragmentedBytes;  // their length
+        uint64_t        m_compressedBytes;  // their length as sent
+        uint32_t        m_reorderedUpdates; // actor updates dropped for having been overtaken by newer ones
+        uint32_t        m_duplicateUpdates; // actor updates dropped for having been received before
+        uint32_t        m_droppedActors;    // actors left out of snapshots for lack of room (see MAX_SNAPSHOT_ACTORS)
+        uint32_t        m_startTime;
+        uint64_t        m_tickFrequency;    // performance counter ticks per second
+
+        CNetworkStats() {
+            Reset();
+        }
+
+        void Reset(void);
+
+        inline CMessageStats* Message(int id) {
+            return ((id >= 0) && (id < MAX_MESSAGE_IDS)) ? m_messages + id : nullptr;
+        }
+
+        void Received(int id, size_t bytes);
+
+        void Sent(int id, size_t bytes);
+
+        // account for the handler of a message having returned result after ticks performance counter ticks
+        void Handled(int id, int result, bool rejected, uint64_t ticks);
+
+        // write the counters of all message types seen (names: message names by id)
+        void Write(FILE* file, const char* const* names, int nameCount);
+};
+
+// =================================================================================================
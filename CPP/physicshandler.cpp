@@ -1,22 +1,30 @@
 #include "physicshandler.h"
-#include "gameData.h"
-#include "gameItems.h"
-#include "soundHandler.h"
-#include "actorHandler.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#ifndef HEADLESS
+#   include "soundhandler.h"
+#endif
+#include "actorhandler.h"
 #include "collisionhandler.h"
-#include "controlsHandler.h"
+#ifndef HEADLESS
+#   include "controlshandler.h"
+#endif
+#include "networkhandler.h"
 
 // =================================================================================================
 // physics handling (collisions, movement, animation) for Smiley Battle
 
     void CPhysicsHandler::Update (void) {
-        UpdateMovement ();
+        bool moved = UpdateMovement ();
         HandleCollisions ();
+        if (moved)
+            RecordPositions ();
         AnimateActors ();
     }
 
 
     void CPhysicsHandler::AnimateActors (void) {
+#ifndef HEADLESS
         if (controlsHandler->m_animate) {
             if (!m_animationTimer.HasPassed (m_frameTime, true))
                 return;
@@ -24,6 +32,7 @@
                 if (a->GetName () == "dummy")  // make smileys rotate slowly for test purposes
                     a->m_camera.UpdateAngles (CVector (0, 1 * controlsHandler->m_turnSpeed.m_max * controlsHandler->m_speedScale, 0));
         }
+#endif
     }
 
 
@@ -35,14 +44,21 @@
 
 
     // handle all collisions of actors with other actors
+    // CList::operator[] walks the list, so the actors are looked up once instead of for every pair
     int CPhysicsHandler::HandleActorCollisions (void) {
         int collisions = 0;
         int l = int (actorHandler->m_actors.Length ());
+        if (l < 2)
+            return 0;
+        CArray<CActor*> actors;
+        actors.Create (size_t (l));
+        for (auto [i, a] : actorHandler->m_actors)
+            actors [i] = a;
         for (int i = 0; i < l - 1; i++) {
-            CActor * thisActor = actorHandler->m_actors [i];
+            CActor * thisActor = actors [i];
             // print ("   " + this.camera->name)
             for (int j = i + 1; j < l; j++) {
-                CActor * otherActor = actorHandler->m_actors [j];
+                CActor * otherActor = actors [j];
                 CVector vHit;
                 int collision;
                 if (otherActor->IsProjectile ())
@@ -51,10 +67,12 @@
                     collision = HandleActorActorCollision (thisActor, otherActor, vHit);
                 if (vHit.IsValid ()) {
                     collisions += collision; // projectile collision will return zero here because it doesn't require another collision resolution loop
+#ifndef HEADLESS
                     if (thisActor->IsProjectile () || otherActor->IsProjectile ())
                         soundHandler->Play ("hit", vHit, 0.25f, 0, nullptr, 2);
                     else if (thisActor->MayPlayActorHitSound ())
                         soundHandler->Play ("collide", vHit, 0.25f, 0, nullptr, 2);
+#endif
                 }
             }
         }
@@ -75,10 +93,12 @@
                 collision = HandleActorMapCollision (actor, vHit);
             if (vHit.IsValid ()) {
                 collisions += collision;
+#ifndef HEADLESS
                 if (actor->IsProjectile ())
                     soundHandler->Play ("wallhit", vHit, 0.25f, 0, nullptr, 2);
                 else if (actor->MayPlayWallHitSound ())
                     soundHandler->Play ("collide", vHit, 0.25f, 0, nullptr, 2);
+#endif
             }
         }
         return collisions;
@@ -109,7 +129,9 @@
 
 
     // Update viewer position and orientation
+    // The dedicated server has no controls && its player never spawns
     void CPhysicsHandler::UpdateViewer (void) {
+#ifndef HEADLESS
         float dt = float (m_updateTimer.m_lapTime) / float (m_frameTime);
         controlsHandler->ComputeSpeedScale (float (m_fps));
         gameItems->m_viewer->Update (dt, controlsHandler->m_angles, controlsHandler->m_offset);
@@ -122,15 +144,20 @@
                 soundHandler->Play ("laser", gameItems->m_viewer->GetPosition (), 0.25f, 0, nullptr, 1);
             }
         }
+#endif
     }
 
 
     // update actor states and effects (disappearance, reappearance, respawning)
     void CPhysicsHandler::UpdateActors (void) {
         float dt = float (m_updateTimer.m_lapTime) / float (m_frameTime);
+        uint32_t displayTime = networkHandler->DisplayTime ();
         for (auto [i, a] : actorHandler->m_actors) {
-            if (!a->IsViewer())
+            if (!a->IsViewer()) {
+                a->Interpolate (displayTime);
                 a->Update (dt);
+            }
+#ifndef HEADLESS
             if (a->HavePosition ()) {  // will happen during multiplayer games, when a new player has joined but hasn't got a position yet
                 a->UpdateSound ();
                 if (a->m_animation == 1) {
@@ -142,15 +169,25 @@
                     soundHandler->Play ("reappear", a->GetPosition (), 0.25f, 0, a, 3);
                 }
             }
+#endif
         }
     }
 
 
-    void CPhysicsHandler::UpdateMovement (void) {
-        if (m_updateTimer.HasPassed (m_frameTime, true)) {
-            UpdateViewer ();
-            UpdateActors ();
-        }
+    bool CPhysicsHandler::UpdateMovement (void) {
+        if (!m_updateTimer.HasPassed (m_frameTime, true))
+            return false;
+        UpdateViewer ();
+        UpdateActors ();
+        return true;
+    }
+
+
+    // the positions are taken after collision handling, as that's where the players are sent to be
+    void CPhysicsHandler::RecordPositions (void) {
+        for (auto [i, a] : actorHandler->m_actors)
+            if (a->IsPlayer () && a->IsLocalActor () && a->HavePosition ())
+                ((CPlayer*) a)->m_history.Add (uint32_t (gameData->m_gameTime), a->GetPosition ());
     }
 
 CPhysicsHandler* physicsHandler = nullptr;
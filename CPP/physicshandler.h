@@ -3,12 +3,16 @@
 #include "actor.h"
 #include "map.h"
 #include "timer.h"
-#include "gameData.h"
-#include "gameItems.h"
-#include "soundHandler.h"
-#include "actorHandler.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#ifndef HEADLESS
+#   include "soundhandler.h"
+#endif
+#include "actorhandler.h"
 #include "collisionhandler.h"
-#include "controlsHandler.h"
+#ifndef HEADLESS
+#   include "controlshandler.h"
+#endif
 
 // =================================================================================================
 // physics handling (collisions, movement, animation) for Smiley Battle
@@ -56,7 +60,11 @@ public:
     // update actor states and effects (disappearance, reappearance, respawning)
     void UpdateActors (void);
 
-    void UpdateMovement (void);
+    // returns true if a physics frame has passed
+    bool UpdateMovement (void);
+
+    // remember the local players' positions for lag compensation (see CPositionHistory)
+    void RecordPositions (void);
 
 };
 
@@ -1,12 +1,16 @@
 
 #include "player.h"
 #include "projectile.h"
-#include "gameData.h"
-#include "gameItems.h"
-#include "actorHandler.h"
-#include "networkHandler.h"
-#include "textureHandler.h"
-#include "argHandler.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#include "actorhandler.h"
+#include "networkhandler.h"
+#ifndef HEADLESS
+#   include "texturehandler.h"
+#endif
+#include "arghandler.h"
+
+#ifndef HEADLESS    // the dedicated server has neither shadows, halos nor outlines (see CActorHandler)
 
 // =================================================================================================
 // Shadow for players (smileys). Just a 2D texture rendered near the ground
@@ -93,6 +97,8 @@ void CPlayerOutline::Render(float size, int colorIndex) {
     glPopMatrix();
 }
 
+#endif
+
 // =================================================================================================
 // Player actor. Standard actor with a few extra properties: Shadow, outline, firing shots, changing
 // color when hit, dieing animation
@@ -135,11 +141,13 @@ void CPlayer::Create(CString name, CMesh * mesh, int quality, CAvlTree<CString,
 
 
 void CPlayer::SetupTextures(CAvlTree<CString, CTexture*>& textures, CList<CString> textureNames) {
+#ifndef HEADLESS
     CString color = gameData->GetColor(m_colorIndex);
     if (color != "black")
         color = "white";
     for (auto [i, mood] : m_moods)
         m_textures.Append(textures[color + *mood]);
+#endif
 }
 
 
@@ -171,6 +179,7 @@ int CPlayer::Mood(int mood) {
 
 
 void CPlayer::Render (bool autoCamera) {
+#ifndef HEADLESS
     if (IsHidden())
         return;
     CActor::EnableCamera();
@@ -190,6 +199,7 @@ void CPlayer::Render (bool autoCamera) {
     if (m_outline)
         m_outline->Render(m_camera.GetSize(), int(m_whiteForBlack));
     CActor::DisableCamera();
+#endif
 }
 
 
@@ -202,7 +212,9 @@ void CPlayer::Wiggle(void) {
         m_wiggleAngle += 5;
         m_wiggleAngle %= 360;
     }
+#ifndef HEADLESS
     glTranslatef(0, sin(m_camera.Rad(float (m_wiggleAngle))) / 20, 0);
+#endif
 }
 
 
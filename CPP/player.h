@@ -6,12 +6,18 @@
 #include "clist.h"
 #include "cavltree.h"
 
-#include "cubemap.h"
-#include "quad.h"
-#include "torus.h"
+#ifndef HEADLESS
+#   include "cubemap.h"
+#   include "quad.h"
+#   include "torus.h"
+#endif
 #include "camera.h"
 #include "actor.h"
 #include "timer.h"
+#include "networkpeer.h"
+#include "positionhistory.h"
+
+#ifndef HEADLESS    // the dedicated server has neither shadows, halos nor outlines (see CActorHandler)
 
 // =================================================================================================
 // Shadow for players (smileys). Just a 2D texture rendered near the ground
@@ -65,6 +71,14 @@ class CPlayerOutline {
         void Render(float size, int colorIndex = 0);
 };
 
+#else
+
+class CPlayerShadow;
+class CPlayerHalo;
+class CPlayerOutline;
+
+#endif
+
 // =================================================================================================
 // Player actor. Standard actor with a few extra properties: Shadow, outline, firing shots, changing
 // color when hit, dieing animation
@@ -85,6 +99,8 @@ class CPlayer : public CActor {
         uint16_t            m_ports[2];
         size_t              m_lastMessageTime;
         bool                m_isConnected;
+        CNetworkPeer        m_peer;
+        CPositionHistory    m_history;      // local players: positions of the last physics frames (lag compensation)
         int                 m_score;
         int                 m_kills;
         int                 m_deaths;
@@ -176,8 +192,10 @@ class CPlayer : public CActor {
 
 
         virtual float BorderScale(void) {
+#ifndef HEADLESS
             if (m_outline)
                 return m_outline->Scale();
+#endif
             return 1.0f;
         }
 
@@ -0,0 +1,45 @@
+#include "positionhistory.h"
+
+// =================================================================================================
+
+// a respawn teleports the player: Its old positions must not be blended with the new ones
+void CPositionHistory::Add(uint32_t time, CVector& position) {
+    if (m_count) {
+        CSample& newest = At(0);
+        if (int(time - newest.m_time) <= 0) {   // several physics updates in one game frame: the last one wins
+            newest.m_position = position;
+            return;
+        }
+        if ((newest.m_position - position).Len() > MAX_INTERPOLATION_DISTANCE)
+            Reset();
+    }
+    m_newest = (m_newest + 1) % POSITION_HISTORY_SIZE;
+    CSample& sample = m_samples[m_newest];
+    sample.m_time = time;
+    sample.m_position = position;
+    if (m_count < POSITION_HISTORY_SIZE)
+        m_count++;
+}
+
+
+bool CPositionHistory::Sample(uint32_t time, CVector& position) {
+    if (!m_count)
+        return false;
+    if (int(time - At(0).m_time) >= 0) {
+        position = At(0).m_position;
+        return true;
+    }
+    for (int i = 1; i < m_count; i++) {
+        CSample& s0 = At(i);
+        if (int(time - s0.m_time) >= 0) {
+            CSample& s1 = At(i - 1);
+            float t = float(time - s0.m_time) / float(s1.m_time - s0.m_time);
+            position = s0.m_position + (s1.m_position - s0.m_position) * t;
+            return true;
+        }
+    }
+    position = At(m_count - 1).m_position;
+    return true;
+}
+
+// =================================================================================================
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "vector.h"
+#include "interpolationbuffer.h"
+
+#define POSITION_HISTORY_SIZE   32      // positions kept per local player (about half a second at 60 physics fps)
+
+// =================================================================================================
+// Positions a local player has had during the last physics frames
+//
+// Remote players see the local player as it was some time ago (transmission delay plus their interpolation delay,
+// see CInterpolationBuffer). To judge a remote player's shot fairly, it is tested against the position the local
+// player had at the time the shooter has seen it (lag compensation, see CCollisionHandler::HandleProjectileActorCollision).
+
+class CPositionHistory {
+    public:
+        class CSample {
+            public:
+                uint32_t    m_time;     // [ms] game time of the physics frame
+                CVector     m_position;
+        };
+
+        CSample     m_samples[POSITION_HISTORY_SIZE];
+        int         m_count;
+        int         m_newest;
+
+        CPositionHistory() : m_count(0), m_newest(-1) {}
+
+        inline void Reset(void) {
+            m_count = 0;
+            m_newest = -1;
+        }
+
+        void Add(uint32_t time, CVector& position);
+
+        // compute the position at the given time. Times before the oldest sample yield the oldest position, times
+        // after the newest one the newest position. Returns false if the history is empty
+        bool Sample(uint32_t time, CVector& position);
+
+    private:
+        // i-th newest sample (0: newest)
+        inline CSample& At(int i) {
+            return m_samples[(m_newest - i + POSITION_HISTORY_SIZE) % POSITION_HISTORY_SIZE];
+        }
+};
+
+// =================================================================================================
@@ -2,9 +2,9 @@
 
 #include <string.h>
 #include "projectile.h"
-#include "gameData.h"
-#include "gameItems.h"
-#include "networkHandler.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#include "networkhandler.h"
 
 // =================================================================================================
 // Handling of shots. Shots have straight movement at a fixed speed.
@@ -18,12 +18,13 @@ CProjectile::CProjectile(int id)
     m_offset = CVector(0, 0, 0);
     m_outline = nullptr;
     m_frozenTime = 0;
+    m_isSimulated = false;
 }
 
 
 void CProjectile::Create(CActor* parent) {
     m_parent = parent;
-    if (!m_parent->GetProjectileMesh ())
+    if (!m_parent->IsPlayer ())
         m_mesh = parent->m_mesh;
     else {
         m_mesh = parent->GetProjectileMesh ();
@@ -42,10 +43,28 @@ void CProjectile::Create(CActor* parent) {
 }
 
 
+void CProjectile::Launch(CVector origin, CVector direction, float frames) {
+    m_offset = direction * -m_speed;
+    m_camera.SetPosition(origin - m_offset * frames);
+    m_camera.BumpPosition();
+    m_isSimulated = true;
+}
+
+
+// The owner's positions lag behind by the transmission delay, so positions differing only along the flight path are
+// expected. Anything else means the simulation has gone astray.
+void CProjectile::Correct(CVector position) {
+    CVector d = Direction();
+    CVector v = position - GetPosition();
+    if ((v - d * v.Dot(d)).Len() > Radius())
+        m_camera.SetPosition(position);
+}
+
+
 void CProjectile::Update(float dt, CVector angles, CVector offset) {
     if (IsDead())
         m_delete = true;
-    else if (IsLocalActor()) {  // in multiplayer games, only move the projectiles fired by the local player
+    else if (m_isSimulated || IsLocalActor()) {  // in multiplayer games, only move the projectiles fired by the local player && those launched with flight data
         m_camera.SetPosition(m_camera.GetPosition() - m_offset * dt);
         m_camera.UpdateAngles(CVector(0, 30, 0));
     }
@@ -69,12 +88,14 @@ void CProjectile::Delete(bool force) {
 
 
 void CProjectile::Render(bool bAutoCamera) {
+#ifndef HEADLESS
     // print ("Projectile @ {:1.4f} {:1.4f}".format (m_GetPosition ().x, m_GetPosition ().z))
     m_mesh->PushColor(m_parent->GetColorValue());
     CActor::Render();
     if (m_outline)
         m_outline->Render(m_camera.GetSize());
     m_mesh->PopColor();
+#endif
 }
 
 
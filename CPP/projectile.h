@@ -16,6 +16,7 @@ class CProjectile : public CActor {
         CActor*         m_parent;
         CPlayerOutline* m_outline;
         size_t          m_frozenTime;
+        bool            m_isSimulated;      // remote projectile moved locally along its flight path (see Launch)
 
         CProjectile(int id = -1);
 
@@ -23,6 +24,22 @@ class CProjectile : public CActor {
         void Create(CActor* parent);
 
 
+        // place a remote projectile on the flight path given by the shooter && simulate it locally from now on.
+        // frames: number of physics frames that have passed since it has been fired
+        void Launch(CVector origin, CVector direction, float frames);
+
+
+        // normalized flight direction
+        inline CVector Direction(void) {
+            CVector d = -m_offset;
+            return d.Normalize();
+        }
+
+
+        // apply a position sent by the owner of a simulated projectile
+        void Correct(CVector position);
+
+
         virtual bool SetupTextures(CTexture* texture, CList<CString> textureNames = CList<CString>()) { // required for CActor not recursively calling its SetupTexture method when the child doesn't have one of its own
             return false;
         }
@@ -45,7 +62,11 @@ class CProjectile : public CActor {
 
 
         virtual float BorderScale(void) {
-            return m_outline ? m_outline->Scale() : 1.0f;
+#ifndef HEADLESS
+            if (m_outline)
+                return m_outline->Scale();
+#endif
+            return 1.0f;
         }
 
 
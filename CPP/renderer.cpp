@@ -2,13 +2,13 @@
 #include <math.h>
 
 #include "glew.h"
-#include "sdl.h"
-#include "sdl_net.h"
-#include "sdl_ttf.h"
+#include "SDL.h"
+#include "SDL_net.h"
+#include "SDL_ttf.h"
 #include "camera.h"
 #include "quad.h"
 #include "player.h"
-#include "argHandler.h"
+#include "arghandler.h"
 #include "renderer.h"
 
 // =================================================================================================
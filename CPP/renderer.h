@@ -6,7 +6,7 @@
 #include "camera.h"
 #include "quad.h"
 #include "player.h"
-#include "sdl_ttf.h"
+#include "SDL_ttf.h"
 
 // =================================================================================================
 // basic renderer class. Initializes display and OpenGL and sets up projections and view matrix
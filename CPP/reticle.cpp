@@ -2,7 +2,7 @@
 
 #include "glew.h"
 #include "reticle.h"
-#include "gameItems.h"
+#include "gameitems.h"
 #include "renderer.h"
 
 // =================================================================================================
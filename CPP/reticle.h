@@ -6,7 +6,7 @@
 #include "texture.h"
 #include "quad.h"
 #include "renderer.h"
-#include "textureHandler.h"
+#include "texturehandler.h"
 
 // =================================================================================================
 // Render a reticle on the scene. Requires an orthogonal (not perspective) projection.
@@ -229,7 +229,10 @@ int CRouter::FindPath(int startSegId, int destSegId, CSegmentMap& segmentMap) {
         CMapSegment& segment = segmentMap[segId];
         for (auto [i, edgeId] : segment.m_pathEdgeIds) {
             CSegmentPathEdge e = segmentMap.m_pathEdgeTable [edgeId];
-            if (Push(e.m_segmentId, segId, edgeId, dist + e.m_distance))   
+            int cost = dist + e.m_distance;
+            if (cost >= 65535)   // path costs are 16 bit: a wrapped around cost would link the route into a cycle
+                continue;
+            if (Push(e.m_segmentId, segId, edgeId, uint16_t (cost)))   
                 expanded++;
         }
     }
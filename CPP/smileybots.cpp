@@ -0,0 +1,142 @@
+#include <signal.h>
+#include <time.h>
+
+#include "SDL.h"
+#include "smileybots.h"
+#include "arghandler.h"
+
+// =================================================================================================
+// Smiley Battle load test bots (see smileybots.h)
+
+static bool runBots = true;
+
+static void StopBots (int signal) {
+    runBots = false;
+}
+
+
+CBotRunner::CBotRunner (int argC, char** argV) {
+    InitRandom ();
+    InitNetworking ();
+
+    argHandler = new CArgHandler (argC, argV);
+    argHandler->LoadArgs ("smileybattle.ini");
+    argHandler->Clear ("statsfile");
+    argHandler->Clear ("capturefile");
+    argHandler->Clear ("replayfile");
+    m_botCount = argHandler->IntVal ("bots", 0, 8);
+    // the host rejects bots it has no room for (see maxPlayers)
+    if (m_botCount > MAX_PLAYERS - 1) {
+        fprintf (stderr, "A game has room for at most %d players: running %d bots\n", MAX_PLAYERS, MAX_PLAYERS - 1);
+        m_botCount = MAX_PLAYERS - 1;
+    }
+    m_joinInterval = argHandler->IntVal ("botjoininterval", 0, 250);
+    m_reportInterval = argHandler->IntVal ("reportinterval", 0, 5000);
+    CBot::eMovementProfiles movement = CBot::MovementProfile (argHandler->StrVal ("botmovement", 0, CString ("patrol")));
+    float fireRate = argHandler->FloatVal ("botfirerate", 0, 1.0f);
+    for (int i = 0; i < m_botCount; i++)
+        m_bots.Append (new CBot (i, movement, fireRate));
+    signal (SIGINT, StopBots);
+    signal (SIGTERM, StopBots);
+}
+
+
+void CBotRunner::InitRandom (void) {
+    time_t t;
+    time (&t);
+    srand (int (t));
+}
+
+
+// only the timer && networking are needed: no video, audio || input subsystems
+void CBotRunner::InitNetworking (void) {
+    if ((SDL_Init (SDL_INIT_TIMER) != 0) || (SDLNet_Init () != 0)) {
+        fprintf (stderr, "Cannot initialize networking\n");
+        exit (1);
+    }
+}
+
+
+// the bots leave the game (see CBot::Destroy)
+void CBotRunner::Destroy (void) {
+    for (auto [i, bot] : m_bots)
+        delete bot;
+    m_bots.Destroy ();
+    delete argHandler;
+    argHandler = nullptr;
+}
+
+
+void CBotRunner::Quit (void) {
+    Destroy ();
+    SDLNet_Quit ();
+    SDL_Quit ();
+    exit (0);
+}
+
+
+// all bots are run at the physics frame rate by this thread. The bots start joining one after the other, && the time
+// it takes to run a frame of all bots is measured: If it exceeds the frame time, the bots can't keep up && the
+// measurements taken at the host are off
+void CBotRunner::Run (void) {
+    int botsCreated = 0;
+    CTimer frameTime (1000 / 60);   // see CPhysicsHandler
+    CTimer joinTimer;
+    CTimer reportTimer;
+    uint64_t busyTime = 0;
+    uint64_t maxBusyTime = 0;
+    int frames = 0;
+
+    reportTimer.Start ();
+    while (runBots) {
+        frameTime.Start ();
+        uint64_t t = SDL_GetPerformanceCounter ();
+        if ((botsCreated < m_botCount) && joinTimer.HasPassed (m_joinInterval, true)) {
+            CBot* bot = m_bots [botsCreated++];
+            bot->Create ();
+            if (networkHandler->IamMaster ()) {
+                fprintf (stderr, "The bots need a game host (set hostaddress to an address other than localaddress)\n");
+                break;
+            }
+        }
+        for (int i = 0; i < botsCreated; i++)
+            m_bots [i]->Update ();
+        t = SDL_GetPerformanceCounter () - t;
+        busyTime += t;
+        if (maxBusyTime < t)
+            maxBusyTime = t;
+        frames++;
+        if (m_reportInterval && reportTimer.HasPassed (m_reportInterval, true)) {
+            Report (busyTime, maxBusyTime, frames);
+            busyTime = maxBusyTime = 0;
+            frames = 0;
+        }
+        frameTime.Delay ();
+    }
+}
+
+
+void CBotRunner::Report (uint64_t busyTime, uint64_t maxBusyTime, int frames) {
+    int joined = 0;
+    int joinTime = 0;
+    for (auto [i, bot] : m_bots)
+        if (bot->Joined ()) {
+            joined++;
+            joinTime += bot->m_joinTime;
+        }
+    double frequency = double (SDL_GetPerformanceFrequency ()) / 1000.0;
+    fprintf (stderr, "%d/%d bots joined (%d ms on average), frame %.2f ms (max %.2f ms)\n",
+             joined, m_botCount, joined ? joinTime / joined : 0,
+             frames ? double (busyTime) / frequency / double (frames) : 0.0, double (maxBusyTime) / frequency);
+}
+
+// =================================================================================================
+
+int main (int argC, char** argV) {
+    CBotRunner bots (argC, argV);
+    bots.Run ();
+    bots.Quit ();
+    return 0;
+}
+
+// =================================================================================================
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "clist.h"
+#include "bot.h"
+
+// =================================================================================================
+// Smiley Battle load test bots
+//
+// Runs any number of synthetic players (see CBot) against a game host, so that the host's CPU load, bandwidth &&
+// frame times can be measured with many players without recruiting humans. Like the dedicated server, it is built
+// with HEADLESS defined (see the "Smiley Battle Bots" project && CMakeLists.txt) && needs neither a GPU, nor an audio device.
+//
+// Set hostaddress && hostport to the host's address && in port, && localaddress to an address of the machine
+// running the bots that the host can reach && that differs from the host's. Settings (see smileybattle.ini):
+//   bots:            number of bots (at most one less than the host's maxPlayers, as the host is a player too)
+//   botPort:         first bot's in port. Every bot uses two consecutive ports
+//   botJoinInterval: [ms] between two bots starting to join, so the host isn't flooded with join requests
+//   botFireRate:     shots per second
+//   botMovement:     static, patrol || hunt
+//   reportInterval:  [ms] between two reports of the bots' join times && frame times on stderr
+//
+// The bots neither record nor replay traffic, && they don't write network statistics; the host does.
+
+// =================================================================================================
+// Main bot runner class
+// Contains all bots, initialization and main loop
+
+class CBotRunner {
+public:
+    CList<CBot*>    m_bots;
+    int             m_botCount;
+    int             m_joinInterval;
+    int             m_reportInterval;
+
+    CBotRunner (int argC = 0, char** argV = nullptr);
+
+    void InitRandom (void);
+
+    void InitNetworking (void);
+
+    void Destroy (void);
+
+    void Quit (void);
+
+    void Run (void);
+
+    void Report (uint64_t busyTime, uint64_t maxBusyTime, int frames);
+
+};
+
+// =================================================================================================
@@ -0,0 +1,163 @@
+#include <signal.h>
+#include <time.h>
+
+#include "SDL.h"
+#include "smileyserver.h"
+#include "gamedata.h"
+#include "gameitems.h"
+#include "actorhandler.h"
+#include "physicshandler.h"
+#include "networkhandler.h"
+#include "arghandler.h"
+
+// =================================================================================================
+// Dedicated Smiley Battle server (see smileyserver.h)
+
+#ifdef _DEBUG
+#   define LOG(msg, ...) fprintf(stderr, msg, ##__VA_ARGS__);
+#else
+#   define LOG(msg, ...)
+#endif
+
+// =================================================================================================
+
+static void StopServer (int signal) {
+    if (gameData)
+        gameData->m_run = false;
+}
+
+
+CServer::CServer (int argC, char** argV) {
+    InitRandom ();
+    LOG ("InitNetworking\n")
+    InitNetworking ();
+
+    LOG ("argHandler\n")
+    argHandler = new CArgHandler (argC, argV);
+    argHandler->LoadArgs ("smileybattle.ini");
+    LOG ("gameData\n")
+    gameData = new CGameData ();
+    LOG ("actorHandler\n")
+    actorHandler = new CActorHandler ();
+    LOG ("gameItems\n")
+    gameItems = new CGameItems ();
+    LOG ("physicsHandler\n")
+    physicsHandler = new CPhysicsHandler ();
+    LOG ("networkHandler\n")
+    networkHandler = new CNetworkHandler ();
+    LOG ("gameItems->Create\n")
+    gameItems->Create ();
+    // the server's player only tells the clients who the game host is. It never spawns (see CActor::Hide), so it stays
+    // invisible && can neither be bumped into nor hit
+    gameItems->m_viewer->SetPosition (CVector (0, 0, 0));
+    gameItems->m_viewer->SetScale (0.0f);
+    LOG ("networkHandler->Create\n")
+    networkHandler->Create ();
+    if (!networkHandler->IamMaster ()) {
+        fprintf (stderr, "The server must be the game host (remove hostaddress from its settings)\n");
+        exit (1);
+    }
+    signal (SIGINT, StopServer);
+    signal (SIGTERM, StopServer);
+}
+
+
+void CServer::InitRandom (void) {
+    time_t t;
+    time (&t);
+    srand (int (t));
+}
+
+
+// only the timer && networking are needed: no video, audio || input subsystems
+void CServer::InitNetworking (void) {
+    if ((SDL_Init (SDL_INIT_TIMER) != 0) || (SDLNet_Init () != 0)) {
+        fprintf (stderr, "Cannot initialize networking\n");
+        exit (1);
+    }
+}
+
+
+void CServer::Destroy (void) {
+    delete networkHandler;
+    networkHandler = nullptr;
+    delete physicsHandler;
+    physicsHandler = nullptr;
+    delete gameItems;
+    gameItems = nullptr;
+    delete actorHandler;
+    actorHandler = nullptr;
+    delete gameData;
+    gameData = nullptr;
+    delete argHandler;
+    argHandler = nullptr;
+}
+
+
+void CServer::Quit (void) {
+    Destroy ();
+    SDLNet_Quit ();
+    SDL_Quit ();
+    exit (0);
+}
+
+
+// the server doesn't render anything, so instead of running as fast as possible, it simulates the game at the
+// physics frame rate && sleeps for the rest of each tick
+void CServer::Run (void) {
+    CTimer tickTime (physicsHandler->m_frameTime);
+    uint32_t startTime = SDL_GetTicks ();
+    int reportInterval = argHandler->IntVal ("reportinterval", 0, 0);
+    CTimer reportTimer;
+    uint64_t busyTime = 0;
+    uint64_t maxBusyTime = 0;
+    int ticks = 0;
+
+    fprintf (stderr, "Smiley Battle server listening on %s:%d\n", networkHandler->m_localAddress.Buffer (), int (networkHandler->InPort ()));
+    reportTimer.Start ();
+    while (gameData->m_run) {
+        tickTime.Start ();
+        uint64_t t = SDL_GetPerformanceCounter ();
+        gameData->m_gameTime = tickTime.m_time;
+        physicsHandler->Update ();
+        networkHandler->Update ();
+        actorHandler->Cleanup ();
+        t = SDL_GetPerformanceCounter () - t;
+        busyTime += t;
+        if (maxBusyTime < t)
+            maxBusyTime = t;
+        ticks++;
+        if (reportInterval && reportTimer.HasPassed (reportInterval, true)) {
+            Report (busyTime, maxBusyTime, ticks);
+            busyTime = maxBusyTime = 0;
+            ticks = 0;
+        }
+        if (networkHandler->ReplayFinished ()) {
+            fprintf (stderr, "Capture replayed in %u ms\n", SDL_GetTicks () - startTime);
+            networkHandler->WriteStats ();
+            break;
+        }
+        tickTime.Delay ();
+    }
+    networkHandler->BroadcastLeave ();
+}
+
+
+// time spent simulating the game && handling the network per tick (the rest of each tick is slept away)
+void CServer::Report (uint64_t busyTime, uint64_t maxBusyTime, int ticks) {
+    double frequency = double (SDL_GetPerformanceFrequency ()) / 1000.0;
+    fprintf (stderr, "%d players, tick %.2f ms (max %.2f ms, budget %d ms)\n",
+             int (actorHandler->PlayerCount ()), ticks ? double (busyTime) / frequency / double (ticks) : 0.0,
+             double (maxBusyTime) / frequency, physicsHandler->m_frameTime);
+}
+
+// =================================================================================================
+
+int main (int argC, char** argV) {
+    CServer server (argC, argV);
+    server.Run ();
+    server.Quit ();
+    return 0;
+}
+
+// =================================================================================================
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+
+
+// =================================================================================================
+// Dedicated Smiley Battle server
+//
+// The server is a game host without a window, sound or controls. It is built from the same sources
+// as the game, but with HEADLESS defined (see the "Smiley Battle Server" project && CMakeLists.txt), which removes all
+// rendering, texturing, sound and input handling. It only links the map, actor, physics and network
+// handling code, so it runs on machines without a GPU or an audio device.
+//
+// The server always is the game host (don't pass it a hostaddress). It runs the simulation at a fixed
+// tick rate, accepts joining players and keeps them in sync. Its own player never spawns, so nobody
+// can see, bump into or hit it. Clients join it like any other game host, using its address as their
+// hostaddress.
+//
+// Set localaddress to an address the clients can reach the server at.
+//
+// With captureFile set, the server records its traffic. Started with replayFile (&& the settings of the recording
+// server), it replays such a capture instead of listening, at replaySpeed (0: as fast as possible), && quits when
+// the capture has been processed, writing the network statistics if a statsFile has been set.
+//
+// With reportInterval set, the server reports the number of players && the time it takes to run a tick [ms] on stderr
+// that often, e.g. to measure the load caused by bots (see smileybots.h).
+
+// =================================================================================================
+// Main server class
+// Contains all server data, initialization and main loop
+
+class CServer {
+public:
+    CServer (int argC = 0, char** argV = nullptr);
+
+    void InitRandom (void);
+
+    void InitNetworking (void);
+
+    void Destroy (void);
+
+    void Quit (void);
+
+    void Run (void);
+
+    void Report (uint64_t busyTime, uint64_t maxBusyTime, int ticks);
+
+};
+
+// =================================================================================================
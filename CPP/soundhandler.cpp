@@ -1,7 +1,7 @@
-#include "soundHandler.h"
-#include "gameItems.h"
-#include "gameData.h"
-#include "argHandler.h"
+#include "soundhandler.h"
+#include "gameitems.h"
+#include "gamedata.h"
+#include "arghandler.h"
 
 // =================================================================================================
 
@@ -1,7 +1,7 @@
 #include "vector.h"
 #include "matrix.h"
 #include "icosphere.h"
-#include "sdl.h"
+#include "SDL.h"
 
 int main(int argc, char* argv[]) {
 	SDL_SetMainReady();
@@ -12,11 +12,14 @@ int CTextFileLoader::ReadLines(const char * fileName, CList<CString>& fileLines,
         return -1;
     std::string line;
     int lineC = 0;
-    while (std::getline(f, line))
+    while (std::getline(f, line)) {
+        if (!line.empty() && (line.back() == '\r'))  // CRLF files read on systems other than Windows
+            line.pop_back();
         if ((*filter) (line)) {
             lineC++;
             fileLines.Append (CString (line.c_str ()));
         }
+    }
     return int (fileLines.Length ());
 }
 
@@ -1,7 +1,7 @@
 #pragma once
 
-#include "gameData.h"
-#include "textureHandler.h"
+#include "gamedata.h"
+#include "texturehandler.h"
 
 // =================================================================================================
 // Very simply class for texture tracking
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <windows.h>
+#ifdef _WIN32
+#   include <windows.h>
+#endif
 #include <stdio.h>
 #include "SDL.h"
 
@@ -43,7 +45,11 @@ public:
     void Delay(void) {
         int t = m_duration - m_slack - Lap();
         if (t > 0)
+#ifdef _WIN32
             Sleep(DWORD (t));
+#else
+            SDL_Delay(Uint32 (t));
+#endif
         m_slack = Lap() - m_duration;
     }
 };
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "cstring.h"
+
+#define MAX_DATAGRAM_SIZE   1500
+
+// =================================================================================================
+// Datagram transport underneath CUDP
+//
+// CUDPSocket talks to the network. CVirtualSocket (see virtualnetwork.h) exchanges datagrams with other virtual sockets
+// of the same process, && CImpairedTransport (see virtualnetwork.h) passes the datagrams another transport receives on
+// with the delays && losses of a simulated link.
+
+class CTransport {
+    public:
+        CString         m_localAddress;
+        uint16_t        m_localPort;
+        bool            m_isValid;
+        bool            m_isBatching;       // collect datagrams to be sent until SendBatch() is called
+
+        CTransport() : m_localAddress(CString("127.0.0.1")), m_localPort(0), m_isValid(false), m_isBatching(false) {}
+
+        virtual ~CTransport() {}
+
+        virtual bool Open(CString localAddress, uint16_t localPort) = 0;
+
+        virtual void Close(void) = 0;
+
+        virtual bool Send(const uint8_t* data, size_t length, CString& address, uint16_t port) = 0;
+
+        inline bool Send(CString message, CString address, uint16_t port) {
+            return Send((uint8_t*) message.Buffer(), message.Length(), address, port);
+        }
+
+        virtual void BeginBatch(void) {
+            m_isBatching = true;
+        }
+
+        // send all datagrams collected since BeginBatch()
+        virtual bool SendBatch(void) {
+            m_isBatching = false;
+            return true;
+        }
+
+        // receive a datagram into data, reusing the buffers of data && address. Returns false if there is none
+        virtual bool Receive(CString& data, CString& address, uint16_t& port) = 0;
+
+        // wait until data can be received, the timeout [ms] has passed (< 0: no timeout) or Wakeup() has been called.
+        // Returns true if data can be received
+        virtual bool Wait(int timeout) = 0;
+
+        // make a thread blocked in Wait() return
+        virtual void Wakeup(void) = 0;
+};
+
+// =================================================================================================
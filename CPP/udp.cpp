@@ -1,8 +1,53 @@
 #include "udp.h"
 
+#if NATIVE_SOCKETS
+#   include <unistd.h>
+#   include <errno.h>
+#   include <poll.h>
+#   include <sys/eventfd.h>
+#   include <arpa/inet.h>
+#endif
+
+// =================================================================================================
+
+IPaddress* CAddressCache::Resolve(CString& address, uint16_t port) {
+    for (int i = 0; i < m_entryCount; i++) {
+        CEntry& entry = m_entries[i];
+        if ((entry.m_port == port) && (entry.m_address == address))
+            return &entry.m_ip;
+    }
+    IPaddress ip;
+    if (0 > SDLNet_ResolveHost(&ip, (char*) address, port)) {
+        fprintf(stderr, "Failed to resolve host '%s:%d'\n", (char*) address, port);
+        return nullptr;
+    }
+    CEntry& entry = m_entries[(m_entryCount < ADDRESS_CACHE_SIZE) ? m_entryCount++ : m_nextEntry];
+    if (m_entryCount == ADDRESS_CACHE_SIZE)
+        m_nextEntry = (m_nextEntry + 1) % ADDRESS_CACHE_SIZE;
+    entry.m_address = address;
+    entry.m_port = port;
+    entry.m_ip = ip;
+    return &entry.m_ip;
+}
+
 // =================================================================================================
 // UDP based networking
 
+#if NATIVE_SOCKETS
+
+CUDPSocket::CDatagrams::CDatagrams() : m_count(0), m_index(0) {
+    memset(m_headers, 0, sizeof(m_headers));
+    for (int i = 0; i < UDP_BATCH_SIZE; i++) {
+        m_buffers[i].iov_base = m_data[i];
+        m_buffers[i].iov_len = MAX_DATAGRAM_SIZE;
+        m_headers[i].msg_hdr.msg_iov = m_buffers + i;
+        m_headers[i].msg_hdr.msg_iovlen = 1;
+        m_headers[i].msg_hdr.msg_name = m_addresses + i;
+        m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+}
+
+
 bool CUDPSocket::Open(CString localAddress, uint16_t localPort) {
     m_localAddress = localAddress;
     m_localPort = localPort;
@@ -10,9 +55,20 @@ bool CUDPSocket::Open(CString localAddress, uint16_t localPort) {
         fprintf(stderr, "UDP OpenSocket: Please specify a valid local network or internet address in the command line or ini file\n");
         return false;
     }
-    if (!(m_socket = SDLNet_UDP_Open(localPort)))
+    if (0 > (m_socket = socket(AF_INET, SOCK_DGRAM, 0)))
         return false;
-    m_packet = SDLNet_AllocPacket(1500);
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(localPort);
+    if (0 > bind(m_socket, (sockaddr*) &address, sizeof(address))) {
+        fprintf(stderr, "Failed to bind UDP socket to port %d\n", localPort);
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+    m_wakeup = eventfd(0, EFD_NONBLOCK);
     return m_isValid = true;
 }
 
@@ -20,60 +76,205 @@ bool CUDPSocket::Open(CString localAddress, uint16_t localPort) {
 void CUDPSocket::Close(void) {
     if (m_isValid) {
         m_isValid = false;
-        // Unbind ();
-        SDLNet_UDP_Close(m_socket);
+        close(m_socket);
+        m_socket = -1;
+        if (m_wakeup >= 0) {
+            close(m_wakeup);
+            m_wakeup = -1;
+        }
+    }
+}
+
+
+bool CUDPSocket::Send(const uint8_t* data, size_t length, CString& address, uint16_t port) {
+    if (!m_isValid || (length > MAX_DATAGRAM_SIZE))
+        return false;
+    IPaddress* ip = m_addresses.Resolve(address, port);
+    if (!ip)
+        return false;
+    if (m_isBatching && (m_sent.m_count == UDP_BATCH_SIZE))
+        SendBatch();
+    // outside of a batch, the datagram is sent right away as a batch of one
+    int i = m_sent.m_count++;
+    sockaddr_in& peer = m_sent.m_addresses[i];
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = ip->host;    // SDL_net keeps host && port in network byte order
+    peer.sin_port = ip->port;
+    memcpy(m_sent.m_data[i], data, length);
+    m_sent.m_buffers[i].iov_len = length;
+    m_sent.m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    if (m_isBatching)
+        return true;
+    return SendBatch();
+}
+
+
+bool CUDPSocket::SendBatch(void) {
+    bool result = true;
+    for (int i = 0; i < m_sent.m_count; ) {
+        int n = sendmmsg(m_socket, m_sent.m_headers + i, m_sent.m_count - i, 0);
+        if (n > 0)
+            i += n;
+        else if (errno != EINTR) { // drop the rest of the batch - it's UDP after all
+            result = false;
+            break;
+        }
+    }
+    m_sent.m_count = 0;
+    m_isBatching = false;
+    return result;
+}
+
+
+bool CUDPSocket::Receive(CString& data, CString& address, uint16_t& port) {
+    if (!m_isValid)
+        return false;
+    if (m_received.m_index == m_received.m_count) {
+        m_received.m_index = m_received.m_count = 0;
+        for (int i = 0; i < UDP_BATCH_SIZE; i++)
+            m_received.m_headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        int n = recvmmsg(m_socket, m_received.m_headers, UDP_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (n <= 0)
+            return false;
+        m_received.m_count = n;
+    }
+    int i = m_received.m_index++;
+    sockaddr_in& peer = m_received.m_addresses[i];
+    char s[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &peer.sin_addr, s, sizeof(s));
+    address.Assign(s, strlen(s));
+    port = uint16_t(peer.sin_port);    // same (network) byte order as SDL_net's
+    data.Assign((char*)m_received.m_data[i], m_received.m_headers[i].msg_len);
+    return true;
+}
+
+
+bool CUDPSocket::Wait(int timeout) {
+    if (!m_isValid) {
+        if (timeout)    // don't let a listener spin on a socket that couldn't be opened
+            SDL_Delay(((timeout < 0) || (timeout > MAX_WAIT_TIME)) ? MAX_WAIT_TIME : timeout);
+        return false;
+    }
+    if (m_received.m_index < m_received.m_count) // datagrams left over from the last batch
+        return true;
+    pollfd fds[2] = { { m_socket, POLLIN, 0 }, { m_wakeup, POLLIN, 0 } };
+    if (0 >= poll(fds, (m_wakeup < 0) ? 1 : 2, timeout))
+        return false;
+    if (fds[1].revents & POLLIN) {
+        uint64_t count;
+        read(m_wakeup, &count, sizeof(count));  // just reset the event
     }
+    return (fds[0].revents & POLLIN) != 0;
 }
 
 
-int CUDPSocket::Bind (CString& address, uint16_t port) {
-    if (0 > (m_channel = SDLNet_ResolveHost (&m_address, (char*) address, port)))
-        fprintf (stderr, "Failed to resolve host '%s:%d'\n", (char*) address, port);
-    else if (0 > (m_channel = SDLNet_UDP_Bind (m_socket, -1, &m_address)))
-        fprintf (stderr, "Failed to bind '%s:%d' to UDP socket\n", (char*) address, port);
-    else 
-        return 0;
-    return m_channel;
+void CUDPSocket::Wakeup(void) {
+    if (m_wakeup >= 0) {
+        uint64_t count = 1;
+        write(m_wakeup, &count, sizeof(count));
+    }
 }
 
+#else
+
+bool CUDPSocket::Open(CString localAddress, uint16_t localPort) {
+    m_localAddress = localAddress;
+    m_localPort = localPort;
+    if (localAddress == "127.0.0.1") {
+        fprintf(stderr, "UDP OpenSocket: Please specify a valid local network or internet address in the command line or ini file\n");
+        return false;
+    }
+    if (!(m_socket = SDLNet_UDP_Open(localPort)))
+        return false;
+    m_packet = SDLNet_AllocPacket(MAX_DATAGRAM_SIZE);
+    if ((m_socketSet = SDLNet_AllocSocketSet(1)))
+        SDLNet_UDP_AddSocket(m_socketSet, m_socket);
+    return m_isValid = true;
+}
+
+
+void CUDPSocket::Close(void) {
+    if (m_isValid) {
+        m_isValid = false;
+        if (m_socketSet) {
+            SDLNet_FreeSocketSet(m_socketSet);
+            m_socketSet = nullptr;
+        }
+        SDLNet_UDP_Close(m_socket);
+    }
+}
 
 
-bool CUDPSocket::Send(CString message, CString address, uint16_t port) {
+// SDL_net has no batch send, so datagrams are always sent right away. Sending on channel -1 uses the
+// packet's address and saves binding the address to a channel for every datagram.
+bool CUDPSocket::Send(const uint8_t* data, size_t length, CString& address, uint16_t port) {
     if (!m_isValid)
         return false;
-    UDPpacket packet = { Bind(address, port), (Uint8*)message.Buffer(), int (message.Length()), int (message.Size()), 0, m_address };
-    if (m_channel < 0)
+    IPaddress* ip = m_addresses.Resolve(address, port);
+    if (!ip)
         return false;
-    int n = SDLNet_UDP_Send(m_socket, m_channel, &packet);
-    Unbind ();
-    return (n > 0);
+    UDPpacket packet = { -1, (Uint8*) data, int (length), int (length), 0, *ip };
+    return SDLNet_UDP_Send(m_socket, -1, &packet) > 0;
+}
+
+
+bool CUDPSocket::SendBatch(void) {
+    m_isBatching = false;
+    return true;
 }
 
 
-CString CUDPSocket::Receive(CString& address, uint16_t& port) {
+bool CUDPSocket::Receive(CString& data, CString& address, uint16_t& port) {
     if (!m_isValid)
-        return CString ("");
-    if (0 > (m_packet->channel = Bind(m_localAddress, m_localPort)))
-        return CString("");
+        return false;
     int n = SDLNet_UDP_Recv(m_socket, m_packet);
-    Unbind();
     if (n <= 0)
-        return CString("");
+        return false;
     uint8_t* p = (uint8_t*)&m_packet->address.host;
     char s[16];
-    sprintf_s(s, sizeof (s), "%hu.%hu.%hu.%hu", p[0], p[1], p[2], p[3]);
-    address = s;
+    snprintf(s, sizeof (s), "%hu.%hu.%hu.%hu", p[0], p[1], p[2], p[3]);
+    address.Assign(s, strlen(s));
     port = uint16_t(m_packet->address.port);
-    return CString((char*)m_packet->data, m_packet->len);
+    data.Assign((char*)m_packet->data, m_packet->len);
+    return true;
 }
 
 
-CMessage CUDP::Receive(void) {
-    CMessage data;
-    data.m_payload = m_sockets[0].Receive(data.m_address, data.m_port);
-    if (data.m_payload.Find("SMIBAT") == 0)
-        data.m_payload = data.m_payload.Replace("SMIBAT", "", 1);
-    return data;
+bool CUDPSocket::Wait(int timeout) {
+    if ((timeout < 0) || (timeout > MAX_WAIT_TIME))
+        timeout = MAX_WAIT_TIME;
+    if (!(m_isValid && m_socketSet)) {
+        if (timeout)
+            SDL_Delay(timeout);
+        return false;
+    }
+    return SDLNet_CheckSockets(m_socketSet, Uint32(timeout)) > 0;
+}
+
+
+// a waiting thread will return from Wait() after at most MAX_WAIT_TIME ms
+void CUDPSocket::Wakeup(void) {
+}
+
+#endif
+
+
+bool CUDP::Receive(CMessage& message) {
+    message.m_numValues = 0;
+    message.m_result = 0;
+    if (!m_sockets[0]->Receive(message.m_payload, message.m_address, message.m_port)) {
+        message.m_payload.Assign("", 0);
+        return false;
+    }
+    message.m_time = SDL_GetTicks();
+    // strip the "SMIBAT" prefix of text messages in place
+    size_t l = message.m_payload.Length();
+    char* payload = message.m_payload.Buffer();
+    if ((l >= 6) && !memcmp(payload, "SMIBAT", 6)) {
+        memmove(payload, payload + 6, l - 5);   // including the terminating null byte
+        message.m_payload.SetLength(l - 6);
+    }
+    return true;
 }
 
 
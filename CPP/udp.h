@@ -5,48 +5,113 @@
 #include "SDL_net.h"
 #include "cstring.h"
 #include "networkmessage.h"
+#include "networkpacket.h"
+#include "transport.h"
+
+// Linux hosts use their native sockets to receive && send batches of datagrams with a single syscall
+// (recvmmsg/sendmmsg). All other platforms use SDL_net.
+#if defined(__linux__) && !defined(NO_NATIVE_SOCKETS)
+#   define NATIVE_SOCKETS 1
+#   include <sys/socket.h>
+#   include <netinet/in.h>
+#else
+#   define NATIVE_SOCKETS 0
+#endif
+
+#define UDP_BATCH_SIZE      32          // max. number of datagrams received or sent with one syscall
+#define ADDRESS_CACHE_SIZE  64
+#define MAX_WAIT_TIME       100         // [ms] SDL_net sockets cannot be woken up, so waiting for them is limited
+
+// =================================================================================================
+// Resolving a peer's address is expensive, so resolved addresses are cached
+
+class CAddressCache {
+    public:
+        class CEntry {
+            public:
+                CString     m_address;
+                uint16_t    m_port;
+                IPaddress   m_ip;
+
+                CEntry() : m_port(0) {
+                    memset(&m_ip, 0, sizeof(m_ip));
+                }
+        };
+
+        CEntry  m_entries[ADDRESS_CACHE_SIZE];
+        int     m_entryCount;
+        int     m_nextEntry;        // entry to be replaced next when the cache is full
+
+        CAddressCache() : m_entryCount(0), m_nextEntry(0) {}
+
+        // return the resolved address or nullptr if it cannot be resolved
+        IPaddress* Resolve(CString& address, uint16_t port);
+};
 
 // =================================================================================================
 // UDP based networking
 
-class CUDPSocket {
+class CUDPSocket : public CTransport {
     public:
-        CString     m_localAddress;
-        uint16_t    m_localPort;
-        UDPsocket   m_socket;
-        UDPpacket*  m_packet;
-        IPaddress   m_address;
-        int         m_channel;
-        bool        m_isValid;
-
-    private:
-        int Bind (CString& address, uint16_t port);
-
-        inline void Unbind(void) {
-            SDLNet_UDP_Unbind(m_socket, m_channel);
-        }
+        CAddressCache   m_addresses;
+#if NATIVE_SOCKETS
+        class CDatagrams {
+            public:
+                uint8_t         m_data[UDP_BATCH_SIZE][MAX_DATAGRAM_SIZE];
+                sockaddr_in     m_addresses[UDP_BATCH_SIZE];
+                iovec           m_buffers[UDP_BATCH_SIZE];
+                mmsghdr         m_headers[UDP_BATCH_SIZE];
+                int             m_count;
+                int             m_index;    // next received datagram to hand out
+
+                CDatagrams();
+        };
+
+        int             m_socket;
+        int             m_wakeup;           // event fd to interrupt Wait()
+        CDatagrams      m_received;
+        CDatagrams      m_sent;
+#else
+        UDPsocket           m_socket;
+        UDPpacket*          m_packet;
+        SDLNet_SocketSet    m_socketSet;
+#endif
 
     public:
-        CUDPSocket() : m_localAddress(CString("127.0.0.1")), m_localPort(0), m_packet(nullptr), m_channel(0), m_isValid(false) {
-            memset(&m_address, 0, sizeof(m_address));
+#if NATIVE_SOCKETS
+        CUDPSocket() : m_socket(-1), m_wakeup(-1) {}
+#else
+        CUDPSocket() : m_packet(nullptr), m_socketSet(nullptr) {
             memset(&m_socket, 0, sizeof(m_socket));
         }
+#endif
 
         ~CUDPSocket() {
+#if NATIVE_SOCKETS
+            Close();
+#else
             if (m_packet) {
                 SDLNet_FreePacket(m_packet);
                 m_packet = nullptr;
             }
+#endif
         }
 
-        bool Open(CString localAddress, uint16_t localPort);
+        virtual bool Open(CString localAddress, uint16_t localPort);
+
+        virtual void Close(void);
+
+        using CTransport::Send;
+
+        virtual bool Send(const uint8_t* data, size_t length, CString& address, uint16_t port);
 
-        void Close(void);
+        virtual bool SendBatch(void);
 
-        bool Send(CString message, CString address, uint16_t port);
+        virtual bool Receive(CString& data, CString& address, uint16_t& port);
 
+        virtual bool Wait(int timeout);
 
-        CString Receive(CString& address, uint16_t& port);
+        virtual void Wakeup(void);
 
 };
 
@@ -56,30 +121,66 @@ class CUDP {
     public:
 
         CString     m_localAddress;
-        CUDPSocket  m_sockets[2];
+        CTransport* m_sockets[2];       // 0: read, 1: write
 
-        CUDP() : m_localAddress(CString("127.0.0.1")) {}
+        CUDP() : m_localAddress(CString("127.0.0.1")) {
+            m_sockets[0] = new CUDPSocket();
+            m_sockets[1] = new CUDPSocket();
+        }
+
+        ~CUDP() {
+            delete m_sockets[0];
+            delete m_sockets[1];
+        }
 
+        // replace a socket (e.g. by a virtual one, see virtualnetwork.h) before it is opened
+        inline void SetTransport(int type, CTransport* transport) {
+            delete m_sockets[type];
+            m_sockets[type] = transport;
+        }
 
         bool OpenSocket(uint16_t port, int type) {     // 0: read, 1: write
-            return m_sockets[type].Open(m_localAddress, port);
+            return m_sockets[type]->Open(m_localAddress, port);
         }
 
 
         inline uint16_t InPort(void) {
-            return m_sockets[0].m_localPort;
+            return m_sockets[0]->m_localPort;
         }
 
         inline uint16_t OutPort(void) {
-            return m_sockets[1].m_localPort;
+            return m_sockets[1]->m_localPort;
         }
 
         bool Transmit(CString message, CString address, uint16_t port) {
-            return m_sockets[1].Send(CString("SMIBAT") + message, address, port);
+            return m_sockets[1]->Send(CString("SMIBAT") + message, address, port);
+        }
+
+        // binary packets are sent as they are (they carry their own header)
+        bool Transmit(CPacketWriter& packet, CString address, uint16_t port) {
+            return m_sockets[1]->Send(packet.Buffer(), packet.Length(), address, port);
+        }
+
+        // everything transmitted between BeginBatch() && SendBatch() is sent with as few syscalls as possible
+        inline void BeginBatch(void) {
+            m_sockets[1]->BeginBatch();
+        }
+
+        inline bool SendBatch(void) {
+            return m_sockets[1]->SendBatch();
         }
 
 
-        CMessage Receive(void);
+        // receive into a message, reusing its buffers (no allocations once they are large enough)
+        bool Receive(CMessage& message);
+
+        inline bool WaitForMessages(int timeout) {
+            return m_sockets[0]->Wait(timeout);
+        }
+
+        inline void StopWaiting(void) {
+            m_sockets[0]->Wakeup();
+        }
 
 };
 
@@ -0,0 +1,92 @@
+#include <stdio.h>
+
+#include "SDL.h"
+#include "SDL_net.h"
+#include "udp.h"
+
+// =================================================================================================
+// Sends more datagrams than fit into one batch (see UDP_BATCH_SIZE) through a loopback socket, receives them && sends
+// a reply to the address && port they have been received from. Built once with the native sockets && once with
+// SDL_net (NO_NATIVE_SOCKETS), which have to agree on the byte order of received ports (network byte order).
+
+#define DATAGRAM_COUNT  (3 * UDP_BATCH_SIZE + 5)
+#define TIMEOUT         2000    // [ms]
+#define FIRST_PORT      29100
+
+static bool OpenSocket(CUDPSocket& socket, uint16_t& port) {
+    for (; port < FIRST_PORT + 100; port++)
+        if (socket.Open(CString("127.0.0.2"), port))  // any local address but 127.0.0.1, the socket binds to all of them
+            return true;
+    return false;
+}
+
+
+static bool ReceiveDatagram(CUDPSocket& socket, CString& data, CString& address, uint16_t& port) {
+    uint32_t t = SDL_GetTicks();
+    while (!socket.Receive(data, address, port)) {
+        if (SDL_GetTicks() - t > TIMEOUT)
+            return false;
+        socket.Wait(100);
+    }
+    return true;
+}
+
+
+int main(int argc, char* argv[]) {
+    if ((SDL_Init(SDL_INIT_TIMER) != 0) || (SDLNet_Init() != 0)) {
+        fprintf(stderr, "can't initialize networking\n");
+        return 1;
+    }
+    CUDPSocket receiver, sender;
+    uint16_t receiverPort = FIRST_PORT;
+    bool isOpen = OpenSocket(receiver, receiverPort);
+    uint16_t senderPort = receiverPort + 1;
+    if (!isOpen || !OpenSocket(sender, senderPort)) {
+        fprintf(stderr, "can't open the sockets\n");
+        return 1;
+    }
+    CString loopback("127.0.0.1");
+    sender.BeginBatch();
+    for (int i = 0; i < DATAGRAM_COUNT; i++)
+        if (!sender.Send(CString(i), loopback, receiverPort)) {
+            fprintf(stderr, "datagram %d hasn't been sent\n", i);
+            return 1;
+        }
+    if (!sender.SendBatch()) {
+        fprintf(stderr, "the batch hasn't been sent\n");
+        return 1;
+    }
+    CString data, address;
+    uint16_t port;
+    for (int i = 0; i < DATAGRAM_COUNT; i++) {
+        if (!ReceiveDatagram(receiver, data, address, port)) {
+            fprintf(stderr, "only %d of %d datagrams received\n", i, DATAGRAM_COUNT);
+            return 1;
+        }
+        if (int(data) != i) {
+            fprintf(stderr, "datagram %d: received '%s'\n", i, data.Buffer());
+            return 1;
+        }
+        if (!(address == loopback) || (port != SDL_SwapBE16(senderPort))) {
+            fprintf(stderr, "datagram %d: received from %s:%d instead of %s:%d\n", i, address.Buffer(), SDL_SwapBE16(port), loopback.Buffer(), senderPort);
+            return 1;
+        }
+    }
+    // reply to the sender the way SDL_net addresses it: ports are sent to in host byte order
+    if (!receiver.Send(CString("reply"), address, SDL_SwapBE16(port))) {
+        fprintf(stderr, "the reply hasn't been sent\n");
+        return 1;
+    }
+    if (!ReceiveDatagram(sender, data, address, port) || !(data == "reply") || (port != SDL_SwapBE16(receiverPort))) {
+        fprintf(stderr, "the reply hasn't arrived\n");
+        return 1;
+    }
+    receiver.Close();
+    sender.Close();
+    SDLNet_Quit();
+    SDL_Quit();
+    printf("%d datagrams in batches of %d and a reply sent and received (%s)\n", DATAGRAM_COUNT, UDP_BATCH_SIZE, NATIVE_SOCKETS ? "native sockets" : "SDL_net");
+    return 0;
+}
+
+// =================================================================================================
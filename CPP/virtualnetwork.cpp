@@ -0,0 +1,305 @@
+#include "SDL.h"
+#include "virtualnetwork.h"
+
+// =================================================================================================
+
+void CLinkModel::Seed(uint32_t seed) {
+    seed ^= seed >> 16;
+    seed *= 0x7feb352du;
+    seed ^= seed >> 15;
+    seed *= 0x846ca68bu;
+    seed ^= seed >> 16;
+    m_random = seed ? seed : 1;
+}
+
+
+// xorshift32: fast && the same sequence on every platform
+float CLinkModel::Random(void) {
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return float(m_random >> 8) / 16777216.0f;
+}
+
+
+int CLinkModel::Schedule(size_t length, uint32_t now, uint32_t arrivalTimes[2]) {
+    if ((m_params.m_loss > 0.0f) && (Random() < m_params.m_loss))
+        return 0;
+    double departure = double(now);
+    if (m_params.m_bandwidth > 0) {
+        if (m_busyUntil > departure + MAX_LINK_BACKLOG)    // the link's queue is full
+            return 0;
+        if (m_busyUntil > departure)
+            departure = m_busyUntil;
+        departure += double(length) * 1000.0 / double(m_params.m_bandwidth);
+        m_busyUntil = departure;
+    }
+    float delay = float(m_params.m_latency);
+    if (m_params.m_jitter > 0)
+        delay += Random() * float(m_params.m_jitter);
+    if ((m_params.m_reordering > 0.0f) && (Random() < m_params.m_reordering))
+        delay += float(m_params.m_latency + m_params.m_jitter + 10);
+    arrivalTimes[0] = uint32_t(departure + double(delay));
+    if ((m_params.m_duplication > 0.0f) && (Random() < m_params.m_duplication)) {
+        arrivalTimes[1] = arrivalTimes[0] + 1 + uint32_t(Random() * float(m_params.m_jitter));
+        return 2;
+    }
+    return 1;
+}
+
+// =================================================================================================
+
+void CImpairedTransport::SetLink(CString address, uint16_t port, CLinkParams params) {
+    FindLink(address, port).m_model.m_params = params;
+}
+
+
+// every link gets a seed of its own, so that adding a link doesn't change what happens on the others
+CImpairedTransport::CLink& CImpairedTransport::FindLink(CString& address, uint16_t port) {
+    for (auto [i, link] : m_links)
+        if ((link.m_port == port) && (link.m_address == address))
+            return link;
+    CLink link;
+    link.m_address = address;
+    link.m_port = port;
+    link.m_model = CLinkModel(m_params, m_seed + uint32_t(m_links.Length()) * 2654435761u);
+    m_links.Append(link);
+    return m_links[m_links.Length() - 1];
+}
+
+
+bool CImpairedTransport::Open(CString localAddress, uint16_t localPort) {
+    m_localAddress = localAddress;
+    m_localPort = localPort;
+    return m_isValid = m_transport->Open(localAddress, localPort);
+}
+
+
+void CImpairedTransport::Close(void) {
+    m_transport->Close();
+    m_queue.Destroy();
+    m_isValid = false;
+}
+
+
+void CImpairedTransport::Collect(uint32_t now) {
+    while (m_transport->Receive(m_data, m_address, m_port)) {
+        uint32_t arrivalTimes[2];
+        int copies = FindLink(m_address, m_port).m_model.Schedule(m_data.Length(), now, arrivalTimes);
+        for (int c = 0; c < copies; c++) {
+            CDatagram datagram;
+            datagram.m_data = m_data;
+            datagram.m_address = m_address;
+            datagram.m_port = m_port;
+            datagram.m_arrivalTime = arrivalTimes[c];
+            int i = int(m_queue.Length());
+            while ((i > 0) && (int(m_queue[i - 1].m_arrivalTime - datagram.m_arrivalTime) > 0))
+                i--;
+            if (i == int(m_queue.Length()))    // CList::Insert() counts indices >= Length() from the front
+                m_queue.Append(datagram);
+            else
+                m_queue.Insert(i, datagram);
+        }
+    }
+}
+
+
+bool CImpairedTransport::Receive(CString& data, CString& address, uint16_t& port) {
+    uint32_t now = SDL_GetTicks();
+    Collect(now);
+    if (!HaveArrivals(now))
+        return false;
+    CDatagram datagram = m_queue.Pop(0);
+    data = datagram.m_data;
+    address = datagram.m_address;
+    port = datagram.m_port;
+    return true;
+}
+
+
+// datagrams on their way have arrived on the wrapped transport already, so instead of the transport's data, their
+// arrival times are waited for
+bool CImpairedTransport::Wait(int timeout) {
+    uint32_t start = SDL_GetTicks();
+    for (;;) {
+        uint32_t now = SDL_GetTicks();
+        Collect(now);
+        if (HaveArrivals(now))
+            return true;
+        if (m_wakeup.exchange(false))
+            return false;
+        int wait = (timeout < 0) ? -1 : timeout - int(now - start);
+        if ((timeout >= 0) && (wait <= 0))
+            return false;
+        if (!m_queue.Empty()) {
+            int due = int(m_queue[0].m_arrivalTime - now);
+            if ((wait < 0) || (due < wait))
+                wait = due;
+        }
+        m_transport->Wait(wait);
+    }
+}
+
+
+void CImpairedTransport::Wakeup(void) {
+    m_wakeup = true;
+    m_transport->Wakeup();
+}
+
+// =================================================================================================
+
+CVirtualNetwork::CVirtualNetwork() {
+    m_lock = SDL_CreateMutex();
+}
+
+
+CVirtualNetwork::~CVirtualNetwork() {
+    if (m_lock) {
+        SDL_DestroyMutex(m_lock);
+        m_lock = nullptr;
+    }
+}
+
+
+CVirtualNetwork* CVirtualNetwork::Instance(void) {
+    static CVirtualNetwork network;
+    return &network;
+}
+
+
+bool CVirtualNetwork::Register(CVirtualSocket* socket) {
+    SDL_mutexP(m_lock);
+    bool inUse = false;
+    for (auto [i, s] : m_sockets)
+        if ((s->m_localPort == socket->m_localPort) && (s->m_localAddress == socket->m_localAddress))
+            inUse = true;
+    if (!inUse)
+        m_sockets.Append(socket);
+    SDL_mutexV(m_lock);
+    return !inUse;
+}
+
+
+void CVirtualNetwork::Unregister(CVirtualSocket* socket) {
+    SDL_mutexP(m_lock);
+    for (auto [i, s] : m_sockets)
+        if (s == socket) {
+            m_sockets.Pop(int(i));
+            break;
+        }
+    SDL_mutexV(m_lock);
+}
+
+
+void CVirtualNetwork::Deliver(CVirtualSocket* sender, const uint8_t* data, size_t length, CString& address, uint16_t port) {
+    SDL_mutexP(m_lock);
+    for (auto [i, s] : m_sockets)
+        if ((s->m_localPort == port) && (s->m_localAddress == address)) {
+            s->Push(data, length, sender->m_localAddress, sender->m_localPort);
+            break;
+        }
+    SDL_mutexV(m_lock);
+}
+
+// =================================================================================================
+
+CVirtualSocket::CVirtualSocket() : m_network(nullptr), m_wakeup(false) {
+    m_lock = SDL_CreateMutex();
+}
+
+
+CVirtualSocket::~CVirtualSocket() {
+    Close();
+    if (m_lock) {
+        SDL_DestroyMutex(m_lock);
+        m_lock = nullptr;
+    }
+}
+
+
+// unlike real sockets, virtual ones can be opened for any address
+bool CVirtualSocket::Open(CString localAddress, uint16_t localPort) {
+    m_localAddress = localAddress;
+    m_localPort = localPort;
+    m_network = CVirtualNetwork::Instance();
+    if (!m_network->Register(this)) {
+        fprintf(stderr, "Virtual network: %s:%d is already in use\n", localAddress.Buffer(), int(localPort));
+        m_network = nullptr;
+        return false;
+    }
+    return m_isValid = true;
+}
+
+
+void CVirtualSocket::Close(void) {
+    if (m_isValid) {
+        m_isValid = false;
+        m_network->Unregister(this);
+        m_network = nullptr;
+    }
+}
+
+
+// ports are passed on as they have been opened (real sockets report the sender's port in network byte order). That's
+// fine as long as all peers are connected to the virtual network
+bool CVirtualSocket::Send(const uint8_t* data, size_t length, CString& address, uint16_t port) {
+    if (!m_isValid || (length > MAX_DATAGRAM_SIZE))
+        return false;
+    m_network->Deliver(this, data, length, address, port);
+    return true;
+}
+
+
+void CVirtualSocket::Push(const uint8_t* data, size_t length, CString& address, uint16_t port) {
+    CDatagram datagram;
+    datagram.m_data = CString((char*) data, int(length));
+    datagram.m_address = address;
+    datagram.m_port = port;
+    SDL_mutexP(m_lock);
+    m_inbox.Append(datagram);
+    SDL_mutexV(m_lock);
+}
+
+
+bool CVirtualSocket::Receive(CString& data, CString& address, uint16_t& port) {
+    SDL_mutexP(m_lock);
+    bool haveData = !m_inbox.Empty();
+    if (haveData) {
+        CDatagram datagram = m_inbox.Pop(0);
+        data = datagram.m_data;
+        address = datagram.m_address;
+        port = datagram.m_port;
+    }
+    SDL_mutexV(m_lock);
+    return haveData;
+}
+
+
+bool CVirtualSocket::HaveData(void) {
+    SDL_mutexP(m_lock);
+    bool haveData = !m_inbox.Empty();
+    SDL_mutexV(m_lock);
+    return haveData;
+}
+
+
+// there is nothing to block on, so the inbox is polled every millisecond
+bool CVirtualSocket::Wait(int timeout) {
+    uint32_t start = SDL_GetTicks();
+    for (;;) {
+        if (HaveData())
+            return true;
+        if (m_wakeup.exchange(false))
+            return false;
+        if ((timeout >= 0) && (int(SDL_GetTicks() - start) >= timeout))
+            return false;
+        SDL_Delay(1);
+    }
+}
+
+
+void CVirtualSocket::Wakeup(void) {
+    m_wakeup = true;
+}
+
+// =================================================================================================
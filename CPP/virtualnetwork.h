@@ -0,0 +1,210 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#include "SDL_mutex.h"
+#include "cstring.h"
+#include "clist.h"
+#include "transport.h"
+
+#define MAX_LINK_BACKLOG    1000    // [ms] datagrams that would have to queue longer for a bandwidth capped link are dropped
+
+// =================================================================================================
+// Network impairment simulation
+//
+// CImpairedTransport sits between CUDP && the transport actually receiving the datagrams && passes every datagram on
+// with the latency, jitter, loss, duplication, reordering && bandwidth cap of the link it came in on (see CLinkModel).
+// Links are told apart by the sender's address && port, && each has parameters of its own (default: those the
+// transport has been created with). This way, the game can be run on a single box against several other instances
+// with different link qualities, && a benchmark can be repeated with the exact same impairments (seeded random numbers).
+//
+// CVirtualNetwork connects CVirtualSockets in memory, so that several endpoints of a process can exchange datagrams
+// without any sockets && without the operating system's network stack (e.g. loopback) getting in the way.
+// Virtual sockets are identified by the address && port they have been opened with. Datagrams to addresses no virtual
+// socket has been opened for are dropped silently.
+
+class CLinkParams {
+    public:
+        int     m_latency;      // [ms] one way
+        int     m_jitter;       // [ms] random additional delay (0 .. m_jitter)
+        float   m_loss;         // fraction of datagrams lost
+        float   m_duplication;  // fraction of datagrams delivered twice
+        float   m_reordering;   // fraction of datagrams held back long enough to be overtaken by the following ones
+        int     m_bandwidth;    // [bytes/s] (0: unlimited)
+
+        CLinkParams() : m_latency(0), m_jitter(0), m_loss(0.0f), m_duplication(0.0f), m_reordering(0.0f), m_bandwidth(0) {}
+
+        inline bool IsPerfect(void) {
+            return (m_latency <= 0) && (m_jitter <= 0) && (m_loss <= 0.0f) && (m_duplication <= 0.0f) && (m_reordering <= 0.0f) && (m_bandwidth <= 0);
+        }
+};
+
+// =================================================================================================
+// Fate of the datagrams passing a single link
+
+class CLinkModel {
+    public:
+        CLinkParams m_params;
+        uint32_t    m_random;
+        double      m_busyUntil;    // [ms] the link is busy with earlier datagrams until then (bandwidth cap)
+
+        CLinkModel(CLinkParams params = CLinkParams(), uint32_t seed = 1) : m_params(params), m_busyUntil(0.0) {
+            Seed(seed);
+        }
+
+        // compute the times the copies of a datagram of length bytes sent at now arrive. Returns the number of copies
+        // arriving (0: lost, 2: duplicated)
+        int Schedule(size_t length, uint32_t now, uint32_t arrivalTimes[2]);
+
+    private:
+        // xorshift's first numbers are tiny for small seeds, so the seed is scrambled first
+        void Seed(uint32_t seed);
+
+        // uniformly distributed in [0, 1)
+        float Random(void);
+};
+
+// =================================================================================================
+
+class CDatagram {
+    public:
+        CString     m_data;
+        CString     m_address;      // sender
+        uint16_t    m_port;
+        uint32_t    m_arrivalTime;
+
+        CDatagram() : m_port(0), m_arrivalTime(0) {}
+};
+
+// =================================================================================================
+// Pass the datagrams another transport receives on through simulated links
+
+class CImpairedTransport : public CTransport {
+    public:
+        class CLink {
+            public:
+                CString     m_address;
+                uint16_t    m_port;
+                CLinkModel  m_model;
+
+                CLink() : m_port(0) {}
+        };
+
+        CTransport*         m_transport;
+        CLinkParams         m_params;       // of links without parameters of their own
+        uint32_t            m_seed;
+        CList<CLink>        m_links;
+        CList<CDatagram>    m_queue;        // datagrams on their way, ordered by arrival time
+        std::atomic<bool>   m_wakeup;
+        CString             m_data;         // receive buffers
+        CString             m_address;
+        uint16_t            m_port;
+
+        // takes ownership of transport
+        CImpairedTransport(CTransport* transport, CLinkParams params, uint32_t seed = 1)
+            : m_transport(transport), m_params(params), m_seed(seed), m_wakeup(false), m_port(0) {}
+
+        ~CImpairedTransport() {
+            delete m_transport;
+        }
+
+        // set the parameters of the link from address:port
+        void SetLink(CString address, uint16_t port, CLinkParams params);
+
+        virtual bool Open(CString localAddress, uint16_t localPort);
+
+        virtual void Close(void);
+
+        using CTransport::Send;
+
+        virtual bool Send(const uint8_t* data, size_t length, CString& address, uint16_t port) {
+            return m_transport->Send(data, length, address, port);
+        }
+
+        virtual void BeginBatch(void) {
+            m_transport->BeginBatch();
+        }
+
+        virtual bool SendBatch(void) {
+            return m_transport->SendBatch();
+        }
+
+        virtual bool Receive(CString& data, CString& address, uint16_t& port);
+
+        virtual bool Wait(int timeout);
+
+        virtual void Wakeup(void);
+
+    private:
+        CLink& FindLink(CString& address, uint16_t port);
+
+        // move everything the transport has received to the queue
+        void Collect(uint32_t now);
+
+        inline bool HaveArrivals(uint32_t now) {
+            return !m_queue.Empty() && (int(now - m_queue[0].m_arrivalTime) >= 0);
+        }
+};
+
+// =================================================================================================
+// In-memory network
+
+class CVirtualSocket;
+
+class CVirtualNetwork {
+    public:
+        SDL_mutex*              m_lock;
+        CList<CVirtualSocket*>  m_sockets;
+
+        CVirtualNetwork();
+
+        ~CVirtualNetwork();
+
+        // the network all virtual sockets of the process are connected to
+        static CVirtualNetwork* Instance(void);
+
+        // returns false if address:port is already in use
+        bool Register(CVirtualSocket* socket);
+
+        void Unregister(CVirtualSocket* socket);
+
+        // pass a datagram from sender to the virtual socket opened with address && port
+        void Deliver(CVirtualSocket* sender, const uint8_t* data, size_t length, CString& address, uint16_t port);
+};
+
+// =================================================================================================
+
+class CVirtualSocket : public CTransport {
+    public:
+        CVirtualNetwork*    m_network;
+        SDL_mutex*          m_lock;         // senders may be running on other threads
+        CList<CDatagram>    m_inbox;
+        std::atomic<bool>   m_wakeup;
+
+        CVirtualSocket();
+
+        ~CVirtualSocket();
+
+        virtual bool Open(CString localAddress, uint16_t localPort);
+
+        virtual void Close(void);
+
+        using CTransport::Send;
+
+        virtual bool Send(const uint8_t* data, size_t length, CString& address, uint16_t port);
+
+        virtual bool Receive(CString& data, CString& address, uint16_t& port);
+
+        virtual bool Wait(int timeout);
+
+        virtual void Wakeup(void);
+
+        // called by the network
+        void Push(const uint8_t* data, size_t length, CString& address, uint16_t port);
+
+    private:
+        bool HaveData(void);
+};
+
+// =================================================================================================
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "SDL.h"
+#include "virtualnetwork.h"
+
+// =================================================================================================
+// Sends datagrams from several virtual sockets to one behind a CImpairedTransport && checks that every link delivers,
+// loses, duplicates && delays them the way its parameters say. The link model's random numbers are seeded, so the
+// outcome is the same on every run; the tolerances only leave room for the timer.
+
+#define RECEIVER_ADDRESS    "10.0.0.1"
+#define RECEIVER_PORT       9000
+#define LATENCY             100     // [ms]
+#define LOSS                0.25f
+#define BANDWIDTH           10000   // [bytes/s]
+#define TIMEOUT             2000    // [ms]
+#define MAX_DATAGRAMS       1000
+
+class CReception {
+    public:
+        int         m_count;
+        int         m_duplicates;
+        bool        m_isOrdered;
+        uint32_t    m_firstArrival;     // [ms] after sending
+        uint32_t    m_lastArrival;
+
+        bool        m_received[MAX_DATAGRAMS];
+
+        CReception() : m_count(0), m_duplicates(0), m_isOrdered(true), m_firstArrival(0), m_lastArrival(0) {
+            memset(m_received, 0, sizeof(m_received));
+        }
+};
+
+
+// open a virtual socket for address:RECEIVER_PORT, send count datagrams of length bytes to the receiver && receive
+// whatever arrives until no datagram is on its way anymore
+static bool Transmit(CImpairedTransport& receiver, const char* address, CLinkParams params, int count, int length, CReception& reception) {
+    CVirtualSocket sender;
+    if (!sender.Open(CString(address), RECEIVER_PORT)) {
+        fprintf(stderr, "can't open %s:%d\n", address, RECEIVER_PORT);
+        return false;
+    }
+    receiver.SetLink(CString(address), RECEIVER_PORT, params);
+    CString receiverAddress(RECEIVER_ADDRESS);
+    uint32_t start = SDL_GetTicks();
+    for (int i = 0; i < count; i++) {
+        CString message(i);
+        while (message.Length() < length)
+            message += CString(" ");
+        if (!sender.Send(message, receiverAddress, RECEIVER_PORT)) {
+            fprintf(stderr, "%s: datagram %d hasn't been sent\n", address, i);
+            return false;
+        }
+    }
+    CString data, senderAddress;
+    uint16_t port;
+    int last = -1;
+    for (;;) {
+        if (!receiver.Receive(data, senderAddress, port)) {
+            if (receiver.m_queue.Empty())   // virtual sockets deliver at once, so nothing else is on its way
+                break;
+            receiver.Wait(TIMEOUT);
+            continue;
+        }
+        uint32_t t = SDL_GetTicks() - start;
+        if (!(senderAddress == CString(address)) || (port != RECEIVER_PORT)) {
+            fprintf(stderr, "%s: received a datagram from %s:%d\n", address, senderAddress.Buffer(), int(port));
+            return false;
+        }
+        int i = int(data);
+        if ((i < 0) || (i >= count)) {
+            fprintf(stderr, "%s: received '%s'\n", address, data.Buffer());
+            return false;
+        }
+        if (reception.m_received[i])   // duplicates of a datagram arrive after it, the ones of a burst after the burst
+            reception.m_duplicates++;
+        else {
+            if (i < last)
+                reception.m_isOrdered = false;
+            reception.m_received[i] = true;
+            last = i;
+        }
+        if (reception.m_count++ == 0)
+            reception.m_firstArrival = t;
+        reception.m_lastArrival = t;
+    }
+    sender.Close();
+    return true;
+}
+
+
+static bool Check(bool condition, const char* link, const char* error) {
+    if (!condition)
+        fprintf(stderr, "%s link: %s\n", link, error);
+    return condition;
+}
+
+
+int main(int argc, char* argv[]) {
+    if (SDL_Init(SDL_INIT_TIMER) != 0) {
+        fprintf(stderr, "can't initialize the timer\n");
+        return 1;
+    }
+    CImpairedTransport receiver(new CVirtualSocket(), CLinkParams(), 1);
+    if (!receiver.Open(CString(RECEIVER_ADDRESS), RECEIVER_PORT)) {
+        fprintf(stderr, "can't open the receiver\n");
+        return 1;
+    }
+    bool ok = true;
+    CReception reception;
+
+    // links without parameters of their own are perfect here
+    ok &= Transmit(receiver, "10.0.0.2", CLinkParams(), 100, 16, reception);
+    ok &= Check(reception.m_count == 100, "perfect", "datagrams missing");
+    ok &= Check(reception.m_isOrdered && (reception.m_duplicates == 0), "perfect", "datagrams reordered or duplicated");
+    ok &= Check(reception.m_lastArrival < LATENCY / 2, "perfect", "datagrams delayed");
+
+    CLinkParams delayed;
+    delayed.m_latency = LATENCY;
+    reception = CReception();
+    ok &= Transmit(receiver, "10.0.0.3", delayed, 100, 16, reception);
+    ok &= Check(reception.m_count == 100, "delayed", "datagrams missing");
+    ok &= Check(reception.m_isOrdered && (reception.m_duplicates == 0), "delayed", "datagrams reordered or duplicated");
+    ok &= Check(reception.m_firstArrival >= LATENCY, "delayed", "datagrams arrived too early");
+    ok &= Check(reception.m_lastArrival < 2 * LATENCY, "delayed", "datagrams arrived too late");
+
+    CLinkParams lossy;
+    lossy.m_loss = LOSS;
+    reception = CReception();
+    ok &= Transmit(receiver, "10.0.0.4", lossy, 1000, 16, reception);
+    ok &= Check((reception.m_count > 1000 - int(1000 * LOSS) - 50) && (reception.m_count < 1000 - int(1000 * LOSS) + 50), "lossy", "wrong number of datagrams lost");
+    ok &= Check(reception.m_isOrdered && (reception.m_duplicates == 0), "lossy", "datagrams reordered or duplicated");
+
+    CLinkParams duplicating;
+    duplicating.m_duplication = 1.0f;
+    reception = CReception();
+    ok &= Transmit(receiver, "10.0.0.5", duplicating, 100, 16, reception);
+    ok &= Check((reception.m_count == 200) && (reception.m_duplicates == 100), "duplicating", "datagrams not delivered twice");
+
+    // 10 datagrams of 100 bytes take 100 ms at 10000 bytes/s
+    CLinkParams narrow;
+    narrow.m_bandwidth = BANDWIDTH;
+    reception = CReception();
+    ok &= Transmit(receiver, "10.0.0.6", narrow, 10, 100, reception);
+    ok &= Check(reception.m_count == 10, "narrow", "datagrams missing");
+    ok &= Check(reception.m_isOrdered, "narrow", "datagrams reordered");
+    ok &= Check((reception.m_lastArrival >= 10 * 100 * 1000 / BANDWIDTH - 1) && (reception.m_lastArrival < 2 * 10 * 100 * 1000 / BANDWIDTH), "narrow", "bandwidth not enforced");
+
+    receiver.Close();
+    SDL_Quit();
+    if (!ok)
+        return 1;
+    printf("perfect, delayed, lossy, duplicating and bandwidth capped links behave as configured\n");
+    return 0;
+}
+
+// =================================================================================================